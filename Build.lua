@@ -34,6 +34,8 @@ group ""
 group "Game"
    include "Game/Build-GameClient.lua"
    include "Game/Build-GameServer.lua"
+   include "Game/Build-LoadTest.lua"
+   include "Game/Build-ReplayRunner.lua"
 group ""
 
 -- Linux build stub (Windows-only: triggers WSL2 build from Visual Studio)
@@ -6,6 +6,7 @@
 
 #include "Client-Server/OnlineClient.hpp"  // Include for RunClient
 #include "Client-Server/OfflineClient.hpp"  // Include for RunClient
+#include "netcode/udp_transport.hpp"
 
 #include "game/asteroids.hpp"        // Include for game logic
 #include "game/menu.hpp"
@@ -33,7 +34,24 @@ int main(int argc, char** argv) {
 
 
 
-	engine.RegisterClient(1, new OnlineClient(std::move(gameLogic), std::move(gameRenderer),"online_level.bin"));
+	OnlineClient* onlineClient = new OnlineClient(std::move(gameLogic), std::move(gameRenderer), "online_level.bin");
+
+	// Match to join on a server hosting several, state updates to ask for and
+	// the rollback depth input delay aims for
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--match") onlineClient->SetMatchId(argv[i + 1]);
+		if (std::string(argv[i]) == "--snapshot-rate") onlineClient->SetSnapshotRate(std::atoi(argv[i + 1]));
+		if (std::string(argv[i]) == "--target-rollback") onlineClient->SetTargetRollbackFrames(std::atoi(argv[i + 1]));
+	}
+
+#ifdef __linux__
+	// Server started with --udp
+	for (int i = 1; i < argc; ++i) {
+		if (std::string(argv[i]) == "--udp") onlineClient->SetTransport(std::make_shared<UdpTransport>());
+	}
+#endif
+
+	engine.RegisterClient(1, onlineClient);
 
 	std::unique_ptr<IGameLogic> menuLogic = std::make_unique<StartScreenGame>();
 	std::unique_ptr<IGameRenderer> menuRenderer = std::make_unique<StartScreenGameRenderer>();
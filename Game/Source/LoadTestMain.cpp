@@ -0,0 +1,214 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+#include "Client-Server/MatchHost.hpp"
+#include "Client-Server/BotClient.hpp"
+#include "netcode/loopback_transport.hpp"
+#include "netcode/udp_transport.hpp"
+#include "game/asteroids.hpp"
+
+#include "Utils/Debug/Debug.hpp"
+
+void PrintHelp() {
+    std::cout << "Usage:\n"
+        << "  --port <port>              Port of the in-process server (default: 12345).\n"
+        << "  --bots <count>             Headless clients to connect (default: 30).\n"
+        << "  --players <count>          Bots per match (default: 3).\n"
+        << "  --seconds <count>          Length of the run once the bots are in (default: 60).\n"
+        << "  --workers <count>          Threads ticking matches (default: one per core).\n"
+        << "  --tickrate <hz>            Server ticks per second (default: 30).\n"
+        << "  --snapshot-rate <hz>       State updates per second each bot asks for (default: every tick).\n"
+        << "  --delta-budget <bytes>     Cap on the deltas in each update to a bot (default: no cap).\n"
+        << "  --interest-radius <units>  Only send a bot what is this close to it (default: everything).\n"
+        << "  --target-rollback <frames> Rollback depth bots delay their inputs to stay within, -1 for no delay (default: 4).\n"
+        << "  --record <path>            Record every match to a replay for ReplayRunner, one file per match.\n"
+        << "  --loopback                 Connect in-process instead of over sockets.\n"
+        << "  --udp                      Use the raw UDP transport instead of GameNetworkingSockets (Linux).\n"
+        << "  --latency <ms>             Loopback one-way latency (default: 0).\n"
+        << "  --jitter <ms>              Loopback latency jitter (default: 0).\n"
+        << "  --loss <percent>           Loopback packet loss (default: 0).\n"
+        << "  --help                     Show this help message.\n"
+        << "\nExample:\n"
+        << "  Soak 300 bots in 100 matches for ten minutes:\n"
+        << "    ./LoadTest --bots 300 --players 3 --seconds 600\n"
+        << "  Same match on a simulated 50 ms, 2% loss link:\n"
+        << "    ./LoadTest --bots 3 --loopback --latency 50 --jitter 10 --loss 2\n";
+}
+
+int main(int argc, char** argv) {
+
+    uint16_t port = 12345;
+    size_t botCount = 30;
+    size_t playersPerMatch = 3;
+    int seconds = 60;
+    size_t workers = 0;
+    bool loopback = false;
+    bool udp = false;
+    int tickRate = DEFAULT_TICKS_PER_SECOND;
+    int snapshotRate = 0;
+    int deltaBudget = 0;
+    float interestRadius = 0.0f;
+    int targetRollback = TARGET_ROLLBACK_FRAMES;
+    std::string replayPath;
+    LoopbackLinkConfig link;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--help") {
+            PrintHelp();
+            return 0;
+        }
+
+        if (a == "--port" && i + 1 < argc) port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        if (a == "--bots" && i + 1 < argc) botCount = static_cast<size_t>(std::atoi(argv[++i]));
+        if (a == "--players" && i + 1 < argc) playersPerMatch = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        if (a == "--seconds" && i + 1 < argc) seconds = std::atoi(argv[++i]);
+        if (a == "--workers" && i + 1 < argc) workers = static_cast<size_t>(std::atoi(argv[++i]));
+        if (a == "--loopback") loopback = true;
+        if (a == "--udp") udp = true;
+        if (a == "--tickrate" && i + 1 < argc) tickRate = std::atoi(argv[++i]);
+        if (a == "--snapshot-rate" && i + 1 < argc) snapshotRate = std::atoi(argv[++i]);
+        if (a == "--delta-budget" && i + 1 < argc) deltaBudget = std::atoi(argv[++i]);
+        if (a == "--interest-radius" && i + 1 < argc) interestRadius = static_cast<float>(std::atof(argv[++i]));
+        if (a == "--target-rollback" && i + 1 < argc) targetRollback = std::atoi(argv[++i]);
+        if (a == "--record" && i + 1 < argc) replayPath = argv[++i];
+        if (a == "--latency" && i + 1 < argc) link.latencyMs = std::atoi(argv[++i]);
+        if (a == "--jitter" && i + 1 < argc) link.jitterMs = std::atoi(argv[++i]);
+        if (a == "--loss" && i + 1 < argc) link.lossPercent = static_cast<float>(std::atof(argv[++i]));
+    }
+
+    // Per-bot logging goes to the log file only; the report goes to stdout
+    Debug::Initialize("LoadTest", false);
+
+    auto tickStats = std::make_shared<TickStats>();
+
+    ServerConfig config(port);
+    config.minPlayers = playersPerMatch;
+    config.maxPlayers = playersPerMatch;
+    config.stopOnBelowMin = false;
+    config.tickStats = tickStats;
+    config.ticksPerSecond = tickRate;
+    config.deltaBudgetBytes = deltaBudget;
+    config.interestRadius = interestRadius;
+    config.replayPath = replayPath;
+
+    MatchHostConfig hostConfig(port);
+    hostConfig.maxMatches = (botCount + playersPerMatch - 1) / playersPerMatch;
+    hostConfig.workerThreads = workers;
+    hostConfig.matchConfig = config;
+
+    MatchHost host([]() { return std::make_unique<AsteroidShooterGame>(); }, hostConfig);
+    if (loopback) {
+        host.SetTransport(std::make_shared<LoopbackTransport>(link));
+    }
+#ifdef __linux__
+    else if (udp) {
+        host.SetTransport(std::make_shared<UdpTransport>());
+    }
+#endif
+    std::thread hostThread([&host]() { host.Run(); });
+
+    // Let the host open its listen socket before the first bot connects
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    std::atomic<bool> running(true);
+    std::atomic<size_t> failed(0);
+    std::vector<BotClient::Stats> stats(botCount);
+    std::vector<std::thread> bots;
+
+    for (size_t i = 0; i < botCount; i++) {
+        bots.emplace_back([&, i]() {
+            BotConfig botConfig(port);
+            botConfig.clientId = "bot_" + std::to_string(i);
+            botConfig.matchId = "match_" + std::to_string(i / playersPerMatch);
+            botConfig.seed = static_cast<uint32_t>(i + 1);
+            botConfig.snapshotsPerSecond = snapshotRate;
+            botConfig.targetRollbackFrames = targetRollback;
+
+            BotClient bot(std::make_unique<AsteroidShooterGame>(), botConfig);
+            if (loopback) {
+                LoopbackLinkConfig botLink = link;
+                botLink.seed = botConfig.seed;
+                bot.SetTransport(std::make_shared<LoopbackTransport>(botLink));
+            }
+#ifdef __linux__
+            else if (udp) {
+                bot.SetTransport(std::make_shared<UdpTransport>());
+            }
+#endif
+            if (bot.Connect() != CONN_SUCCESS) {
+                failed++;
+                return;
+            }
+            bot.Run(running);
+            stats[i] = bot.GetStats();
+            });
+    }
+
+    std::cout << "Running " << botCount << " bots in " << hostConfig.maxMatches
+        << " matches for " << seconds << " s...\n";
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    running.store(false);
+    for (auto& bot : bots) {
+        bot.join();
+    }
+    host.Stop();
+    hostThread.join();
+
+    BotClient::Stats total;
+    size_t played = 0;
+    double botSeconds = 0.0;
+    for (const BotClient::Stats& s : stats) {
+        if (s.ticks == 0) {
+            continue;
+        }
+        played++;
+        total.bytesSent += s.bytesSent;
+        total.bytesReceived += s.bytesReceived;
+        total.rollbacks += s.rollbacks;
+        total.resimulatedFrames += s.resimulatedFrames;
+        total.hashesSent += s.hashesSent;
+        total.desyncs += s.desyncs;
+        total.fullStates += s.fullStates;
+        total.inputLeadMs += s.inputLeadMs;
+        total.stalls += s.stalls;
+        total.inputDelayFrames += s.inputDelayFrames;
+        total.inputsPredicted += s.inputsPredicted;
+        total.inputsMispredicted += s.inputsMispredicted;
+        botSeconds += s.seconds;
+    }
+
+    auto ms = [](long long us) { return us / 1000.0; };
+    auto perBotSecond = [&](uint64_t value) { return botSeconds > 0.0 ? value / botSeconds : 0.0; };
+
+    std::cout << std::fixed << std::setprecision(3)
+        << "\nBots:      " << played << " played, " << failed.load() << " failed to join\n"
+        << "Ticks:     " << tickStats->GetTickCount() << " server ticks\n"
+        << "Tick time: p50 " << ms(tickStats->Percentile(0.50)) << " ms | p90 " << ms(tickStats->Percentile(0.90))
+        << " ms | p99 " << ms(tickStats->Percentile(0.99)) << " ms | max " << ms(tickStats->Percentile(1.0)) << " ms\n"
+        << std::setprecision(1)
+        << "Bandwidth: " << perBotSecond(total.bytesReceived) << " B/s down, "
+        << perBotSecond(total.bytesSent) << " B/s up per client\n"
+        << "Rollbacks: " << total.rollbacks << " (" << perBotSecond(total.rollbacks) << "/s per client, "
+        << total.resimulatedFrames << " frames re-simulated, " << total.stalls << " ticks stalled)\n"
+        << "Delay:     inputs held back " << (played > 0 ? static_cast<double>(total.inputDelayFrames) / played : 0.0) << " frames\n"
+        << "Guesses:   " << total.inputsPredicted << " remote inputs predicted, "
+        << (total.inputsPredicted > 0 ? 100.0 * total.inputsMispredicted / total.inputsPredicted : 0.0) << "% wrong\n"
+        << "Lead:      inputs reach the server " << (played > 0 ? total.inputLeadMs / played : 0.0) << " ms early\n"
+        << "Desyncs:   " << total.desyncs << " of " << total.hashesSent << " hash checks ("
+        << std::setprecision(3) << (total.hashesSent > 0 ? 100.0 * total.desyncs / total.hashesSent : 0.0)
+        << "%), " << total.fullStates << " full states\n";
+
+    Debug::Shutdown();
+
+    return failed.load() > 0 ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#include "Client-Server/ReplayRunner.hpp"
+#include "game/asteroids.hpp"
+
+#include "Utils/Debug/Debug.hpp"
+
+void PrintHelp() {
+    std::cout << "Usage:\n"
+        << "  --replay <path>            Replay recorded by a server started with --record.\n"
+        << "  --runs <count>             Times to play it back (default: 1).\n"
+        << "  --no-verify                Do not hash frames, to time the simulation alone.\n"
+        << "  --stop-at-mismatch         End a run at the first frame that differs from the recording.\n"
+        << "  --help                     Show this help message.\n"
+        << "\nExample:\n"
+        << "  Benchmark a recorded match five times:\n"
+        << "    ./ReplayRunner --replay match.ntrp --runs 5\n";
+}
+
+int main(int argc, char** argv) {
+
+    std::string path;
+    int runs = 1;
+    ReplayRunConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--help") {
+            PrintHelp();
+            return 0;
+        }
+
+        if (a == "--replay" && i + 1 < argc) path = argv[++i];
+        if (a == "--runs" && i + 1 < argc) runs = std::max(1, std::atoi(argv[++i]));
+        if (a == "--no-verify") config.verifyHashes = false;
+        if (a == "--stop-at-mismatch") config.stopAtMismatch = true;
+    }
+
+    if (path.empty()) {
+        PrintHelp();
+        return 1;
+    }
+
+    // Game logging goes to the log file only; the report goes to stdout
+    Debug::Initialize("ReplayRunner", false);
+
+    ReplayReader reader;
+    if (!reader.Open(path)) {
+        std::cout << "Could not read replay " << path << "\n";
+        Debug::Shutdown();
+        return 1;
+    }
+
+    const ReplayHeader& header = reader.GetHeader();
+    std::cout << "Replay of " << header.ticksPerSecond << " Hz match from frame " << header.startFrame << "\n";
+
+    int failed = 0;
+    for (int run = 0; run < runs; run++) {
+        config.frameStats = std::make_shared<TickStats>();
+        ReplayRunner runner(std::make_unique<AsteroidShooterGame>(), config);
+
+        reader.Rewind();
+        bool ok = runner.Run(reader);
+        const ReplayRunner::Stats& s = runner.GetStats();
+        if (!ok) {
+            failed++;
+        }
+
+        double matchSeconds = static_cast<double>(s.frames) / header.ticksPerSecond;
+
+        std::cout << std::fixed << std::setprecision(1)
+            << "\nRun " << (run + 1) << ":      " << s.frames << " frames in " << s.seconds * 1000.0 << " ms, "
+            << (s.seconds > 0.0 ? s.frames / s.seconds : 0.0) << " frames/s ("
+            << (s.seconds > 0.0 ? matchSeconds / s.seconds : 0.0) << "x real time)\n"
+            << "Frame time: p50 " << config.frameStats->Percentile(0.50) << " us | p90 " << config.frameStats->Percentile(0.90)
+            << " us | p99 " << config.frameStats->Percentile(0.99) << " us | max " << config.frameStats->Percentile(1.0) << " us\n";
+
+        if (config.verifyHashes) {
+            std::cout << "Hashes:     " << s.mismatches << " of " << s.hashesChecked << " frames differ";
+            if (s.firstMismatchFrame >= 0) {
+                std::cout << ", first after frame " << s.firstMismatchFrame;
+            }
+            std::cout << "\n";
+        }
+        if (s.synchronized) {
+            std::cout << "Start:      Init did not reproduce the recorded state, synchronized to it\n";
+        }
+        if (s.damaged) {
+            std::cout << "Damaged:    the replay could not be read past frame " << header.startFrame + static_cast<int>(s.frames) << "\n";
+        }
+    }
+
+    Debug::Shutdown();
+
+    return failed > 0 ? 1 : 0;
+}
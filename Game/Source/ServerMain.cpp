@@ -5,6 +5,8 @@
 #include <chrono>
 
 #include "Client-Server/Server.hpp"  
+#include "Client-Server/MatchHost.hpp"
+#include "netcode/udp_transport.hpp"
 #include "game/asteroids.hpp"       
 
 #include "Utils/Debug/Debug.hpp"
@@ -15,12 +17,24 @@ void PrintHelp() {
         << "  --port <port>              Set the port number (default: 12345).\n"
         << "  --connect <host:port>      Connect to a server at the specified host and port.\n"
         << "  --id <client_id>          Specify a custom client ID.\n"
+        << "  --matches <count>          Host up to <count> matches in this process.\n"
+        << "  --workers <count>          Threads ticking matches (default: one per core).\n"
+        << "  --tickrate <hz>            Simulation ticks per second (default: 30).\n"
+        << "  --snapshot-rate <hz>       State updates per second to clients that do not ask (default: every tick).\n"
+        << "  --delta-budget <bytes>     Cap on the deltas in each update to a client (default: no cap).\n"
+        << "  --interest-radius <units>  Only send a client what is this close to it (default: everything).\n"
+        << "  --udp                      Use the raw UDP transport instead of GameNetworkingSockets (Linux).\n"
+        << "  --record <path>            Record each match to a replay for ReplayRunner (one file per match with --matches).\n"
         << "  --help                     Show this help message.\n"
         << "\nExamples:\n"
         << "  Start server on default port:\n"
         << "    ./game --host\n\n"
         << "  Start server on custom port:\n"
         << "    ./game --host --port 5555\n\n"
+        << "  Start a 60 Hz server:\n"
+        << "    ./game --host --tickrate 60\n\n"
+        << "  Simulate at 60 Hz, send state at 20 Hz:\n"
+        << "    ./game --host --tickrate 60 --snapshot-rate 20\n\n"
         << "  Connect to server:\n"
         << "    ./game --connect 127.0.0.1:5555 --id player1\n";
 }
@@ -28,6 +42,14 @@ void PrintHelp() {
 int main(int argc, char** argv) {
 
     uint16_t port = 12345;
+    size_t maxMatches = 0;
+    size_t workers = 0;
+    bool udp = false;
+    int tickRate = DEFAULT_TICKS_PER_SECOND;
+    int snapshotRate = 0;
+    int deltaBudget = 0;
+    float interestRadius = 0.0f;
+    std::string replayPath;
 
     // Parse arguments
     for (int i = 1; i < argc; ++i) {
@@ -38,6 +60,14 @@ int main(int argc, char** argv) {
         }
         
         if (a == "--port" && i + 1 < argc) port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        if (a == "--matches" && i + 1 < argc) maxMatches = static_cast<size_t>(std::atoi(argv[++i]));
+        if (a == "--workers" && i + 1 < argc) workers = static_cast<size_t>(std::atoi(argv[++i]));
+        if (a == "--udp") udp = true;
+        if (a == "--tickrate" && i + 1 < argc) tickRate = std::atoi(argv[++i]);
+        if (a == "--snapshot-rate" && i + 1 < argc) snapshotRate = std::atoi(argv[++i]);
+        if (a == "--delta-budget" && i + 1 < argc) deltaBudget = std::atoi(argv[++i]);
+        if (a == "--interest-radius" && i + 1 < argc) interestRadius = static_cast<float>(std::atof(argv[++i]));
+        if (a == "--record" && i + 1 < argc) replayPath = argv[++i];
     }
 
     std::unique_ptr<IGameLogic> gameLogic = std::make_unique<AsteroidShooterGame>();
@@ -51,11 +81,37 @@ int main(int argc, char** argv) {
     config.requireClientId = false;
     config.stopOnBelowMin = false;
     config.reconnectionTimeout = std::chrono::seconds(0);
+    config.ticksPerSecond = tickRate;
+    config.snapshotsPerSecond = snapshotRate;
+    config.deltaBudgetBytes = deltaBudget;
+    config.interestRadius = interestRadius;
+    config.replayPath = replayPath;
 
     Debug::Initialize("AsteroidsServer", true);
 
-    Server server(std::move(gameLogic), config);
-    int code = server.RunServer();
+    std::shared_ptr<ITransport> transport;
+#ifdef __linux__
+    if (udp) transport = std::make_shared<UdpTransport>();
+#else
+    if (udp) Debug::Error("Server") << "--udp is only available on Linux, using GameNetworkingSockets\n";
+#endif
+
+    int code = 0;
+    if (maxMatches > 0) {
+        MatchHostConfig hostConfig(port);
+        hostConfig.maxMatches = maxMatches;
+        hostConfig.workerThreads = workers;
+        hostConfig.matchConfig = config;
+
+        MatchHost host([]() { return std::make_unique<AsteroidShooterGame>(); }, hostConfig);
+        if (transport) host.SetTransport(transport);
+        code = host.Run();
+    }
+    else {
+        Server server(std::move(gameLogic), config);
+        if (transport) server.SetTransport(transport);
+        code = server.RunServer();
+    }
 
     Debug::Shutdown();
 
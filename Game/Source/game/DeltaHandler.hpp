@@ -8,15 +8,14 @@ class GamePositionsDeltaHandler : public IDeltaHandler {
 public:
 	void Apply(const DeltaStateBlob& delta, GameStateBlob& currentState) override
 	{
+		if (delta.entityId < 0 || delta.entityId >= NUM_PLAYERS) return;
+
 		GamePositionsDelta gpd = *reinterpret_cast<const GamePositionsDelta*>(delta.data);
 		AsteroidShooterGameState* gs = reinterpret_cast<AsteroidShooterGameState*>(currentState.data);
 
-		for (int i = 0; i < NUM_PLAYERS; i++)
-		{
-			gs->posX[i] = gpd.posX[i];
-			gs->posY[i] = gpd.posY[i];
-			gs->rot[i] = gpd.rot[i];
-		}
+		gs->posX[delta.entityId] = gpd.posX;
+		gs->posY[delta.entityId] = gpd.posY;
+		gs->rot[delta.entityId] = gpd.rot;
 	}
 	void Check(const GameStateBlob& prevState,
 		const GameStateBlob& currentState,
@@ -24,35 +23,36 @@ public:
 	{
 		// Always send positions every tick so interpolation always has
 		// prev and curr data, even when players are stationary.
+		// One delta per ship, so a delta budget can send them separately.
 		AsteroidShooterGameState currGS = *reinterpret_cast<const AsteroidShooterGameState*>(currentState.data);
-		GamePositionsDelta gpd;
 
 		for (int i = 0; i < NUM_PLAYERS; i++)
 		{
-			gpd.posX[i] = currGS.posX[i];
-			gpd.posY[i] = currGS.posY[i];
-			gpd.rot[i] = currGS.rot[i];
+			GamePositionsDelta gpd;
+			gpd.posX = currGS.posX[i];
+			gpd.posY = currGS.posY[i];
+			gpd.rot = currGS.rot[i];
+
+			DeltaStateBlob deltaBlob;
+			deltaBlob.delta_type = DELTA_GAME_POSITIONS;
+			deltaBlob.entityId = i;
+			std::memcpy(deltaBlob.data, &gpd, sizeof(GamePositionsDelta));
+			deltaBlob.len = sizeof(GamePositionsDelta);
+			outDeltas.push_back(deltaBlob);
 		}
-
-		DeltaStateBlob deltaBlob;
-		deltaBlob.delta_type = DELTA_GAME_POSITIONS;
-		std::memcpy(deltaBlob.data, &gpd, sizeof(GamePositionsDelta));
-		deltaBlob.len = sizeof(GamePositionsDelta);
-		outDeltas.push_back(deltaBlob);
 	}
 
 	bool Compare(const DeltaStateBlob& delta,
 		const GameStateBlob& currentState) override
 	{
+		if (delta.entityId < 0 || delta.entityId >= NUM_PLAYERS) return true;
+
 		GamePositionsDelta gpd = *reinterpret_cast<const GamePositionsDelta*>(delta.data);
 		AsteroidShooterGameState gs = *reinterpret_cast<const AsteroidShooterGameState*>(currentState.data);
 
-		for (int i = 0; i < NUM_PLAYERS; i++)
-		{
-			if (gs.posX[i] != gpd.posX[i]) return false;
-			if (gs.posY[i] != gpd.posY[i]) return false;
-			if (gs.rot[i] != gpd.rot[i]) return false;
-		}
+		if (gs.posX[delta.entityId] != gpd.posX) return false;
+		if (gs.posY[delta.entityId] != gpd.posY) return false;
+		if (gs.rot[delta.entityId] != gpd.rot) return false;
 
 		return true;
 	}
@@ -4,8 +4,9 @@ enum AsteroidsDeltaTypes {
     DELTA_GAME_POSITIONS = 0
 };
 
+// Position of the ship whose player id is the delta's entityId
 struct GamePositionsDelta {
-    float posX[NUM_PLAYERS];
-    float posY[NUM_PLAYERS];
-    float rot[NUM_PLAYERS];
+    float posX;
+    float posY;
+    float rot;
 };
\ No newline at end of file
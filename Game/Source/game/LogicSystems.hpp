@@ -143,7 +143,7 @@ public:
 
 class ArenaSystem : public ISystem {
 private:
-    std::mt19937 rng{ std::random_device{}() };
+    std::mt19937 rng;
     const int x_size = MAP_SIZE;
     const int y_size = MAP_SIZE;
 
@@ -786,6 +786,9 @@ private:
     }
 
 public:
+    // Seeded from the match so replays pick the same tiles
+    explicit ArenaSystem(uint32_t seed) : rng(seed) {}
+
     void Update(EntityManager& entityManager, std::vector<EventEntry>& events,
         bool isServer, float deltaTime) override
     {
@@ -32,7 +32,6 @@
 #include "OpenAL/AudioManager.hpp"
 #include "OpenAL/AudioComponents.hpp"
 
-#include <openssl/evp.h>
 
 #include "NetTFG_Engine.hpp"
 
@@ -90,6 +89,9 @@ static void GetPlayerSpawnWorld(int playerIndex, float& outX, float& outY, float
 class AsteroidShooterGame : public IECSGameLogic {
 private:
     int debugTicks = 0;
+
+    static constexpr float OWN_SHIP_PRIORITY = 4.0f;
+    static constexpr float NEAR_DISTANCE = 80.0f;     // One tile
 public:
 
     void printGameState(const AsteroidShooterGameState& state) const
@@ -459,7 +461,7 @@ public:
         }
 
         // --- Walls ---
-        std::mt19937 initRng{ std::random_device{}() };
+        std::mt19937 initRng{ randomSeed };
         std::uniform_real_distribution<float> initDist(3.0f, 30.0f);
 
         std::vector<WallDef> walls;
@@ -637,7 +639,7 @@ public:
         if (isServer)
         {
             world.AddSystem(std::make_unique<InputServerSystem>());
-            world.AddSystem(std::make_unique<ArenaSystem>());
+            world.AddSystem(std::make_unique<ArenaSystem>(randomSeed + 1));
             world.AddSystem(std::make_unique<GameOverSystem>());
         }
 
@@ -656,29 +658,58 @@ public:
         deltaProcessor->RegisterHandler(DELTA_GAME_POSITIONS, std::make_unique<GamePositionsDeltaHandler>());
     }
 
-    void HashState(const GameStateBlob& state, uint8_t(&outHash)[SHA256_DIGEST_LENGTH]) const override {
-        const AsteroidShooterGameState& s =
-            *reinterpret_cast<const AsteroidShooterGameState*>(state.data);
+    // With a delta budget, the player's own ship is sent most often, then the
+    // others by how close they are to it: within a tile they count almost as
+    // much, across the arena little more than anything else
+    float GetDeltaPriority(const GameStateBlob& state, const DeltaStateBlob& delta, int playerId) const override {
+        if (delta.entityId < 0 || delta.entityId >= NUM_PLAYERS || playerId < 0 || playerId >= NUM_PLAYERS) {
+            return 1.0f;
+        }
+        if (delta.entityId == playerId) {
+            return OWN_SHIP_PRIORITY;
+        }
 
-        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-        if (!ctx) throw std::runtime_error("Failed to create EVP_MD_CTX");
+        const AsteroidShooterGameState* gs = reinterpret_cast<const AsteroidShooterGameState*>(state.data);
+        float distance = std::hypot(gs->posX[delta.entityId] - gs->posX[playerId],
+            gs->posY[delta.entityId] - gs->posY[playerId]);
+        return 1.0f + (OWN_SHIP_PRIORITY - 1.0f) * NEAR_DISTANCE / (NEAR_DISTANCE + distance);
+    }
 
-        if (1 != EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr)) {
-            EVP_MD_CTX_free(ctx);
-            throw std::runtime_error("EVP_DigestInit_ex failed");
+    // Ships are the entities deltas are tied to, by player id
+    void GetEntityPositions(const GameStateBlob& state, std::vector<EntityPosition>& positions) const override {
+        const AsteroidShooterGameState* gs = reinterpret_cast<const AsteroidShooterGameState*>(state.data);
+        for (int i = 0; i < NUM_PLAYERS; i++) {
+            positions.push_back(EntityPosition{ i, gs->posX[i], gs->posY[i] });
         }
+    }
 
-        EVP_DigestUpdate(ctx, &s.health[0], sizeof(s.health[0]));
-        EVP_DigestUpdate(ctx, &s.health[1], sizeof(s.health[1]));
-        EVP_DigestUpdate(ctx, &s.alive[0], sizeof(s.alive[0]));
-        EVP_DigestUpdate(ctx, &s.alive[1], sizeof(s.alive[1]));
+    // Spectators watch the whole arena
+    bool GetViewerPosition(const GameStateBlob& state, int playerId, float& x, float& y) const override {
+        const AsteroidShooterGameState* gs = reinterpret_cast<const AsteroidShooterGameState*>(state.data);
+        if (playerId < 0 || playerId >= NUM_PLAYERS || !gs->alive[playerId]) {
+            return false;
+        }
+        x = gs->posX[playerId];
+        y = gs->posY[playerId];
+        return true;
+    }
 
-        unsigned int len = 0;
-        if (1 != EVP_DigestFinal_ex(ctx, outHash, &len)) {
-            EVP_MD_CTX_free(ctx);
-            throw std::runtime_error("EVP_DigestFinal_ex failed");
+    // Bullets only matter to clients that can see them; hits and deaths are
+    // decided by the server and go to everyone
+    bool GetEventPosition(const EventEntry& event, float& x, float& y) const override {
+        if (event.event.type != AsteroidEventMask::SPAWN_BULLET) {
+            return false;
         }
-        EVP_MD_CTX_free(ctx);
+        const SpawnBulletEventData* spawn = reinterpret_cast<const SpawnBulletEventData*>(event.event.data);
+        x = spawn->posX;
+        y = spawn->posY;
+        return true;
+    }
+
+    // Only health and alive status are compared between peers
+    void GetHashSections(const GameStateBlob& /*state*/, std::vector<StateSection>& sections) const override {
+        sections.push_back(StateSection{ offsetof(AsteroidShooterGameState, health), sizeof(AsteroidShooterGameState::health) });
+        sections.push_back(StateSection{ offsetof(AsteroidShooterGameState, alive), sizeof(AsteroidShooterGameState::alive) });
     }
 
     void PrintState(const GameStateBlob& state) const override {
@@ -798,7 +829,7 @@ public:
                 Transform* st = em.AddComponent<Transform>(bulletSound, Transform{});
                 st->setPosition(glm::vec3(b.posX, b.posY, 0.0f));
                 DestroyTimer* dt = em.AddComponent<DestroyTimer>(bulletSound, DestroyTimer{});
-                dt->framesRemaining = RENDER_TICKS_PER_SECOND * 3;
+                dt->framesRemaining = ClientWindow::getRenderTickRate() * 3;
                 AudioSourceComponent* audio = em.AddComponent<AudioSourceComponent>(
                     bulletSound, AudioSourceComponent("shoot.wav", AudioChannel::SFX, false));
                 audio->play = true;
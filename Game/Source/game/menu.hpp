@@ -19,7 +19,6 @@
 #include "ecs/UI/UIElement.hpp"
 #include "NetTFG_Engine.hpp"
 
-#include <openssl/evp.h>
 
 // Simple game state for start screen
 struct StartScreenGameState {
@@ -45,7 +44,7 @@ public:
 class TextAnimationData : public IComponent {
 public:
     bool active = false;
-    int remainTicks = RENDER_TICKS_PER_SECOND / 4;
+    int remainTicks = ClientWindow::getRenderTickRate() / 4;
     int currentState = 0;
 
     std::string errorMessage = "";
@@ -75,7 +74,7 @@ class TextAnimationSystem : public ISystem {
             animData->remainTicks--;
             if (animData->remainTicks <= 0) {
                 animData->currentState = (animData->currentState + 1) % 4;
-                animData->remainTicks = RENDER_TICKS_PER_SECOND / 4;
+                animData->remainTicks = ClientWindow::getRenderTickRate() / 4;
                 switch (animData->currentState) {
                 case 0:
                     text->text = "Conectando.";
@@ -204,29 +203,8 @@ public:
         printf("[StartScreen] Game logic initialized!\n");
     }
 
-    void HashState(const GameStateBlob& state, uint8_t(&outHash)[SHA256_DIGEST_LENGTH]) const override {
-        // Create context
-        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
-        if (!ctx) throw std::runtime_error("Failed to create EVP_MD_CTX");
-
-        // Initialize SHA-256
-        if (1 != EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr)) {
-            EVP_MD_CTX_free(ctx);
-            throw std::runtime_error("EVP_DigestInit_ex failed");
-        }
-
-        // No data to hash currently
-        // (would normally call EVP_DigestUpdate(ctx, data, size); here)
-
-        // Finalize hash
-        unsigned int len = 0;
-        if (1 != EVP_DigestFinal_ex(ctx, outHash, &len)) {
-            EVP_MD_CTX_free(ctx);
-            throw std::runtime_error("EVP_DigestFinal_ex failed");
-        }
-
-        // Cleanup
-        EVP_MD_CTX_free(ctx);
+    // Nothing in the start screen needs to match between peers
+    void GetHashSections(const GameStateBlob& /*state*/, std::vector<StateSection>& /*sections*/) const override {
     }
 
     void PrintState(const GameStateBlob& state) const override {
@@ -0,0 +1,338 @@
+#pragma once
+
+#include <GameNetworkingSockets/steam/steamnetworkingtypes.h>
+#include <GameNetworkingSockets/steam/steamnetworkingsockets.h>
+#include "netcode/netcode_common.hpp"
+#include "netcode/client_netcode.hpp"
+#include "netcode/valve_sockets_session.hpp"
+#include "netcode/tick_scheduler.hpp"
+#include "Client-Server/InputDelayCalculator.hpp"
+#include "Client-Server/TimeSync.hpp"
+#include "Client-Server/ClientPacketHandler.hpp"
+#include "Utils/Debug/Debug.hpp"
+#include <memory>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstring>
+#include <cstdint>
+
+struct BotConfig {
+    std::string host;
+    uint16_t port;
+    std::string clientId;
+    std::string matchId;        // Match to join on a MatchHost, empty for a plain server
+    uint32_t seed;              // Seed of the default random input
+    int inputHoldFrames;        // Frames each random input is held for
+    int snapshotsPerSecond;     // State updates to ask for, 0 for the server's default
+    int targetRollbackFrames;   // Rollback depth input delay aims for, negative for no delay
+
+    BotConfig(uint16_t p = 7777)
+        : host("127.0.0.1")
+        , port(p)
+        , seed(0)
+        , inputHoldFrames(10)
+        , snapshotsPerSecond(0)
+        , targetRollbackFrames(TARGET_ROLLBACK_FRAMES)
+    {
+    }
+};
+
+// Headless client for load and soak tests. Speaks the same protocol as
+// OnlineClient and runs ClientPredictionNetcode the same way, but has no
+// window or renderer: inputs come from an InputSource and incoming packets
+// are handled on the ticking thread, so one bot costs one thread.
+class BotClient {
+public:
+    // Input for the bot's n-th tick
+    using InputSource = std::function<InputBlob(uint64_t tick)>;
+
+    struct Stats {
+        uint64_t ticks = 0;
+        uint64_t bytesSent = 0;
+        uint64_t bytesReceived = 0;
+        uint64_t rollbacks = 0;           // Reconciliations that re-simulated
+        uint64_t resimulatedFrames = 0;
+        uint64_t hashesSent = 0;
+        uint64_t desyncs = 0;             // Hash checks the server answered with a repair request
+        uint64_t fullStates = 0;          // Full states received, ack timeouts included
+        uint64_t stalls = 0;              // Ticks skipped at the end of the prediction window
+        int inputDelayFrames = 0;
+        uint64_t inputsPredicted = 0;     // Remote inputs guessed before they arrived
+        uint64_t inputsMispredicted = 0;
+        double inputLeadMs = 0.0;         // How early inputs reach the server, low end of the recent ones
+        double seconds = 0.0;             // Time spent in the game
+    };
+
+    BotClient(std::unique_ptr<IGameLogic> gameLogic, const BotConfig& config = BotConfig())
+        : gameLogic_(std::move(gameLogic))
+        , config_(config)
+        , rng_(config.seed)
+    {
+        inputDelayCalc_.SetTargetRollbackFrames(config.targetRollbackFrames);
+        inputSource_ = [this](uint64_t tick) { return RandomInput(tick); };
+    }
+
+    ~BotClient() {
+        Close();
+    }
+
+    void SetInputSource(InputSource source) { inputSource_ = std::move(source); }
+
+    void SetNetworkWaitConfig(const NetworkWaitConfig& config) { net_.SetWaitConfig(config); }
+
+    // Replaces the default GNS transport. Call before Connect.
+    void SetTransport(std::shared_ptr<ITransport> transport) { net_.SetTransport(std::move(transport)); }
+
+    // Connects, says hello and waits for the game to start
+    ConnectionCode Connect() {
+        if (!net_.InitGNS()) {
+            return CONN_SOCKETS_FAILED;
+        }
+
+        ConnectionCode code = net_.ConnectTo(config_.host, config_.port);
+        if (code != CONN_SUCCESS) {
+            return code;
+        }
+        serverConnection_ = net_.GetConnectedConnection();
+
+        ClientHelloPacket hello;
+        std::strncpy(hello.clientId, config_.clientId.c_str(), sizeof(hello.clientId) - 1);
+        std::strncpy(hello.matchId, config_.matchId.c_str(), sizeof(hello.matchId) - 1);
+        hello.snapshotsPerSecond = config_.snapshotsPerSecond;
+        net_.SendClientHello(serverConnection_, hello);
+
+        if (!WaitForGameStart()) {
+            return CONN_TIMEOUT;
+        }
+
+        gameLogic_->ticksPerSecond = ticksPerSecond_;
+        timeSync_.SetTickRate(ticksPerSecond_);
+        packets_.SetTickRate(ticksPerSecond_);
+        prediction_ = std::make_unique<ClientPredictionNetcode>(playerId_, std::move(gameLogic_));
+        prediction_->UpdateCurrentFrame(1);
+        startTime_ = std::chrono::steady_clock::now();
+        return CONN_SUCCESS;
+    }
+
+    // Handles everything received so far, then predicts and sends one frame,
+    // or as many as time sync asks for
+    void Tick() {
+        ReceivePending();
+
+        int frames = timeSync_.TakeTicksDue(prediction_->GetCurrentFrame());
+        for (int i = 0; i < frames; i++) {
+            TickFrame();
+        }
+    }
+
+    // Ticks at the server's tick rate, dilated by time sync, until running is
+    // cleared, the server closes the connection or the game ends. Returns the
+    // ticks played.
+    uint64_t Run(const std::atomic<bool>& running) {
+        FixedTickScheduler scheduler(ticksPerSecond_);
+        scheduler.Start();
+
+        while (running.load() && IsConnected() && !prediction_->GetGameLogic()->gameFinished) {
+            Tick();
+            scheduler.SetTimeScale(timeSync_.GetTimeScale());
+            scheduler.Advance();
+
+            // Keep receiving while waiting for the next tick
+            for (;;) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    scheduler.NextTickTime() - FixedTickScheduler::Clock::now()).count();
+                if (remaining <= 0) {
+                    break;
+                }
+                net_.WaitForTraffic(static_cast<int>(remaining));
+                ReceivePending();
+            }
+            scheduler.SleepUntilNext();
+        }
+
+        return ticks_;
+    }
+
+    int GetTicksPerSecond() const { return ticksPerSecond_; }
+
+    void Close() {
+        if (serverConnection_ != k_HSteamNetConnection_Invalid) {
+            net_.CloseConnection(serverConnection_, true);
+            serverConnection_ = k_HSteamNetConnection_Invalid;
+        }
+    }
+
+    bool IsConnected() {
+        return serverConnection_ != k_HSteamNetConnection_Invalid &&
+            net_.GetConnectionState(serverConnection_) == TRANSPORT_CONNECTED;
+    }
+
+    int GetPlayerId() const { return playerId_; }
+
+    Stats GetStats() const {
+        Stats stats;
+        stats.ticks = ticks_;
+        stats.bytesSent = net_.GetBytesSent();
+        stats.bytesReceived = net_.GetBytesReceived();
+        stats.hashesSent = hashesSent_;
+        stats.desyncs = desyncs_;
+        stats.fullStates = fullStates_;
+        stats.stalls = stalls_;
+        stats.inputLeadMs = timeSync_.GetInputLeadUs() / 1000.0;
+        if (prediction_) {
+            stats.rollbacks = prediction_->GetRollbackCount();
+            stats.resimulatedFrames = prediction_->GetResimulatedFrames();
+            stats.inputDelayFrames = prediction_->GetInputDelay();
+            for (const auto& [player, prediction] : prediction_->GetInputPredictionStats()) {
+                stats.inputsPredicted += prediction.predicted;
+                stats.inputsMispredicted += prediction.mispredicted;
+            }
+            stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime_).count();
+        }
+        return stats;
+    }
+
+private:
+    void TickFrame() {
+        if (!prediction_->CanAdvance()) {
+            stalls_++;
+            return;
+        }
+
+        int frame = prediction_->GetCurrentFrame();
+        net_.SetFrameReference(frame);
+
+        submitted_.clear();
+        prediction_->SubmitLocalInput(inputSource_(ticks_), submitted_);
+        for (const InputEntry& entry : submitted_) {
+            packets_.QueueLocalInput(entry);
+        }
+        net_.SendInputWindow(serverConnection_, playerId_, packets_.GetUnackedInputs());
+        net_.SendStateAck(serverConnection_, prediction_->GetLastConfirmedFrame());
+
+        prediction_->Tick();
+        ticks_++;
+
+        if (hashCheckInterval_ > 0 &&
+            prediction_->GetLastConfirmedFrame() >= lastHashedFrame_ + hashCheckInterval_) {
+            HashPacket hashPacket;
+            GameStateBlob serverState = prediction_->GetLatestServerState();
+            hashPacket.frame = serverState.frame;
+            hashPacket.hash = prediction_->GetGameLogic()->HashState(serverState);
+            lastHashedFrame_ = hashPacket.frame;
+
+            net_.SendHashPacket(serverConnection_, hashPacket);
+            hashesSent_++;
+        }
+
+        if (frame % 30 == 0) {
+            InputDelayPacket packet;
+            packet.playerId = playerId_;
+            packet.timestamp = inputDelayCalc_.GetTimestampMs();
+            net_.SendInputDelaySync(serverConnection_, packet);
+        }
+
+        net_.FlushOutgoing();
+    }
+
+    GNSSession net_;
+    InputDelayCalculator inputDelayCalc_;
+    std::unique_ptr<IGameLogic> gameLogic_;
+    std::unique_ptr<ClientPredictionNetcode> prediction_;
+    BotConfig config_;
+    InputSource inputSource_;
+    HSteamNetConnection serverConnection_ = k_HSteamNetConnection_Invalid;
+    int playerId_ = -1;
+    int hashCheckInterval_ = 0;
+    int ticksPerSecond_ = DEFAULT_TICKS_PER_SECOND;   // Announced by the server
+    TimeSync timeSync_;
+    int lastHashedFrame_ = -1;
+    std::chrono::steady_clock::time_point startTime_;
+
+    ClientPacketHandler packets_{ net_, timeSync_, inputDelayCalc_ };
+
+    std::mt19937 rng_;
+    InputBlob heldInput_;
+    uint64_t nextInputChange_ = 0;
+
+    uint64_t ticks_ = 0;
+    uint64_t hashesSent_ = 0;
+    uint64_t desyncs_ = 0;
+    uint64_t fullStates_ = 0;
+    uint64_t stalls_ = 0;
+    std::vector<InputEntry> submitted_;
+
+    // Random bytes, each value held for a few frames like a player holding keys
+    InputBlob RandomInput(uint64_t tick) {
+        if (tick >= nextInputChange_) {
+            for (size_t i = 0; i < sizeof(heldInput_.data); i++) {
+                heldInput_.data[i] = static_cast<uint8_t>(rng_());
+            }
+            nextInputChange_ = tick + static_cast<uint64_t>(std::max(1, config_.inputHoldFrames));
+        }
+        return heldInput_;
+    }
+
+    bool WaitForGameStart() {
+        bool accepted = false;
+        bool started = false;
+        bool rejected = false;
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+
+        while (!started && !rejected) {
+            if (std::chrono::steady_clock::now() > timeout || !IsConnected()) {
+                Debug::Info("BotClient") << config_.clientId << " gave up waiting for the game to start\n";
+                return false;
+            }
+
+            net_.PumpCallbacks();
+            net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection) {
+                if (len < 1 || started) {
+                    return;
+                }
+
+                if (data[0] == PACKET_SERVER_ACCEPT) {
+                    ServerAcceptPacket accept;
+                    if (net_.ParseServerAccept(data, len, accept)) {
+                        playerId_ = accept.playerId;
+                        hashCheckInterval_ = accept.hashCheckInterval;
+                        ticksPerSecond_ = ClampTickRate(accept.ticksPerSecond);
+                        accepted = true;
+                    }
+                }
+                else if (data[0] == PACKET_SERVER_REJECT) {
+                    rejected = true;
+                }
+                else if (data[0] == PACKET_GAME_START && accepted) {
+                    GameStartPacket start;
+                    if (net_.ParseGameStart(data, len, start)) {
+                        playerId_ = start.playerId;
+                        ticksPerSecond_ = ClampTickRate(start.ticksPerSecond);
+                        started = true;
+                    }
+                }
+                }, true);
+
+            net_.WaitForTraffic(50);
+        }
+
+        return started;
+    }
+
+    void ReceivePending() {
+        net_.PumpCallbacks();
+        while (net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
+            ServerPacketKind kind = packets_.Handle(*prediction_, data, len, conn);
+            if (kind == SERVER_PACKET_FULL_STATE) {
+                fullStates_++;
+            }
+            else if (kind == SERVER_PACKET_DESYNC) {
+                desyncs_++;
+            }
+            }, false) > 0) {
+        }
+    }
+};
@@ -4,6 +4,7 @@
 #include "ecs/ecs.hpp"
 #include "ecs/ecs_gamelogic.hpp"
 #include "netcode/valve_sockets_session.hpp"
+#include "netcode/tick_scheduler.hpp"
 
 class Client {
 public:
@@ -14,4 +15,8 @@ public:
 	virtual void TickClient() = 0;
 	virtual void CloseClient() = 0;
 	virtual EntityManager* GetEntityManager() = 0;
+	// Rate the engine calls TickClient at
+	virtual int GetTicksPerSecond() const { return DEFAULT_TICKS_PER_SECOND; }
+	// How much faster than that, to keep in step with a server
+	virtual double GetTickTimeScale() const { return 1.0; }
 };
\ No newline at end of file
@@ -0,0 +1,241 @@
+#pragma once
+
+#include "netcode/netcode_common.hpp"
+#include "netcode/client_netcode.hpp"
+#include "netcode/valve_sockets_session.hpp"
+#include "Client-Server/InputDelayCalculator.hpp"
+#include "Client-Server/TimeSync.hpp"
+#include "Utils/Debug/Debug.hpp"
+#include <atomic>
+#include <deque>
+#include <cstdint>
+#include <vector>
+
+// What a packet from the server turned out to be, for what only one kind of
+// client does with it, such as showing the server state or counting desyncs
+enum ServerPacketKind : uint8_t {
+    SERVER_PACKET_IGNORED = 0,      // Malformed, or not one the game handles
+    SERVER_PACKET_FULL_STATE = 1,   // Full state, the server state was replaced
+    SERVER_PACKET_STATE_CHANGE = 2, // Deltas or a repair changed the server state
+    SERVER_PACKET_DESYNC = 3,       // The server saw a hash mismatch and was sent the hash tree
+    SERVER_PACKET_OTHER = 4
+};
+
+// The part of the protocol every client speaks during the game, shared by
+// OnlineClient and BotClient: handles packets from the server and keeps the
+// window of local inputs the server has not acked.
+//
+// Handle may run on a network thread while QueueLocalInput and
+// GetUnackedInputs run on the ticking thread; they only share the acked frame.
+// Split deltas updates are put back together by Handle alone.
+class ClientPacketHandler {
+public:
+    ClientPacketHandler(GNSSession& net, TimeSync& timeSync, InputDelayCalculator& inputDelayCalc)
+        : net_(net)
+        , timeSync_(timeSync)
+        , inputDelayCalc_(inputDelayCalc)
+    {
+    }
+
+    // Announced by the server, used to turn the measured RTT into frames
+    void SetTickRate(int ticksPerSecond) {
+        ticksPerSecond_.store(ClampTickRate(ticksPerSecond));
+    }
+
+    ServerPacketKind Handle(ClientPredictionNetcode& prediction, const uint8_t* data, int len, HSteamNetConnection conn) {
+        if (len < 1) {
+            return SERVER_PACKET_IGNORED;
+        }
+
+        uint8_t type = data[0];
+
+        if (type == PACKET_STATE_UPDATE) {
+            StateUpdate update;
+            if (!net_.ParseStateUpdate(data, len, update)) {
+                Debug::Info("Client") << "[CLIENT] Received malformed PACKET_STATE_UPDATE, len=" << len << "\n";
+                return SERVER_PACKET_IGNORED;
+            }
+            // Absolute frame, re-anchors the wrapped frames of later packets
+            net_.SetFrameReference(update.frame);
+            prediction.OnServerStateUpdate(update);
+            return SERVER_PACKET_FULL_STATE;
+        }
+
+        if (type == PACKET_STATE_REPAIR) {
+            StateRepairPacket repair;
+            if (!net_.ParseStateRepair(data, len, repair)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            net_.SetFrameReference(repair.frame);
+            prediction.OnServerStateRepair(repair.frame, repair.state, repair.sections);
+            return SERVER_PACKET_STATE_CHANGE;
+        }
+
+        if (type == PACKET_HASH_TREE_REQUEST) {
+            // The server saw a hash mismatch; answer with the section hashes of
+            // the newest server state so it can send back only what diverged
+            int requestedFrame = 0;
+            if (!net_.ParseHashTreeRequest(data, len, requestedFrame)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            HashTreePacket tree;
+            GameStateBlob serverState = prediction.GetLatestServerState();
+            tree.frame = serverState.frame;
+            prediction.GetGameLogic()->HashSections(serverState, tree.sectionHashes);
+            net_.SendHashTree(conn, tree);
+            return SERVER_PACKET_DESYNC;
+        }
+
+        if (type == PACKET_DELTA_STATE_UPDATE) {
+            DeltasUpdatePacket packet;
+            if (!net_.ParseDeltasUpdate(data, len, packet)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            // Confirming the frame with a part missing would ack changes the
+            // client never got
+            if (!AssembleDeltas(packet)) {
+                return SERVER_PACKET_OTHER;
+            }
+            prediction.OnServerDeltasUpdate(packet.deltas, packet.frame, packet.baseFrame);
+            return SERVER_PACKET_STATE_CHANGE;
+        }
+
+        if (type == PACKET_INPUT_UPDATE) {
+            InputEntry ie;
+            if (!net_.ParseInputUpdate(data, len, ie)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            prediction.OnServerInputUpdate(ie);
+            return SERVER_PACKET_OTHER;
+        }
+
+        if (type == PACKET_EVENT_UPDATE) {
+            EventEntry event;
+            if (!net_.ParseEventUpdate(data, len, event)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            prediction.OnServerEventUpdate(event);
+            return SERVER_PACKET_OTHER;
+        }
+
+        if (type == PACKET_INPUT_ACK) {
+            // Acks are cumulative and unreliable, keep the highest one seen
+            InputAckPacket ack;
+            if (!net_.ParseInputAck(data, len, ack)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            if (ack.hasLead) {
+                timeSync_.OnInputLead(ack.frame, ack.inputLeadUs);
+            }
+            int previous = lastAckedInputFrame_.load();
+            while (ack.frame > previous && !lastAckedInputFrame_.compare_exchange_weak(previous, ack.frame)) {
+            }
+            return SERVER_PACKET_OTHER;
+        }
+
+        if (type == PACKET_INPUT_DELAY) {
+            InputDelayPacket packet;
+            if (!net_.ParseInputDelaySync(data, len, packet)) {
+                return SERVER_PACKET_IGNORED;
+            }
+            // Sets the input delay; how far ahead the client runs for the
+            // inputs to arrive in time is up to the time sync
+            inputDelayCalc_.UpdateRtt(packet.timestamp, ticksPerSecond_.load());
+            prediction.SetInputDelay(inputDelayCalc_.GetInputDelayFrames());
+            return SERVER_PACKET_OTHER;
+        }
+
+        return SERVER_PACKET_IGNORED;
+    }
+
+    // Adds a submitted local input to the window, dropping what the server acked
+    void QueueLocalInput(const InputEntry& entry) {
+        int acked = lastAckedInputFrame_.load();
+        while (!unackedInputs_.empty() && unackedInputs_.front().frame <= acked) {
+            unackedInputs_.pop_front();
+        }
+
+        // A reconciliation can move the local frame back; the window must stay increasing
+        while (!unackedInputs_.empty() && unackedInputs_.back().frame >= entry.frame) {
+            unackedInputs_.pop_back();
+        }
+
+        unackedInputs_.push_back(entry);
+        while (unackedInputs_.size() > static_cast<size_t>(INPUT_WINDOW_SIZE)) {
+            unackedInputs_.pop_front();
+        }
+    }
+
+    // Inputs not yet acked by the server, oldest first. All of them are sent
+    // every tick, so a lost packet is covered by the next one.
+    const std::deque<InputEntry>& GetUnackedInputs() const {
+        return unackedInputs_;
+    }
+
+    // Forgets the inputs of the last session. Not while Handle may run.
+    void Reset() {
+        unackedInputs_.clear();
+        lastAckedInputFrame_.store(-1);
+        partialDeltas_ = DeltasUpdatePacket();
+        partDeltas_.clear();
+        partsReceived_ = 0;
+    }
+
+private:
+    GNSSession& net_;
+    TimeSync& timeSync_;
+    InputDelayCalculator& inputDelayCalc_;
+    std::atomic<int> ticksPerSecond_{ DEFAULT_TICKS_PER_SECOND };
+
+    std::deque<InputEntry> unackedInputs_;
+    std::atomic<int> lastAckedInputFrame_{ -1 };  // Written by Handle
+
+    // Parts of the newest split deltas update while some are missing, kept in
+    // part order since they may arrive in any order
+    DeltasUpdatePacket partialDeltas_;
+    std::vector<std::vector<DeltaStateBlob>> partDeltas_;
+    uint64_t partsReceived_ = 0;    // One bit per part
+
+    static_assert(MAX_DELTA_PARTS <= 64, "Received parts must fit in 64 bits");
+
+    // True once packet holds every delta of its update. A part of a newer
+    // update drops the unfinished one; parts of older ones are ignored.
+    bool AssembleDeltas(DeltasUpdatePacket& packet) {
+        if (packet.partCount <= 1) {
+            return true;
+        }
+
+        bool sameUpdate = partsReceived_ != 0 && packet.frame == partialDeltas_.frame &&
+            packet.baseFrame == partialDeltas_.baseFrame && packet.partCount == partialDeltas_.partCount;
+        if (!sameUpdate) {
+            if (partsReceived_ != 0 && packet.frame < partialDeltas_.frame) {
+                return false;
+            }
+            partialDeltas_.frame = packet.frame;
+            partialDeltas_.baseFrame = packet.baseFrame;
+            partialDeltas_.partCount = packet.partCount;
+            partDeltas_.assign(packet.partCount, {});
+            partsReceived_ = 0;
+        }
+
+        uint64_t bit = uint64_t(1) << packet.part;
+        if (partsReceived_ & bit) {
+            return false;
+        }
+        partsReceived_ |= bit;
+        partDeltas_[packet.part] = std::move(packet.deltas);
+
+        uint64_t all = packet.partCount == 64 ? ~uint64_t(0) : (uint64_t(1) << packet.partCount) - 1;
+        if (partsReceived_ != all) {
+            return false;
+        }
+
+        packet.deltas.clear();
+        for (std::vector<DeltaStateBlob>& part : partDeltas_) {
+            packet.deltas.insert(packet.deltas.end(), part.begin(), part.end());
+        }
+        partDeltas_.clear();
+        partsReceived_ = 0;
+        return true;
+    }
+};
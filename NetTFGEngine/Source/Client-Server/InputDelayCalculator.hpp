@@ -50,9 +50,12 @@ public:
         m_lastRttMs = sum / static_cast<uint32_t>(m_rttSamples.size());
         m_lastLatencyMs = m_lastRttMs / 2.0f;
 
-        CalculateInputDelayFrames(TICKS_PER_SECOND);
+        CalculateInputDelayFrames(tickRate);
     }
 
+    // Rollback depth the input delay aims for, negative for no input delay
+    void SetTargetRollbackFrames(int frames) { m_targetRollbackFrames = frames; }
+
     // Accessors
     uint32_t GetLastRttMs() const { return m_lastRttMs; }
     float GetLastLatencyMs() const { return m_lastLatencyMs; }
@@ -65,11 +68,29 @@ public:
     static constexpr size_t RTT_SAMPLE_WINDOW = 5;  // Keep last 5 samples
     std::deque<uint32_t> m_rttSamples;
 
+    int m_targetRollbackFrames = TARGET_ROLLBACK_FRAMES;
+
+    // A client predicts about one round trip ahead of the confirmed state,
+    // less one frame per frame of input delay, so the delay is the round
+    // trip in frames beyond the target depth. It moves one frame per update,
+    // and only once off by more than half a frame, so it does not flap.
     void CalculateInputDelayFrames(int tickRate) {
         if (tickRate <= 0) return;
 
+        if (m_targetRollbackFrames < 0) {
+            m_lastInputDelayFrames = 0;
+            return;
+        }
+
         float frameTimeMs = 1000.0f / tickRate;
-        m_lastInputDelayFrames = static_cast<int>(std::ceil(m_lastLatencyMs / frameTimeMs));
+        float wanted = m_lastRttMs / frameTimeMs - m_targetRollbackFrames;
+        if (wanted > m_lastInputDelayFrames + 0.5f) {
+            m_lastInputDelayFrames++;
+        }
+        else if (wanted < m_lastInputDelayFrames - 0.5f) {
+            m_lastInputDelayFrames--;
+        }
+        m_lastInputDelayFrames = std::clamp(m_lastInputDelayFrames, 0, MAX_INPUT_DELAY_FRAMES);
     }
 };
 #pragma once
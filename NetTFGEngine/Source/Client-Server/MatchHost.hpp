@@ -0,0 +1,335 @@
+#pragma once
+
+#include "Client-Server/Server.hpp"
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <cctype>
+#include <string>
+
+struct MatchHostConfig {
+    uint16_t port;
+    size_t workerThreads;       // Threads ticking matches, 0 for one per hardware thread
+    size_t maxMatches;          // Matches running or in lobby at once
+    ServerConfig matchConfig;   // Rules of every match; its port is unused
+    NetworkWaitConfig networkWait;
+
+    MatchHostConfig(uint16_t p = 7777)
+        : port(p)
+        , workerThreads(0)
+        , maxMatches(256)
+        , matchConfig(p)
+    {
+    }
+};
+
+// Runs many independent matches in one process behind a single listen socket.
+//
+// Each match is a Server with its own ServerNetcode and game logic, attached to
+// the host's GNSSession. The host's network thread receives for every match
+// and routes each connection by the match ID in its CLIENT_HELLO, creating the
+// match on first use. Matches are spread over a pool of workers, each ticking
+// its matches on their own schedule.
+class MatchHost {
+public:
+    using GameLogicFactory = std::function<std::unique_ptr<IGameLogic>()>;
+
+    MatchHost(GameLogicFactory factory, const MatchHostConfig& config = MatchHostConfig())
+        : factory_(std::move(factory))
+        , config_(config)
+    {
+    }
+
+    // Serves until Stop is called. Runs the network loop on the calling thread.
+    int Run() {
+        if (!net_.InitGNS()) {
+            return 1;
+        }
+        net_.SetWaitConfig(config_.networkWait);
+
+        if (!net_.InitHost(config_.port)) {
+            return 1;
+        }
+
+        size_t workerCount = config_.workerThreads > 0 ?
+            config_.workerThreads : std::max(1u, std::thread::hardware_concurrency());
+
+        running_.store(true);
+        for (size_t i = 0; i < workerCount; i++) {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+        for (auto& worker : workers_) {
+            Worker* w = worker.get();
+            w->thread = std::thread([this, w]() { WorkerLoop(*w); });
+        }
+
+        Debug::Info("MatchHost") << "Hosting up to " << config_.maxMatches << " matches on port "
+            << config_.port << " with " << workerCount << " workers\n";
+
+        auto nextSweep = std::chrono::steady_clock::now();
+        while (running_.load()) {
+            net_.PumpCallbacks();
+
+            int received = net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
+                Route(conn, data, len);
+                }, false);
+
+            auto now = std::chrono::steady_clock::now();
+            if (now >= nextSweep) {
+                Sweep();
+                nextSweep = now + SWEEP_INTERVAL;
+            }
+
+            net_.WaitAfterPoll(received);
+        }
+
+        for (auto& worker : workers_) {
+            worker->thread.join();
+        }
+        workers_.clear();
+
+        for (auto& [id, match] : matches_) {
+            match->server->CloseHostedConnections();
+        }
+        matches_.clear();
+        connectionMatch_.clear();
+
+        return 0;
+    }
+
+    // Replaces the default GNS transport. Call before Run.
+    void SetTransport(std::shared_ptr<ITransport> transport) {
+        net_.SetTransport(std::move(transport));
+    }
+
+    // Safe from any thread
+    void Stop() {
+        running_.store(false);
+    }
+
+    size_t GetMatchCount() const {
+        return matchCount_.load();
+    }
+
+private:
+    struct Match {
+        std::string id;
+        std::unique_ptr<Server> server;
+        FixedTickScheduler scheduler;         // Owned by the match's worker, started with the game
+        std::atomic<bool> finished{ false };  // Set by the worker, or by the network thread to stop it
+        std::atomic<bool> released{ false };  // Set by the worker once it no longer ticks the match
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mtx;
+        std::vector<std::shared_ptr<Match>> incoming;   // Handed over by the network thread
+    };
+
+    // How often closed connections and finished matches are cleaned up
+    static constexpr std::chrono::milliseconds SWEEP_INTERVAL{ 100 };
+    // Longest a worker sleeps while its matches wait in lobby
+    static constexpr std::chrono::milliseconds WORKER_IDLE_WAIT{ 5 };
+
+    GameLogicFactory factory_;
+    MatchHostConfig config_;
+    GNSSession net_;
+    std::atomic<bool> running_{ false };
+    std::atomic<size_t> matchCount_{ 0 };
+
+    // Only touched by the network thread
+    std::map<std::string, std::shared_ptr<Match>> matches_;
+    std::unordered_map<HSteamNetConnection, std::shared_ptr<Match>> connectionMatch_;
+    size_t nextWorker_ = 0;
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    void Route(HSteamNetConnection conn, const uint8_t* data, int len) {
+        if (len < 1) {
+            return;
+        }
+
+        std::shared_ptr<Match> match;
+        auto it = connectionMatch_.find(conn);
+        if (it != connectionMatch_.end()) {
+            match = it->second;
+        }
+        else {
+            // A connection is bound to a match by its first CLIENT_HELLO
+            if (data[0] != PACKET_CLIENT_HELLO) {
+                return;
+            }
+
+            ClientHelloPacket hello;
+            if (!net_.ParseClientHello(data, len, hello)) {
+                net_.CloseConnection(conn);
+                return;
+            }
+
+            match = FindOrCreateMatch(hello.matchId);
+            if (!match) {
+                Debug::Info("MatchHost") << "Rejecting " << hello.clientId << ": match limit reached\n";
+                net_.CloseConnection(conn);
+                return;
+            }
+            connectionMatch_[conn] = match;
+        }
+
+        if (!match->finished.load()) {
+            match->server->OnHostedPacket(conn, data, len);
+        }
+    }
+
+    // path with the match ID added before its extension. The ID comes from
+    // a client, so only letters, digits, '-' and '_' are kept.
+    static std::string ReplayPathForMatch(const std::string& path, const std::string& matchId) {
+        std::string suffix = "_";
+        for (char c : matchId) {
+            suffix.push_back(std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' ? c : '_');
+        }
+
+        size_t dot = path.find_last_of('.');
+        size_t separator = path.find_last_of("/\\");
+        if (dot == std::string::npos || (separator != std::string::npos && dot < separator)) {
+            return path + suffix;
+        }
+        return path.substr(0, dot) + suffix + path.substr(dot);
+    }
+
+    std::shared_ptr<Match> FindOrCreateMatch(const std::string& id) {
+        auto it = matches_.find(id);
+        if (it != matches_.end()) {
+            return it->second;
+        }
+
+        if (matches_.size() >= config_.maxMatches) {
+            return nullptr;
+        }
+
+        auto match = std::make_shared<Match>();
+        match->id = id;
+        ServerConfig matchConfig = config_.matchConfig;
+        if (!matchConfig.replayPath.empty()) {
+            matchConfig.replayPath = ReplayPathForMatch(matchConfig.replayPath, id);
+        }
+        match->server = std::make_unique<Server>(factory_(), matchConfig, net_);
+        matches_[id] = match;
+        matchCount_.store(matches_.size());
+
+        Worker& worker = *workers_[nextWorker_];
+        nextWorker_ = (nextWorker_ + 1) % workers_.size();
+        {
+            std::lock_guard<std::mutex> lk(worker.mtx);
+            worker.incoming.push_back(match);
+        }
+
+        Debug::Info("MatchHost") << "Created match '" << id << "' (" << matches_.size() << " running)\n";
+        return match;
+    }
+
+    // Lets started matches notice their disconnections, drops routes of closed
+    // connections, and removes finished matches and matches nobody is in. A
+    // match's worker may be in the middle of a tick, so it is only torn down
+    // once the worker has let go of it.
+    void Sweep() {
+        for (auto& [id, match] : matches_) {
+            if (match->server->IsHostedGameStarted() && !match->finished.load()) {
+                match->server->CheckHostedDisconnects();
+            }
+        }
+
+        std::unordered_map<Match*, size_t> openConnections;
+        for (auto it = connectionMatch_.begin(); it != connectionMatch_.end(); ) {
+            if (net_.IsConnectionOpen(it->first)) {
+                openConnections[it->second.get()]++;
+                ++it;
+            }
+            else {
+                it = connectionMatch_.erase(it);
+            }
+        }
+
+        for (auto it = matches_.begin(); it != matches_.end(); ) {
+            Match& match = *it->second;
+
+            // A lobby is gone once everyone left; a running match only when
+            // its players could not come back anyway
+            bool empty = openConnections.find(&match) == openConnections.end();
+            bool abandoned = empty &&
+                (!match.server->IsHostedGameStarted() || !config_.matchConfig.allowReconnection);
+
+            if (!match.finished.load() && !abandoned) {
+                ++it;
+                continue;
+            }
+
+            if (!match.finished.exchange(true)) {
+                Debug::Info("MatchHost") << "Match '" << match.id << "' ended\n";
+            }
+            if (!match.released.load()) {
+                ++it;
+                continue;
+            }
+
+            match.server->CloseHostedConnections();
+            for (auto route = connectionMatch_.begin(); route != connectionMatch_.end(); ) {
+                route = route->second.get() == &match ? connectionMatch_.erase(route) : std::next(route);
+            }
+            it = matches_.erase(it);
+        }
+        matchCount_.store(matches_.size());
+    }
+
+    void WorkerLoop(Worker& worker) {
+        std::vector<std::shared_ptr<Match>> owned;
+
+        while (running_.load()) {
+            {
+                std::lock_guard<std::mutex> lk(worker.mtx);
+                for (auto& match : worker.incoming) {
+                    owned.push_back(std::move(match));
+                }
+                worker.incoming.clear();
+            }
+
+            auto now = FixedTickScheduler::Clock::now();
+            auto wakeAt = now + WORKER_IDLE_WAIT;
+
+            for (auto& match : owned) {
+                if (match->finished.load() || !match->server->IsHostedGameStarted()) {
+                    continue;
+                }
+
+                FixedTickScheduler& scheduler = match->scheduler;
+                if (!scheduler.IsStarted()) {
+                    scheduler = FixedTickScheduler(config_.matchConfig.ticksPerSecond);
+                    scheduler.Start(now);
+                }
+
+                if (scheduler.IsDue(now)) {
+                    if (!match->server->TickHosted(scheduler.NextTickTime())) {
+                        match->finished.store(true);
+                        continue;
+                    }
+                    scheduler.Advance();
+                }
+
+                wakeAt = std::min(wakeAt, scheduler.NextTickTime());
+            }
+
+            // The network thread tears finished matches down once the worker
+            // has let go of them
+            owned.erase(std::remove_if(owned.begin(), owned.end(),
+                [](const std::shared_ptr<Match>& match) {
+                    if (!match->finished.load()) {
+                        return false;
+                    }
+                    match->released.store(true);
+                    return true;
+                }),
+                owned.end());
+
+            std::this_thread::sleep_until(wakeAt);
+        }
+    }
+};
@@ -17,6 +17,8 @@
 
 #include "Client-Server/Client.hpp"
 #include "Client-Server/InputDelayCalculator.hpp"
+#include "Client-Server/TimeSync.hpp"
+#include "Client-Server/ClientPacketHandler.hpp"
 
 #include "NetTFG_Engine.hpp"
 
@@ -89,6 +91,11 @@ public:
 
         gameRenderer_->playerId = assignedPlayerId_;
 
+        gameLogic_->ticksPerSecond = ticksPerSecond_;
+        cWindow_->setTickRate(ticksPerSecond_);
+        cWindow_->setSnapshotInterval(snapshotInterval_);
+        timeSync_.SetTickRate(ticksPerSecond_);
+        packets_.SetTickRate(ticksPerSecond_);
         prediction_ = new ClientPredictionNetcode(assignedPlayerId_, std::move(gameLogic_));
 
         if (isReconnection_)
@@ -115,38 +122,11 @@ public:
 
 
     void TickClient() override {
-
-
-        InputBlob localInput = prediction_->GetGameLogic()->GenerateLocalInput();
-        int frameToSubmit = prediction_->SubmitLocalInput(localInput);
-        net_.SendInput(serverConnection_, assignedPlayerId_, frameToSubmit, localInput);
-
-        // Predict to current frame (mutex-protected)
-        prediction_->Tick();
-        cWindow_->setLocalState(prediction_->GetCurrentState());
-
-        HashPacket hashPacket;
-        GameStateBlob currentServerState = prediction_->GetLatestServerState();
-        hashPacket.frame = currentServerState.frame;
-        prediction_->GetGameLogic()->HashState(currentServerState, hashPacket.hash);
-
-        net_.SendHashPacket(serverConnection_, hashPacket, hashPacket.frame);
-
-        // ===== Debug output every 30 frames =====
-        if (frameToSubmit % 30 == 0) {
-            GameStateBlob s = prediction_->GetCurrentState();
-            Debug::Info("OnlineClient") << "[CLIENT] Frame: " << frameToSubmit
-                << " | Latency: " << inputDelayCalc.GetLastLatencyMs()
-                << "ms | InputDelayFrames: " << inputDelayCalc.GetInputDelayFrames() << "\n";
-
-            // Send RTT sync
-            InputDelayPacket packet;
-            packet.playerId = assignedPlayerId_;
-            packet.timestamp = inputDelayCalc.GetTimestampMs();
-            net_.SendInputDelaySync(serverConnection_, packet);
+        // Time sync runs extra ticks to catch up with the server, or none to fall back
+        int ticks = timeSync_.TakeTicksDue(prediction_->GetCurrentFrame());
+        for (int i = 0; i < ticks; i++) {
+            TickFrame();
         }
-
-
     }
 
     void CloseClient() override {
@@ -170,15 +150,21 @@ public:
         }
 
         if (serverConnection_ != k_HSteamNetConnection_Invalid) {
-            net_.GetSockets()->CloseConnection(serverConnection_,
-                k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            net_.CloseConnection(serverConnection_);
+            // Give the transport time to send the close
+            net_.WaitForTraffic(100);
             serverConnection_ = k_HSteamNetConnection_Invalid;
         }
 
         // Reset per-session state so the next SetupClient starts clean
         assignedPlayerId_ = -1;
         isReconnection_ = false;
+        packets_.Reset();
+        hashCheckInterval_ = 0;
+        ticksPerSecond_ = DEFAULT_TICKS_PER_SECOND;
+        snapshotInterval_ = 1;
+        lastHashedFrame_ = -1;
+        timeSync_.Reset();
 
         Debug::Info("OnlineClient") << "[ONLINE] Online client finished\n";
     }
@@ -193,14 +179,110 @@ public:
 
     const std::string& GetClientId() const { return clientId_; }
 
+    int GetTicksPerSecond() const override { return ticksPerSecond_; }
+
+    double GetTickTimeScale() const override { return timeSync_.GetTimeScale(); }
+
+    // Match to join when the server hosts several; sent in CLIENT_HELLO
+    void SetMatchId(const std::string& matchId) { matchId_ = matchId; }
+
+    // State updates to ask the server for per second, 0 for its default.
+    // Call before SetupClient.
+    void SetSnapshotRate(int snapshotsPerSecond) { snapshotsPerSecond_ = snapshotsPerSecond; }
+
+    // Rollback depth the adaptive input delay aims for, negative to never
+    // delay local inputs. Call before SetupClient.
+    void SetTargetRollbackFrames(int frames) { inputDelayCalc.SetTargetRollbackFrames(frames); }
+
+    // Spin-then-block behaviour of the receive loop
+    void SetNetworkWaitConfig(const NetworkWaitConfig& config) { net_.SetWaitConfig(config); }
+
+    // Replaces the default GNS transport. Call before SetupClient.
+    void SetTransport(std::shared_ptr<ITransport> transport) { net_.SetTransport(std::move(transport)); }
+
 private:
+    // One frame: send the local input, predict, check for desyncs
+    void TickFrame() {
+        // Predicted as far as allowed: wait for the server to confirm more
+        if (!prediction_->CanAdvance()) {
+            if (stalledTicks_++ % 30 == 0) {
+                Debug::Info("OnlineClient") << "[CLIENT] Prediction window full at frame "
+                    << prediction_->GetCurrentFrame() << ", stalling\n";
+            }
+            return;
+        }
+        stalledTicks_ = 0;
+
+        int frameToSubmit = prediction_->GetCurrentFrame();
+        net_.SetFrameReference(frameToSubmit);
+
+        InputBlob localInput = prediction_->GetGameLogic()->GenerateLocalInput();
+        submittedInputs_.clear();
+        prediction_->SubmitLocalInput(localInput, submittedInputs_);
+        for (const InputEntry& entry : submittedInputs_) {
+            packets_.QueueLocalInput(entry);
+        }
+        net_.SendInputWindow(serverConnection_, assignedPlayerId_, packets_.GetUnackedInputs());
+
+        // Let the server know which state it can stop worrying about
+        net_.SendStateAck(serverConnection_, prediction_->GetLastConfirmedFrame());
+
+        // Predict to current frame (mutex-protected)
+        prediction_->Tick();
+        cWindow_->setLocalState(prediction_->GetCurrentState());
+
+        // Desync check on the latest confirmed state, every hashCheckInterval_ frames
+        if (hashCheckInterval_ > 0 &&
+            prediction_->GetLastConfirmedFrame() >= lastHashedFrame_ + hashCheckInterval_) {
+            HashPacket hashPacket;
+            GameStateBlob currentServerState = prediction_->GetLatestServerState();
+            hashPacket.frame = currentServerState.frame;
+            hashPacket.hash = prediction_->GetGameLogic()->HashState(currentServerState);
+            lastHashedFrame_ = hashPacket.frame;
+
+            net_.SendHashPacket(serverConnection_, hashPacket);
+        }
+
+        // ===== Debug output every 30 frames =====
+        if (frameToSubmit % 30 == 0) {
+            GameStateBlob s = prediction_->GetCurrentState();
+            Debug::Info("OnlineClient") << "[CLIENT] Frame: " << frameToSubmit
+                << " | Latency: " << inputDelayCalc.GetLastLatencyMs()
+                << "ms | Input delay: " << prediction_->GetInputDelay()
+                << " frames | Input lead: " << timeSync_.GetInputLeadUs() / 1000.0
+                << "ms | Time scale: " << timeSync_.GetTimeScale()
+                << " | Render delay: " << cWindow_->getServerPlaybackDelayMs() << "ms\n";
+
+            for (const auto& [player, guesses] : prediction_->GetInputPredictionStats()) {
+                Debug::Info("OnlineClient") << "[CLIENT] Player " << player << " inputs: "
+                    << guesses.predicted << " predicted, " << guesses.GetMispredictionRate() * 100.0 << "% wrong\n";
+            }
+
+            // Send RTT sync
+            InputDelayPacket packet;
+            packet.playerId = assignedPlayerId_;
+            packet.timestamp = inputDelayCalc.GetTimestampMs();
+            net_.SendInputDelaySync(serverConnection_, packet);
+        }
+
+        // Input window, acks and hash leave together in one datagram
+        net_.FlushOutgoing();
+    }
+
     GNSSession net_;
     InputDelayCalculator inputDelayCalc;
     std::unique_ptr<IGameLogic> gameLogic_;
     std::unique_ptr<IGameRenderer> gameRenderer_;
     std::string clientId_;
+    std::string matchId_;
+    int snapshotsPerSecond_ = 0;
     int assignedPlayerId_;
     bool isReconnection_;
+    int hashCheckInterval_ = 0;     // Announced by the server, 0 when it does not check
+    int ticksPerSecond_ = DEFAULT_TICKS_PER_SECOND;     // Announced by the server
+    int snapshotInterval_ = 1;                          // Announced by the server
+    TimeSync timeSync_;
+    int lastHashedFrame_ = -1;
     HSteamNetConnection serverConnection_;
 
     ClientPredictionNetcode* prediction_ = nullptr;
@@ -209,6 +291,12 @@ private:
     std::atomic<bool> networkRunning_;
     std::thread networkThread_;
 
+    // Game packets from the server, handled on the network thread, and the
+    // window of unacked local inputs
+    ClientPacketHandler packets_{ net_, timeSync_, inputDelayCalc };
+    std::vector<InputEntry> submittedInputs_;
+    int stalledTicks_ = 0;
+
     std::string GenerateClientId() {
         auto now = std::chrono::system_clock::now();
         auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -219,19 +307,18 @@ private:
 
     bool SendClientHello() {
         ClientHelloPacket hello;
-        hello.type = PACKET_CLIENT_HELLO;
 
         std::strncpy(hello.clientId, clientId_.c_str(), sizeof(hello.clientId) - 1);
+        std::strncpy(hello.matchId, matchId_.c_str(), sizeof(hello.matchId) - 1);
+        hello.snapshotsPerSecond = snapshotsPerSecond_;
         hello.clientId[sizeof(hello.clientId) - 1] = '\0';
 
-        ISteamNetworkingSockets* sockets = net_.GetSockets();
-        if (!sockets || serverConnection_ == k_HSteamNetConnection_Invalid) {
+        if (!net_.GetTransport() || serverConnection_ == k_HSteamNetConnection_Invalid) {
             Debug::Info("OnlineClient") << "Failed to send client hello: invalid connection\n";
             return false;
         }
 
-        sockets->SendMessageToConnection(serverConnection_, &hello,
-            sizeof(hello), k_nSteamNetworkingSend_Reliable, nullptr);
+        net_.SendClientHello(serverConnection_, hello);
 
         Debug::Info("OnlineClient") << "Sent CLIENT_HELLO with ID: " << clientId_ << "\n";
         return true;
@@ -252,27 +339,31 @@ private:
                     return;
                 }
                 uint8_t type = data[0];
-                if (type == PACKET_STATE_UPDATE) {
-                    StateUpdate update = net_.ParseStateUpdate(data, len);
+                StateUpdate update;
+                if (type == PACKET_STATE_UPDATE && net_.ParseStateUpdate(data, len, update)) {
+                    net_.SetFrameReference(update.frame);
                     prediction.OnServerStateUpdate(update);
                     stateReceived = true;
                     Debug::Info("OnlineClient") << "Received state update after reconnection\n";
                 }
                 }, true);
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            net_.WaitForTraffic(50);
         }
         return running && stateReceived;
     }
 
     bool HandleServerAccept(const uint8_t* data, int len) {
-        if (len < sizeof(ServerAcceptPacket)) {
+        ServerAcceptPacket accept;
+        if (!net_.ParseServerAccept(data, len, accept)) {
             Debug::Info("OnlineClient") << "Malformed SERVER_ACCEPT packet\n";
             return false;
         }
 
-        const ServerAcceptPacket* accept = (const ServerAcceptPacket*)data;
-        assignedPlayerId_ = accept->playerId;
-        isReconnection_ = accept->isReconnection;
+        assignedPlayerId_ = accept.playerId;
+        isReconnection_ = accept.isReconnection;
+        hashCheckInterval_ = accept.hashCheckInterval;
+        ticksPerSecond_ = ClampTickRate(accept.ticksPerSecond);
+        snapshotInterval_ = std::max(accept.snapshotInterval, 1);
 
         if (isReconnection_) {
             Debug::Info("OnlineClient") << "Reconnected as Player ID: " << assignedPlayerId_ << "\n";
@@ -290,18 +381,16 @@ private:
     }
 
     bool HandleGameStart(const uint8_t* data, int len, bool& gameStarted) {
-        if (len < 1 + 4) {
-            Debug::Info("OnlineClient") << "Malformed GAME_START packet\n";
+        if (data[0] != PACKET_GAME_START) {
             return false;
         }
 
-        if (data[0] != PACKET_GAME_START) {
+        GameStartPacket start;
+        if (!net_.ParseGameStart(data, len, start)) {
+            Debug::Info("OnlineClient") << "Malformed GAME_START packet\n";
             return false;
         }
-
-        uint32_t playerIdNet = 0;
-        std::memcpy(&playerIdNet, data + 1, 4);
-        int playerIdFromStart = bigEndianToHost32(playerIdNet);
+        int playerIdFromStart = start.playerId;
 
         if (assignedPlayerId_ != -1 && assignedPlayerId_ != playerIdFromStart) {
             Debug::Info("OnlineClient") << "WARNING: GAME_START player ID mismatch ("
@@ -309,6 +398,7 @@ private:
         }
 
         assignedPlayerId_ = playerIdFromStart;
+        ticksPerSecond_ = ClampTickRate(start.ticksPerSecond);
         gameStarted = true;
 
         Debug::Info("OnlineClient") << "Game starting with Player ID: " << assignedPlayerId_ << "\n";
@@ -352,8 +442,7 @@ private:
 
         // Wait for connection to establish
         while (!connected && running && ClientWindow::isWindowThreadRunning()) {
-            ISteamNetworkingSockets* sockets = net_.GetSockets();
-            if (!sockets) {
+            if (!net_.GetTransport()) {
                 running = false;
                 break;
             }
@@ -361,27 +450,24 @@ private:
             // Check connection state
             serverConnection_ = net_.GetConnectedConnection();
             if (serverConnection_ != k_HSteamNetConnection_Invalid) {
-                SteamNetConnectionInfo_t connInfo;
-                if (sockets->GetConnectionInfo(serverConnection_, &connInfo)) {
-                    if (connInfo.m_eState == k_ESteamNetworkingConnectionState_Connected) {
-                        connected = true;
-                        Debug::Info("OnlineClient") << "Connected to server\n";
-
-                        if (!SendClientHello()) {
-                            running = false;
-                        }
-                        break;
-                    }
-                    else if (connInfo.m_eState == k_ESteamNetworkingConnectionState_ClosedByPeer ||
-                        connInfo.m_eState == k_ESteamNetworkingConnectionState_Dead) {
-                        Debug::Info("OnlineClient") << "Connection to server failed\n";
+                TransportState state = net_.GetConnectionState(serverConnection_);
+                if (state == TRANSPORT_CONNECTED) {
+                    connected = true;
+                    Debug::Info("OnlineClient") << "Connected to server\n";
+
+                    if (!SendClientHello()) {
                         running = false;
-                        break;
                     }
+                    break;
+                }
+                else if (state == TRANSPORT_CLOSED) {
+                    Debug::Info("OnlineClient") << "Connection to server failed\n";
+                    running = false;
+                    break;
                 }
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            net_.WaitForTraffic(50);
         }
 
         if (!running || !connected || !ClientWindow::isWindowThreadRunning()) {
@@ -406,7 +492,7 @@ private:
                 }
                 }, true);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            net_.WaitForTraffic(50);
         }
 
         return running && serverAccepted && assignedPlayerId_ != -1;
@@ -435,91 +521,12 @@ private:
                 }
                 }, true);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            net_.WaitForTraffic(100);
         }
 
         return running && gameStarted;
     }
 
-    // ============================================================================
-    // FIXED ProcessIncomingPacket - frame synchronized
-    // ============================================================================
-
-    void ProcessIncomingPacket(ClientPredictionNetcode& prediction,
-        ClientWindow& cWin,
-        const uint8_t* data,
-        int len,
-        HSteamNetConnection conn)
-    {
-        if (len < 1) {
-            return;
-        }
-
-        uint8_t type = data[0];
-
-        if (type == PACKET_STATE_UPDATE) {
-            bool correctPacket = true;
-            uint32_t lenVector = 0;
-            uint32_t lenState = 0;
-
-            std::memcpy(&lenState, data + 1 + 4, sizeof(uint32_t));
-            lenState = bigEndianToHost32(lenState);
-
-            if (len >= 1 + 4 + 4 + lenState) {
-                correctPacket = true;
-            }
-
-            if (correctPacket) {
-                StateUpdate update = net_.ParseStateUpdate(data, len);
-
-                prediction.OnServerStateUpdate(update);
-                cWin.setServerState(prediction.GetLatestServerState());
-            }
-            else {
-                Debug::Info("OnlineClient") << "[CLIENT] Received malformed PACKET_STATE_UPDATE, len=" << len << "\n";
-            }
-        }
-        else if (type == PACKET_DELTA_STATE_UPDATE) {
-            std::vector<DeltaStateBlob> deltas;
-            int frame;
-
-            net_.ParseDeltasUpdate(data, len, deltas, frame);
-            //Debug::Info("OnlineClient") << "Parsed delta packet: frame=" << frame
-            //    << " deltas=" << deltas.size() << "\n";
-
-            prediction.OnServerDeltasUpdate(deltas, frame);
-            cWin.setServerState(prediction.GetLatestServerState());
-        }
-        else if (type == PACKET_INPUT_UPDATE) {
-            const size_t EXPECTED_MIN_LEN = 1 + 4 + 4 + sizeof(InputBlob);
-
-            if (len < EXPECTED_MIN_LEN) {
-                Debug::Info("OnlineClient") << "[CLIENT] Malformed input packet, len=" << len << "\n";
-            }
-            else {
-                InputEntry ie = net_.ParseInputEntryPacket(data, len);
-                prediction.OnServerInputUpdate(ie);
-            }
-        }
-        else if (type == PACKET_EVENT_UPDATE) {
-            const size_t EXPECTED_MIN_LEN = 1 + 4 + 4;
-            if (len < EXPECTED_MIN_LEN) {
-                Debug::Info("OnlineClient") << "[CLIENT] Malformed event packet, len=" << len << "\n";
-            }
-            else {
-                EventEntry event = net_.ParseEventEntryPacket(data, len);
-                prediction.OnServerEventUpdate(event);
-            }
-        }
-        else if (type == PACKET_INPUT_DELAY) {
-            // ===== FIX: Validate RTT with bounds checking =====
-            InputDelayPacket packet = net_.ParseInputDelaySync(data, len);
-            inputDelayCalc.UpdateRtt(packet.timestamp, TICKS_PER_SECOND);
-
-            prediction.UpdateCurrentFrame(inputDelayCalc.GetInputDelayFrames());
-        }
-    }
-
     // Network thread function - processes packets directly
     void NetworkThread(ClientPredictionNetcode& prediction,
         ClientWindow& cWindow,
@@ -529,12 +536,15 @@ private:
 
             // Poll and process packets immediately
             // ClientPredictionNetcode's mutex protects shared state
-            net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
-                ProcessIncomingPacket(prediction, cWindow, data, len, conn);
+            int received = net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
+                ServerPacketKind kind = packets_.Handle(prediction, data, len, conn);
+                if (kind == SERVER_PACKET_FULL_STATE || kind == SERVER_PACKET_STATE_CHANGE) {
+                    cWindow.setServerState(prediction.GetLatestServerState());
+                }
                 }, false);
 
-            // Small sleep to prevent busy-waiting (1ms = ~1000 polls/sec)
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            // Wakes as soon as the next datagram arrives
+            net_.WaitAfterPoll(received);
         }
     }
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "netcode/netcode_common.hpp"
+#include "netcode/replay.hpp"
+#include "Client-Server/TickStats.hpp"
+#include "Utils/Debug/Debug.hpp"
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+struct ReplayRunConfig {
+    bool verifyHashes;          // Hash every frame and compare it to the recording
+    bool stopAtMismatch;        // End the run at the first frame that differs
+    std::shared_ptr<TickStats> frameStats;  // Optional sink for the duration of every frame
+
+    ReplayRunConfig()
+        : verifyHashes(true)
+        , stopAtMismatch(false)
+    {
+    }
+};
+
+// Re-simulates a recorded match through IGameLogic::SimulateFrame as fast as
+// it goes, with no network and no tick pacing, checking every frame's state
+// hash against the one the server recorded. A replay of a real match becomes
+// a benchmark of simulation speed and a regression test of determinism.
+//
+// The game logic runs as the server did. It is initialised with the recorded
+// seed and only synchronized to the recorded state when Init does not already
+// produce it, so state that Init builds but Synchronize cannot restore, such
+// as random number generators, matches replays started at frame 0.
+class ReplayRunner {
+public:
+    struct Stats {
+        uint64_t frames = 0;
+        uint64_t hashesChecked = 0;
+        uint64_t mismatches = 0;
+        int firstMismatchFrame = -1;
+        bool synchronized = false;        // Init did not reproduce the recorded state
+        bool damaged = false;             // A record could not be read; the run ended there
+        double seconds = 0.0;             // Time spent simulating, hashing included
+    };
+
+    ReplayRunner(std::unique_ptr<IGameLogic> gameLogic, const ReplayRunConfig& config = ReplayRunConfig())
+        : gameLogic_(std::move(gameLogic))
+        , config_(config)
+    {
+    }
+
+    // Plays reader from its next frame to the end. False if hashes differed
+    // or the replay was damaged.
+    bool Run(ReplayReader& reader) {
+        stats_ = Stats{};
+        const ReplayHeader& header = reader.GetHeader();
+
+        gameLogic_->isServer = true;
+        gameLogic_->ticksPerSecond = header.ticksPerSecond;
+        gameLogic_->randomSeed = header.randomSeed;
+        gameLogic_->gameFinished = false;
+
+        GameStateBlob state;
+        gameLogic_->Init(state);
+        if (state.len != header.state.len ||
+            gameLogic_->HashState(state) != gameLogic_->HashState(header.state)) {
+            state = header.state;
+            gameLogic_->Synchronize(state);
+            stats_.synchronized = true;
+        }
+        state.frame = header.startFrame;
+
+        using Clock = std::chrono::steady_clock;
+        Clock::duration total{};
+        ReplayFrame record;
+
+        while (reader.ReadFrame(record)) {
+            auto frameStart = Clock::now();
+
+            gameLogic_->SimulateFrame(state, std::move(record.events), std::move(record.inputs));
+            state.frame = record.frame + 1;
+
+            bool matches = true;
+            if (config_.verifyHashes) {
+                matches = gameLogic_->HashState(state) == record.hash;
+                stats_.hashesChecked++;
+            }
+
+            auto frameTime = Clock::now() - frameStart;
+            total += frameTime;
+            if (config_.frameStats) {
+                config_.frameStats->Record(std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count());
+            }
+            stats_.frames++;
+
+            if (!matches) {
+                if (stats_.mismatches++ == 0) {
+                    stats_.firstMismatchFrame = record.frame;
+                    Debug::Error("Replay") << "State after frame " << record.frame << " differs from the recording\n";
+                }
+                if (config_.stopAtMismatch) {
+                    break;
+                }
+            }
+        }
+
+        stats_.damaged = !reader.AtEnd() && !(config_.stopAtMismatch && stats_.mismatches > 0);
+        stats_.seconds = std::chrono::duration<double>(total).count();
+        return stats_.mismatches == 0 && !stats_.damaged;
+    }
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    std::unique_ptr<IGameLogic> gameLogic_;
+    ReplayRunConfig config_;
+    Stats stats_;
+};
@@ -5,6 +5,10 @@
 #include "netcode/netcode_common.hpp"
 #include "netcode/server_netcode.hpp"
 #include "netcode/valve_sockets_session.hpp"
+#include "netcode/tick_scheduler.hpp"
+#include "netcode/send_scheduler.hpp"
+#include "netcode/interest_grid.hpp"
+#include "Client-Server/TickStats.hpp"
 #include "Utils/Debug/Debug.hpp"
 #include <set>
 #include <map>
@@ -16,16 +20,16 @@
 #include <string>
 #include <sstream>
 #include <cstdint>
+#include <algorithm>
+#include <deque>
 
-std::string HashToString(const uint8_t hash[SHA256_DIGEST_LENGTH]) {
+std::string HashToString(StateHash hash) {
     static const char hexDigits[] = "0123456789abcdef";
     std::string str;
-    str.reserve(SHA256_DIGEST_LENGTH * 2); // 64 chars for SHA-256
+    str.reserve(sizeof(StateHash) * 2);
 
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        uint8_t byte = hash[i];
-        str.push_back(hexDigits[byte >> 4]);      // high nibble
-        str.push_back(hexDigits[byte & 0x0F]);    // low nibble
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        str.push_back(hexDigits[(hash >> shift) & 0x0F]);
     }
 
     return str;
@@ -41,7 +45,16 @@ struct ServerConfig {
     bool allowReconnection;
     bool requireClientId;
     int maxFrames;
+    int ticksPerSecond;        // Simulation rate, announced to clients when they join
+    int snapshotsPerSecond;    // State updates sent to clients that do not ask for a rate, 0 for every tick
+    int deltaBudgetBytes;      // Cap on the deltas in each update to a client, 0 for no cap
+    float interestRadius;      // Entities and events further than this from a client are not sent to it, 0 to send everything
     std::chrono::seconds reconnectionTimeout;
+    bool enableHashCheck;      // Compare client state hashes to detect desyncs
+    int hashCheckInterval;     // Frames between hashes sent by each client
+    NetworkWaitConfig networkWait;  // Spin-then-block behaviour of the receive loop
+    std::shared_ptr<TickStats> tickStats;  // Optional sink for the duration of every tick
+    std::string replayPath;    // Record the match to this file for a ReplayRunner, empty to not record
 
     ServerConfig(uint16_t p = 7777)
         : port(p)
@@ -52,7 +65,13 @@ struct ServerConfig {
         , allowReconnection(false)
         , requireClientId(false)
         , maxFrames(0)
+        , ticksPerSecond(DEFAULT_TICKS_PER_SECOND)
+        , snapshotsPerSecond(0)
+        , deltaBudgetBytes(0)
+        , interestRadius(0.0f)
         , reconnectionTimeout(30)
+        , enableHashCheck(true)
+        , hashCheckInterval(30)
     {
     }
 };
@@ -66,6 +85,24 @@ public:
         , running_(true)
         , activePlayerCount_(0)
     {
+        config_.ticksPerSecond = ClampTickRate(config_.ticksPerSecond);
+        server_.GetGameLogic()->ticksPerSecond = config_.ticksPerSecond;
+    }
+
+    // A match of a MatchHost: shares host's listen socket and is driven by the
+    // host's threads through the Hosted* calls instead of RunServer
+    Server(std::unique_ptr<IGameLogic> gameLogic,
+        const ServerConfig& config,
+        GNSSession& host)
+        : Server(std::move(gameLogic), config)
+    {
+        net_.AttachTo(host);
+    }
+
+    // Replaces the default GNS transport, e.g. with a LoopbackTransport.
+    // Call before RunServer.
+    void SetTransport(std::shared_ptr<ITransport> transport) {
+        net_.SetTransport(std::move(transport));
     }
 
     int RunServer() {
@@ -73,6 +110,7 @@ public:
         if (!net_.InitGNS()) {
             return 1;
         }
+        net_.SetWaitConfig(config_.networkWait);
 
         if (!net_.InitHost(config_.port)) {
             return 1;
@@ -85,6 +123,7 @@ public:
         }
 
         BroadcastGameStart();
+        net_.FlushOutgoing();
 
         Debug::Info("Server") << "Starting server game loop.\n";
         RunServerLoop();
@@ -92,19 +131,134 @@ public:
         return 0;
     }
 
+    // Packet from one of this match's connections, or a CLIENT_HELLO the host
+    // routed here. Called on the host's network thread; starts the game as
+    // soon as enough players have joined.
+    void OnHostedPacket(HSteamNetConnection conn, const uint8_t* data, int len) {
+        if (len < 1) {
+            return;
+        }
+
+        if (gameStarted_.load()) {
+            HandleReceiveEventInGame(conn, data, len);
+            return;
+        }
+
+        if (data[0] != PACKET_CLIENT_HELLO) {
+            return;
+        }
+
+        HandleClientHello(conn, data, len);
+
+        if (peerInfo_.size() >= config_.minPlayers) {
+            BroadcastGameStart();
+            net_.FlushOutgoing();
+            BeginGame();
+            gameStarted_.store(true);
+        }
+    }
+
+    bool IsHostedGameStarted() const { return gameStarted_.load(); }
+
+    // Ends the game after the current tick. Safe from any thread.
+    void Stop() {
+        running_ = false;
+    }
+
+    // One simulation step, called by a host worker at the tick rate. False
+    // once the match is over.
+    bool TickHosted(FixedTickScheduler::Clock::time_point scheduledTick) {
+        if (!IsGameRunning()) {
+            return false;
+        }
+        TickOnce(scheduledTick);
+        return IsGameRunning();
+    }
+
+    // Queues connections GNS reports closed for the match's next tick. Called
+    // on the host's network thread.
+    void CheckHostedDisconnects() {
+        QueueDisconnects();
+    }
+
+    // Only once no worker ticks the match any more
+    void CloseHostedConnections() {
+        for (auto& [conn, info] : peerInfo_) {
+            net_.CloseConnection(conn);
+        }
+        peerInfo_.clear();
+
+        std::lock_guard<std::mutex> lk(inputAcksMtx_);
+        inputAckFrames_.clear();
+    }
+
 private:
     GNSSession net_;
     ServerNetcode server_;
     ServerConfig config_;
     std::map<HSteamNetConnection, PeerInfo> peerInfo_;
     std::vector<PeerInfo> allPlayers_;
-    bool running_;
+    std::atomic<bool> running_;
     size_t activePlayerCount_;
     std::set<int> pendingReconnections_;
+    std::atomic<bool> gameStarted_{ false };   // Only used when hosted by a MatchHost
+
+    // When frame 0 would have been simulated at the current schedule, in
+    // steady clock microseconds, so the network thread can tell how early each
+    // input arrived. Set by every tick.
+    static constexpr int64_t NO_TICK_YET = INT64_MIN;
+    static constexpr int64_t MAX_REPORTED_LEAD_US = 10000000;
+    std::atomic<int64_t> frameZeroDueUs_{ NO_TICK_YET };
+
+    // Hash checks received by the network thread, compared on the simulation
+    // thread so hashing a state never blocks packet handling
+    struct PendingHashCheck {
+        HSteamNetConnection conn = k_HSteamNetConnection_Invalid;
+        HashPacket packet;
+    };
+    MpscQueue<PendingHashCheck, 256> pendingHashChecks_;
+
+    // State acks, hash trees and hellos received during the game. They change
+    // what the server keeps about a client, so the network thread queues them
+    // for the simulation thread, which owns peerInfo_.
+    struct PendingPeerPacket {
+        HSteamNetConnection conn = k_HSteamNetConnection_Invalid;
+        std::vector<uint8_t> data;
+    };
+    MpscQueue<PendingPeerPacket, 1024> pendingPeerPackets_;
+
+    // Newest input frame acked to each client, kept apart from peerInfo_ for
+    // the network thread. Clients are added and removed with peerInfo_.
+    std::mutex inputAcksMtx_;
+    std::map<HSteamNetConnection, int> inputAckFrames_;
+
+    // Connections found closed by the network thread, dropped by the next tick
+    MpscQueue<HSteamNetConnection, 256> pendingDisconnects_;
 
     std::vector<long long> tickDurations_;
     const size_t MAX_SAMPLES = 30;
 
+    // Events generated since the oldest state update still owed to a client
+    struct PendingEvent {
+        int frame = 0;      // Frame of the tick that generated it
+        EventEntry event;
+    };
+    std::deque<PendingEvent> pendingEvents_;
+
+    // Deltas held back from each client by the byte budget or its area of
+    // interest. Only touched by the simulation thread.
+    std::map<HSteamNetConnection, DeltaSendScheduler> deltaSchedulers_;
+
+    // Entity positions of the current tick, when interest management is on
+    InterestGrid interestGrid_;
+
+    // Where a client is looking this tick
+    struct ClientView {
+        bool everything = true;     // No interest management, or no viewer
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
     bool IsValidClientId(const std::string& clientId) {
         if (clientId.empty() || clientId.length() > 63) {
             return false;
@@ -120,15 +274,45 @@ private:
 
     void SendServerAccept(HSteamNetConnection conn, int playerId, bool isReconnection) {
         ServerAcceptPacket accept;
-        accept.type = PACKET_SERVER_ACCEPT;
         accept.playerId = playerId;
         accept.isReconnection = isReconnection;
+        accept.hashCheckInterval = config_.enableHashCheck ? std::max(config_.hashCheckInterval, 1) : 0;
+        accept.ticksPerSecond = config_.ticksPerSecond;
 
-        ISteamNetworkingSockets* sockets = net_.GetSockets();
-        if (sockets) {
-            sockets->SendMessageToConnection(conn, &accept,
-                sizeof(accept), k_nSteamNetworkingSend_Reliable, nullptr);
+        auto it = peerInfo_.find(conn);
+        if (it != peerInfo_.end()) {
+            accept.snapshotInterval = it->second.snapshotInterval;
         }
+
+        net_.SendServerAccept(conn, accept);
+    }
+
+    // Ticks between state updates for a client asking for snapshotsPerSecond
+    int SnapshotIntervalFor(int snapshotsPerSecond) const {
+        int rate = snapshotsPerSecond > 0 ? snapshotsPerSecond : config_.snapshotsPerSecond;
+        if (rate <= 0) {
+            return 1;
+        }
+        rate = std::clamp(rate, 1, config_.ticksPerSecond);
+        return std::max(1, static_cast<int>(std::lround(static_cast<double>(config_.ticksPerSecond) / rate)));
+    }
+
+    // The client's first state update comes with the next tick
+    void StartSnapshots(PeerInfo& peer, int snapshotsPerSecond) {
+        peer.snapshotInterval = SnapshotIntervalFor(snapshotsPerSecond);
+        peer.lastSnapshotFrame = server_.GetCurrentFrame() - 1;
+    }
+
+    // Lets the network thread take inputs from conn, acking from the first.
+    // Called wherever a connection joins peerInfo_.
+    void TrackInputAcks(HSteamNetConnection conn) {
+        std::lock_guard<std::mutex> lk(inputAcksMtx_);
+        inputAckFrames_[conn] = -1;
+    }
+
+    void UntrackInputAcks(HSteamNetConnection conn) {
+        std::lock_guard<std::mutex> lk(inputAcksMtx_);
+        inputAckFrames_.erase(conn);
     }
 
     PeerInfo* FindPlayerByClientId(const std::string& clientId) {
@@ -154,26 +338,26 @@ private:
     bool HandleNewConnectionInGame(HSteamNetConnection conn, const std::string& clientId) {
         if (!config_.allowMidGameJoin) {
             Debug::Info("Server") << "New connection rejected (mid-game join disabled): " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
         if (peerInfo_.size() >= config_.maxPlayers) {
             Debug::Info("Server") << "New connection rejected: server full ("
                 << peerInfo_.size() << "/" << config_.maxPlayers << ")\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
         if (config_.requireClientId && !IsValidClientId(clientId)) {
             Debug::Info("Server") << "New connection rejected (invalid client ID): " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
         if (IsClientIdInUse(clientId)) {
             Debug::Info("Server") << "New connection rejected (duplicate ID): " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
@@ -185,6 +369,7 @@ private:
         info.playerId = static_cast<int>(allPlayers_.size());
         allPlayers_.push_back(info);
         peerInfo_[conn] = info;
+        TrackInputAcks(conn);
 
         Debug::Info("Server") << "Player " << info.playerId
             << " (" << clientId << ") joined mid-game\n";
@@ -200,7 +385,7 @@ private:
 
         if (!playerInfo || playerInfo->isConnected) {
             Debug::Info("Server") << "Unknown client attempted reconnection: " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
@@ -210,7 +395,7 @@ private:
 
         if (elapsed > config_.reconnectionTimeout && config_.reconnectionTimeout.count() > 0) {
             Debug::Info("Server") << "Reconnection timeout exceeded for " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
@@ -220,6 +405,7 @@ private:
         playerInfo->connection = conn;
         playerInfo->isConnected = true;
         peerInfo_[conn] = *playerInfo;
+        TrackInputAcks(conn);
 
         Debug::Info("Server") << "Player " << playerInfo->playerId << " (" << clientId
             << ") reconnected after " << elapsed.count() << "s\n";
@@ -230,52 +416,86 @@ private:
     }
 
     void HandleInputPacket(HSteamNetConnection conn, const uint8_t* data, int len) {
-        const size_t EXPECTED_MIN_LEN = 1 + 4 + 4 + sizeof(InputBlob);
-        if (len < EXPECTED_MIN_LEN) {
+        int playerId = -1;
+        std::vector<InputEntry> window;
+        if (!net_.ParseInputWindow(data, len, playerId, window)) {
             Debug::Info("Server") << "[SERVER] Malformed input packet, len=" << len << "\n";
             return;
         }
 
-        InputEntry ie = net_.ParseInputEntryPacket(data, len);
-
-        if (ie.frame < server_.GetCurrentFrame())
-        {
-            ie.frame = server_.GetCurrentFrame();
+        std::lock_guard<std::mutex> lk(inputAcksMtx_);
+        auto ackIt = inputAckFrames_.find(conn);
+        if (ackIt == inputAckFrames_.end()) {
+            return;
         }
-
-        server_.OnClientInputReceived(ie);
-
-        for (auto& [peer, info] : peerInfo_) {
-            if (!info.isConnected) {
+        int& ackFrame = ackIt->second;
+
+        // The window holds every input the client has not seen acked, so once
+        // it arrives nothing up to its newest frame is missing any more. Older
+        // entries are copies of inputs already applied. The other clients get
+        // each input from the simulation thread, once it knows the frame the
+        // input is applied at.
+        int receivedFrame = ackFrame;
+        for (const InputEntry& ie : window) {
+            if (ie.frame <= ackFrame) {
                 continue;
             }
-            if (info.playerId != ie.playerId) {
-                net_.SendInputUpdate(peer, ie.playerId, ie.frame, ie.input);
+
+            // Queue full: stop here and leave the rest unacked so the client resends it
+            if (!server_.OnClientInputReceived(ie)) {
+                Debug::Info("Server") << "[SERVER] Input queue full, deferring input of player "
+                    << ie.playerId << " at frame " << ie.frame << "\n";
+                break;
             }
+            receivedFrame = ie.frame;
+        }
+
+        InputAckPacket ack;
+        ack.frame = receivedFrame;
+        if (receivedFrame > ackFrame) {
+            ack.hasLead = MeasureInputLead(receivedFrame, ack.inputLeadUs);
         }
+
+        ackFrame = receivedFrame;
+        net_.SendInputAck(conn, ack);
+    }
+
+    // How long before the server simulates frame its input arrived, for the
+    // client's time sync. False until the first tick sets the schedule.
+    bool MeasureInputLead(int frame, int& leadUs) const {
+        int64_t frameZeroUs = frameZeroDueUs_.load();
+        if (frameZeroUs == NO_TICK_YET) {
+            return false;
+        }
+
+        int64_t dueUs = frameZeroUs + static_cast<int64_t>(frame * 1000000.0 / config_.ticksPerSecond);
+        int64_t lead = dueUs - ToMicroseconds(FixedTickScheduler::Clock::now());
+        leadUs = static_cast<int>(std::clamp<int64_t>(lead, -MAX_REPORTED_LEAD_US, MAX_REPORTED_LEAD_US));
+        return true;
+    }
+
+    static int64_t ToMicroseconds(FixedTickScheduler::Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
     }
 
     void HandleClientHelloDuringGame(HSteamNetConnection conn, const uint8_t* data, int len) {
         if (!config_.allowReconnection) {
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return;
         }
 
-        if (len < sizeof(ClientHelloPacket)) {
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+        ClientHelloPacket hello;
+        if (!net_.ParseClientHello(data, len, hello)) {
+            net_.CloseConnection(conn);
             return;
         }
 
-        const ClientHelloPacket* hello = (const ClientHelloPacket*)data;
-        std::string clientId(hello->clientId);
+        std::string clientId(hello.clientId);
 
         Debug::Info("Server") << "Client attempting connection/reconnection during game: " << clientId << "\n";
 
-        // Add to poll group
-        net_.AddConnectionToPollGroup(conn);
-
         // Use the same handler for consistency
-        HandleNewClient(conn, clientId);
+        HandleNewClient(conn, clientId, hello.snapshotsPerSecond);
     }
 
     void HandleReceiveEventInGame(HSteamNetConnection conn, const uint8_t* data, int len) {
@@ -290,16 +510,25 @@ private:
             return;
         }
 
-        if (type == PACKET_CLIENT_HELLO) {
-            Debug::Info("Server") << "Received CLIENT_HELLO during game, len=" << len << "\n";
-            HandleClientHelloDuringGame(conn, data, len);
+        if (type == PACKET_CLIENT_HELLO || type == PACKET_STATE_ACK || type == PACKET_HASH_TREE) {
+            PendingPeerPacket packet;
+            packet.conn = conn;
+            packet.data.assign(data, data + len);
+
+            // Acks come every tick and an unanswered hash tree ends in a full
+            // state; a client whose hello is lost has to connect again
+            if (!pendingPeerPackets_.TryPush(packet) && type == PACKET_CLIENT_HELLO) {
+                Debug::Info("Server") << "[SERVER] Too many pending packets, closing connection " << conn << "\n";
+                net_.CloseConnection(conn);
+            }
             return;
         }
 
         if (type == PACKET_INPUT_DELAY) {
-            InputDelayPacket packet = net_.ParseInputDelaySync(data, len);
-
-            net_.SendInputDelaySync(conn, packet);
+            InputDelayPacket packet;
+            if (net_.ParseInputDelaySync(data, len, packet)) {
+                net_.SendInputDelaySync(conn, packet);
+            }
 
 
             return;
@@ -307,29 +536,129 @@ private:
 
 		if (type == PACKET_HASH) 
         {
-			HashPacket packet = net_.ParseHashPacket(data, len);
+			PendingHashCheck check;
+			check.conn = conn;
+			if (!config_.enableHashCheck || !net_.ParseHashPacket(data, len, check.packet)) {
+				return;
+			}
+
+			// Checks are periodic; dropping one when the queue is full only delays detection
+			pendingHashChecks_.TryPush(check);
+			return;
+		}
 
-			GameStateBlob state = server_.GetStateAtFrame(packet.frame);
-			uint8_t computedHash[SHA256_DIGEST_LENGTH];
+        Debug::Info("Server") << "[SERVER] Received unknown packet type " << (int)type << ", len=" << len << "\n";
+    }
 
-			server_.GetGameLogic()->HashState(state, computedHash);
+    // Handles the packets queued by the network thread since the last tick.
+    // Runs on the simulation thread.
+    void ProcessPeerPackets() {
+        pendingPeerPackets_.Drain([this](const PendingPeerPacket& packet) {
+            const uint8_t* data = packet.data.data();
+            int len = static_cast<int>(packet.data.size());
+
+            switch (data[0]) {
+            case PACKET_CLIENT_HELLO:
+                Debug::Info("Server") << "Received CLIENT_HELLO during game, len=" << len << "\n";
+                HandleClientHelloDuringGame(packet.conn, data, len);
+                break;
+
+            case PACKET_STATE_ACK: {
+                int ackedFrame = -1;
+                if (!net_.ParseFrameAck(data, len, ackedFrame)) {
+                    break;
+                }
+                auto it = peerInfo_.find(packet.conn);
+                if (it != peerInfo_.end() && ackedFrame > it->second.lastAckedFrame) {
+                    it->second.lastAckedFrame = ackedFrame;
+                }
+                auto scheduler = deltaSchedulers_.find(packet.conn);
+                if (scheduler != deltaSchedulers_.end()) {
+                    scheduler->second.Acknowledge(ackedFrame);
+                }
+                break;
+            }
 
-			// Compare hashes
-			bool match = (std::memcmp(packet.hash, computedHash, SHA256_DIGEST_LENGTH) == 0);
+            case PACKET_HASH_TREE:
+                HandleHashTreePacket(packet.conn, data, len);
+                break;
+            }
+        });
+    }
 
-            if (!match) 
-            {
-				peerInfo_[conn].pendingReceiveFullState = true;
-				Debug::Info("Server") << "[SERVER] Hash mismatch from player "
-					<< peerInfo_[conn].playerId << " at frame " << packet.frame << "\n";
+    // Answers a hash tree with the sections of the current state that diverged,
+    // or schedules a full state when a repair is not possible or not cheaper
+    void HandleHashTreePacket(HSteamNetConnection conn, const uint8_t* data, size_t len) {
+        HashTreePacket tree;
+        if (!net_.ParseHashTree(data, len, tree)) {
+            return;
+        }
 
-				Debug::Info("Server") << "Received hash: " << HashToString(packet.hash) << " Server hash: " << HashToString(computedHash) << "\n";
-            }
+        auto it = peerInfo_.find(conn);
+        if (it == peerInfo_.end() || it->second.repairRequestFrame < 0) {
+            return;
+        }
+        PeerInfo& peer = it->second;
+        peer.repairRequestFrame = -1;
+
+        StateRepairPacket repair;
+        size_t repairBytes = 0;
+        bool repairable = server_.GetDivergentSections(tree.frame, tree.sectionHashes, repair.state, repair.sections);
+        for (const StateSection& section : repair.sections) {
+            repairBytes += section.len;
+        }
 
-			return;
-		}
+        // Nothing to narrow down to, or the sections add up to most of the state
+        if (!repairable || repair.sections.empty() || repairBytes * 2 > static_cast<size_t>(repair.state.len)) {
+            Debug::Info("Server") << "[SERVER] Cannot repair player " << peer.playerId
+                << " by sections, sending full state\n";
+            peer.pendingReceiveFullState = true;
+            return;
+        }
 
-        Debug::Info("Server") << "[SERVER] Received unknown packet type " << (int)type << ", len=" << len << "\n";
+        repair.frame = repair.state.frame;
+        Debug::Info("Server") << "[SERVER] Repairing " << repair.sections.size() << " sections ("
+            << repairBytes << " bytes) of player " << peer.playerId << " at frame " << repair.frame << "\n";
+        net_.SendStateRepair(conn, repair);
+
+        // Its ack of this frame no longer proves the deltas sent at it arrived
+        auto scheduler = deltaSchedulers_.find(conn);
+        if (scheduler != deltaSchedulers_.end()) {
+            scheduler->second.Resend(repair.frame);
+        }
+    }
+
+    // Compares the hashes queued since the last tick with the server's history.
+    // Runs on the simulation thread.
+    void ProcessHashChecks() {
+        pendingHashChecks_.Drain([this](const PendingHashCheck& check) {
+            const HashPacket& packet = check.packet;
+
+            auto it = peerInfo_.find(check.conn);
+            if (it == peerInfo_.end()) {
+                return;
+            }
+
+			// Too old to check against the history
+			StateHash computedHash = 0;
+			if (!server_.GetHashAtFrame(packet.frame, computedHash) || packet.hash == computedHash) {
+				return;
+			}
+
+			PeerInfo& peer = it->second;
+			Debug::Info("Server") << "[SERVER] Hash mismatch from player "
+				<< peer.playerId << " at frame " << packet.frame << "\n";
+
+			Debug::Info("Server") << "Received hash: " << HashToString(packet.hash) << " Server hash: " << HashToString(computedHash) << "\n";
+
+			// Ask for the client's section hashes to repair only what diverged;
+			// the full state stays the fallback
+			if (!peer.pendingReceiveFullState && peer.repairRequestFrame < 0)
+			{
+				peer.repairRequestFrame = server_.GetCurrentFrame();
+				net_.SendHashTreeRequest(check.conn, packet.frame);
+			}
+        });
     }
 
     void HandleDisconnectInGame(HSteamNetConnection conn) {
@@ -367,6 +696,7 @@ private:
         }
 
         peerInfo_.erase(it);
+        UntrackInputAcks(conn);
         activePlayerCount_--;
 
         if (config_.stopOnBelowMin && activePlayerCount_ < config_.minPlayers) {
@@ -376,7 +706,7 @@ private:
         }
     }
 
-    void HandleConnectInGame(HSteamNetConnection conn) {
+    void HandleConnectInGame(HSteamNetConnection) {
         Debug::Info("Server") << "New connection during game, waiting for identification...\n";
     }
 
@@ -385,24 +715,10 @@ private:
             [](const auto& p) { return p.second.isConnected; });
     }
 
-    void PollConnectionEvents() {
-        ISteamNetworkingSockets* sockets = net_.GetSockets();
-        if (!sockets) return;
-
-        SteamNetConnectionStatusChangedCallback_t callback;
-        while (sockets->GetConnectionUserData(net_.GetListenSocket())) {
-            // This is a simplified approach; in production you'd use proper callbacks
-            // For now we rely on message polling to detect connection state changes
-            break;
-        }
-    }
-
-    
-
-    bool HandleNewClient(HSteamNetConnection conn, const std::string& clientId) {
+    bool HandleNewClient(HSteamNetConnection conn, const std::string& clientId, int snapshotsPerSecond = 0) {
         if (config_.requireClientId && !IsValidClientId(clientId)) {
             Debug::Info("Server") << "Invalid client ID format: " << clientId << "\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
@@ -423,7 +739,8 @@ private:
             if (oldConnIt != peerInfo_.end()) {
                 Debug::Info("Server") << "Forcing old connection closed and treating as reconnection\n";
                 peerInfo_.erase(oldConnIt);
-                net_.GetSockets()->CloseConnection(existingPlayer->connection, 0, nullptr, false);
+                UntrackInputAcks(existingPlayer->connection);
+                net_.CloseConnection(existingPlayer->connection);
                 isReconnection = true;
             }
         }
@@ -436,7 +753,7 @@ private:
             // Check reconnection timeout
             if (elapsed > config_.reconnectionTimeout && config_.reconnectionTimeout.count() > 0) {
                 Debug::Info("Server") << "Reconnection timeout exceeded for " << clientId << "\n";
-                net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+                net_.CloseConnection(conn);
                 return false;
             }
 
@@ -444,6 +761,8 @@ private:
             existingPlayer->connection = conn;
             existingPlayer->isConnected = true;
             peerInfo_[conn] = *existingPlayer;
+            TrackInputAcks(conn);
+            StartSnapshots(peerInfo_[conn], snapshotsPerSecond);
             activePlayerCount_++;
 
             Debug::Info("Server") << "Player " << existingPlayer->playerId
@@ -465,7 +784,7 @@ private:
         // Not a reconnection - new player
         if (peerInfo_.size() >= config_.maxPlayers) {
             Debug::Info("Server") << "Connection rejected: server full\n";
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+            net_.CloseConnection(conn);
             return false;
         }
 
@@ -477,6 +796,8 @@ private:
 
         allPlayers_.push_back(info);
         peerInfo_[conn] = info;
+        TrackInputAcks(conn);
+        StartSnapshots(peerInfo_[conn], snapshotsPerSecond);
         activePlayerCount_++;
 
         Debug::Info("Server") << "Client accepted as Player " << info.playerId
@@ -494,20 +815,17 @@ private:
     }
 
     void HandleClientHello(HSteamNetConnection conn, const uint8_t* data, int len) {
-        if (len < sizeof(ClientHelloPacket)) {
-            net_.GetSockets()->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+        ClientHelloPacket hello;
+        if (!net_.ParseClientHello(data, len, hello)) {
+            net_.CloseConnection(conn);
             return;
         }
 
-        const ClientHelloPacket* hello = (const ClientHelloPacket*)data;
-        std::string clientId(hello->clientId);
+        std::string clientId(hello.clientId);
 
         Debug::Info("Server") << "Received CLIENT_HELLO from " << clientId << "\n";
 
-        // Add to poll group BEFORE handling (in case it's already connected via callback)
-        net_.AddConnectionToPollGroup(conn);
-
-        HandleNewClient(conn, clientId);
+        HandleNewClient(conn, clientId, hello.snapshotsPerSecond);
     }
 
     bool WaitForClients() {
@@ -527,7 +845,7 @@ private:
                 HandleClientHello(conn, data, len);
                 }, false);
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            net_.WaitForTraffic(100);
         }
 
         return running && peerInfo_.size() >= config_.minPlayers;
@@ -535,7 +853,7 @@ private:
 
     void BroadcastGameStart() {
         for (const auto& [conn, info] : peerInfo_) {
-            net_.BroadcastGameStart(conn, info.playerId);
+            net_.BroadcastGameStart(conn, info.playerId, config_.ticksPerSecond);
         }
     }
 
@@ -546,152 +864,386 @@ private:
 
             // Poll and process packets immediately
             // Server mutex protects shared state
-            net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
+            int received = net_.Poll([&](const uint8_t* data, int len, HSteamNetConnection conn) {
                 HandleReceiveEventInGame(conn, data, len);
                 }, false);
 
-            // Check for disconnections
-            ISteamNetworkingSockets* sockets = net_.GetSockets();
-            std::vector<HSteamNetConnection> toRemove;
+            QueueDisconnects();
 
-            for (auto& [conn, info] : peerInfo_) {
-                SteamNetConnectionInfo_t connInfo;
-                if (sockets->GetConnectionInfo(conn, &connInfo)) {
-                    if (connInfo.m_eState == k_ESteamNetworkingConnectionState_ClosedByPeer ||
-                        connInfo.m_eState == k_ESteamNetworkingConnectionState_ProblemDetectedLocally ||
-                        connInfo.m_eState == k_ESteamNetworkingConnectionState_Dead) {
-                        toRemove.push_back(conn);
-                    }
-                }
+            // Wakes as soon as the next datagram arrives
+            net_.WaitAfterPoll(received);
+        }
+    }
+
+    // Looks for clients whose connection closed and queues them for the
+    // simulation thread. Runs on the network thread.
+    void QueueDisconnects() {
+        std::lock_guard<std::mutex> lk(inputAcksMtx_);
+        for (auto it = inputAckFrames_.begin(); it != inputAckFrames_.end(); ) {
+            // Queue full: look again on the next pass
+            if (net_.GetConnectionState(it->first) == TRANSPORT_CLOSED && pendingDisconnects_.TryPush(it->first)) {
+                it = inputAckFrames_.erase(it);
+            }
+            else {
+                ++it;
             }
+        }
+    }
 
-            for (auto conn : toRemove) {
-                HandleDisconnectInGame(conn);
-                server_.OnPlayerDisconnected(peerInfo_[conn].playerId);
+    // Drops the clients queued by QueueDisconnects. Runs on the simulation thread.
+    void ProcessDisconnects() {
+        pendingDisconnects_.Drain([this](HSteamNetConnection conn) {
+            auto it = peerInfo_.find(conn);
+            if (it == peerInfo_.end()) {
+                return;
             }
 
-            // Small sleep to prevent busy-waiting
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
+            int playerId = it->second.playerId;
+            HandleDisconnectInGame(conn);
+            server_.OnPlayerDisconnected(playerId);
+        });
     }
 
-    void RunServerLoop() {
-        auto nextTick = std::chrono::high_resolution_clock::now();
+    void BeginGame() {
         activePlayerCount_ = CountActivePlayers();
 
         for (auto [conn, info] : peerInfo_) {
             server_.OnPlayerConnected(info.playerId);
         }
 
+        if (!config_.replayPath.empty()) {
+            if (server_.StartRecording(config_.replayPath)) {
+                Debug::Info("Server") << "Recording replay to " << config_.replayPath << "\n";
+            }
+            else {
+                Debug::Error("Server") << "Could not open replay file " << config_.replayPath << "\n";
+            }
+        }
+    }
+
+    bool IsGameRunning() {
+        return running_ && (activePlayerCount_ >= config_.minPlayers || !config_.stopOnBelowMin) && !server_.GetGameLogic()->gameFinished;
+    }
+
+    void RunServerLoop() {
+        FixedTickScheduler scheduler(config_.ticksPerSecond);
+        scheduler.Start();
+        BeginGame();
+
         // Start network thread
         std::atomic<bool> networkRunning(true);
         std::thread networkThread([this, &networkRunning]() {
             ServerNetworkThread(networkRunning);
             });
 
-        while (running_ && (activePlayerCount_ >= config_.minPlayers || !config_.stopOnBelowMin) && !server_.GetGameLogic()->gameFinished) {
+        while (IsGameRunning()) {
+            TickOnce(scheduler.NextTickTime());
 
-            // Run game simulation tick
-            StateUpdate update = server_.Tick();
+            scheduler.Advance();
+            scheduler.SleepUntilNext();
+        }
 
-            // Handle reconnections
-            for (auto& [conn, info] : peerInfo_) {
-                if (!info.isConnected) {
+        // Clean shutdown
+        networkRunning.store(false);
+        networkThread.join();
+        server_.StopRecording();
+    }
+
+    // Sends the clients due a state update this tick the events generated
+    // since their previous one, and either the deltas since the last state
+    // they acked or a full state. Deltas are unreliable, so they are always
+    // computed against the acked state: changes in an update that was lost
+    // go out again with the next one. Clients sent a state every few ticks
+    // get those ticks merged into one set of deltas, so their bandwidth
+    // follows their snapshot rate. With a delta budget, entity deltas that
+    // do not fit wait for a later update. With an interest radius, entity
+    // deltas and events far from a client are not sent to it; full states
+    // always carry everything.
+    void SendStateUpdates(const StateUpdate& update) {
+        // Updates are scheduled and events kept by the frame the tick
+        // simulated. Deltas carry the frame of the state they produce, as
+        // full states do, so an ack means the same state after either.
+        int frame = update.frame - 1;
+
+        std::vector<EventEntry> generatedEvents;
+        server_.GetGameLogic()->GetGeneratedEvents(generatedEvents);
+        for (const EventEntry& event : generatedEvents) {
+            pendingEvents_.push_back(PendingEvent{ frame, event });
+        }
+
+        // Read before GenerateDeltasSince reuses the logic's delta list
+        std::vector<DeltaStateBlob> tickDeltas;
+        server_.GetGameLogic()->GetGeneratedDeltas(tickDeltas);
+
+        bool useInterest = config_.interestRadius > 0.0f;
+        if (useInterest) {
+            std::vector<EntityPosition> positions;
+            server_.GetGameLogic()->GetEntityPositions(update.state, positions);
+            interestGrid_.Build(positions, config_.interestRadius);
+        }
+        std::map<HSteamNetConnection, ClientView> views;
+
+        // Due clients, grouped by the frame of their previous update for
+        // events and by their acked frame for deltas, so each group shares
+        // one encoding
+        std::map<int, std::vector<HSteamNetConnection>> eventTargets;
+        std::map<int, std::vector<HSteamNetConnection>> deltaTargets;
+        int oldestSnapshotFrame = frame;
+
+        for (auto& [conn, info] : peerInfo_) {
+            if (!info.isConnected) {
+                continue;
+            }
+            if (pendingReconnections_.find(info.playerId) != pendingReconnections_.end()) {
+                continue;
+            }
+
+            // Deltas are unreliable: if the client stops confirming them,
+            // resynchronise it with a reliable full state
+            if (!info.pendingReceiveFullState && info.lastAckedFrame >= 0 &&
+                update.frame - info.lastAckedFrame > STATE_ACK_TIMEOUT_FRAMES + info.snapshotInterval)
+            {
+                Debug::Info("Server") << "[SERVER] Player " << info.playerId
+                    << " has not acked state since frame " << info.lastAckedFrame
+                    << ", sending full state\n";
+                info.pendingReceiveFullState = true;
+            }
+
+            // The client never answered the hash tree request
+            if (info.repairRequestFrame >= 0 &&
+                update.frame - info.repairRequestFrame > STATE_ACK_TIMEOUT_FRAMES)
+            {
+                info.pendingReceiveFullState = true;
+            }
+
+            bool due = frame - info.lastSnapshotFrame >= info.snapshotInterval;
+            if (!due && !info.pendingReceiveFullState) {
+                oldestSnapshotFrame = std::min(oldestSnapshotFrame, info.lastSnapshotFrame);
+                continue;
+            }
+
+            eventTargets[info.lastSnapshotFrame].push_back(conn);
+
+            ClientView& view = views[conn];
+            if (useInterest) {
+                view.everything = !server_.GetGameLogic()->GetViewerPosition(update.state, info.playerId, view.x, view.y);
+            }
+
+            if (info.pendingReceiveFullState)
+            {
+                info.pendingReceiveFullState = false;
+                info.repairRequestFrame = -1;
+                deltaSchedulers_.erase(conn);
+                net_.SendStateUpdate(conn, update);
+                // Reliable delivery is guaranteed, restart the ack timeout from here
+                info.lastAckedFrame = update.frame;
+            }
+            else
+            {
+                deltaTargets[std::min(info.lastAckedFrame, frame)].push_back(conn);
+            }
+            info.lastSnapshotFrame = frame;
+        }
+
+        for (auto& [since, conns] : eventTargets) {
+            for (const PendingEvent& pending : pendingEvents_) {
+                if (pending.frame <= since) {
                     continue;
                 }
-                if (pendingReconnections_.find(info.playerId) != pendingReconnections_.end()) {
-                    server_.OnPlayerReconnected(info.playerId);
-                    pendingReconnections_.erase(info.playerId);
+
+                float x, y;
+                if (!useInterest || !server_.GetGameLogic()->GetEventPosition(pending.event, x, y)) {
+                    net_.BroadcastEventUpdate(conns, pending.event);
+                    continue;
                 }
+
+                std::vector<HSteamNetConnection> nearby;
+                for (HSteamNetConnection conn : conns) {
+                    if (IsInView(views[conn], x, y)) {
+                        nearby.push_back(conn);
+                    }
+                }
+                net_.BroadcastEventUpdate(nearby, pending.event);
             }
+        }
 
-            // Send generated events to all connected players
-            std::vector<EventEntry> generatedEvents;
-            server_.GetGameLogic()->GetGeneratedEvents(generatedEvents);
+        for (auto& [base, conns] : deltaTargets) {
+            DeltasUpdatePacket deltasPacket;
+            deltasPacket.frame = update.frame;
+            deltasPacket.baseFrame = base;
 
-            for (auto event : generatedEvents) {
-                for (auto& [conn, info] : peerInfo_) {
-                    if (!info.isConnected) {
-                        continue;
-                    }
-                    if (pendingReconnections_.find(info.playerId) == pendingReconnections_.end()) {
-                        net_.SendEventUpdate(conn, event);
-                    }
+            // Only this tick changed the state since the client's ack
+            if (base == frame) {
+                deltasPacket.deltas = tickDeltas;
+            }
+            else if (!server_.GenerateDeltasSince(base, deltasPacket.deltas)) {
+                // Its acked state has left the history, start it over
+                for (HSteamNetConnection conn : conns) {
+                    peerInfo_[conn].pendingReceiveFullState = true;
                 }
+                continue;
             }
 
-            std::vector<DeltaStateBlob> generatedDeltas;
-            server_.GetGameLogic()->GetGeneratedDeltas(generatedDeltas);
+            if (config_.deltaBudgetBytes <= 0 && !useInterest) {
+                // Too many to send as deltas
+                if (!net_.BroadcastDeltasUpdate(conns, deltasPacket)) {
+                    for (HSteamNetConnection conn : conns) {
+                        peerInfo_[conn].pendingReceiveFullState = true;
+                    }
+                }
+                continue;
+            }
 
+            // Each client gets its own pick, the rest waits
+            for (HSteamNetConnection conn : conns) {
+                DeltaSendScheduler& scheduler = deltaSchedulers_[conn];
+                scheduler.Queue(deltasPacket.deltas);
 
-            for (auto& [conn, info] : peerInfo_) {
-                if (!info.isConnected) {
-                    continue;
+                InterestSet interest;
+                const ClientView& view = views[conn];
+                if (useInterest && !view.everything) {
+                    interest.grid = &interestGrid_;
+                    interestGrid_.FindVisible(view.x, view.y, config_.interestRadius, interest.visible);
                 }
-                if (pendingReconnections_.find(info.playerId) == pendingReconnections_.end()) {
-                    if (info.pendingReceiveFullState)
-                    {
-						info.pendingReceiveFullState = false;
-                        net_.SendStateUpdate(conn, update);
-                    }
-                    else 
-                    {
-                        net_.SendDeltasUpdate(conn, generatedDeltas, server_.GetCurrentFrame()-1);
-                    }
 
-                    //net_.SendStateUpdate(conn, update);
-                    
+                DeltasUpdatePacket picked;
+                picked.frame = update.frame;
+                picked.baseFrame = base;
+                scheduler.Select(*server_.GetGameLogic(), update.state, peerInfo_[conn].playerId, interest,
+                    static_cast<size_t>(std::max(config_.deltaBudgetBytes, 0)), picked.deltas);
+                if (!net_.SendDeltasUpdate(conn, picked)) {
+                    peerInfo_[conn].pendingReceiveFullState = true;
                 }
             }
-            
-
-            // Performance monitoring every 30 frames
-            if (server_.GetCurrentFrame() % 30 == 0) {
+        }
 
-                
+        // Clients that left
+        for (auto it = deltaSchedulers_.begin(); it != deltaSchedulers_.end(); ) {
+            if (peerInfo_.find(it->first) == peerInfo_.end()) {
+                it = deltaSchedulers_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
 
-                auto now = std::chrono::high_resolution_clock::now();
-                auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - nextTick);
-                long long durationUs = duration.count();
+        // Events every client has been sent
+        while (!pendingEvents_.empty() && pendingEvents_.front().frame <= oldestSnapshotFrame) {
+            pendingEvents_.pop_front();
+        }
+    }
 
-                tickDurations_.push_back(durationUs);
+    // Sends every client the inputs of the other players that the last tick
+    // applied, at the frames it applied them at
+    void RelayInputs() {
+        std::vector<InputEntry> inputs;
+        server_.GetRelayedInputs(inputs);
 
-                if (tickDurations_.size() > MAX_SAMPLES) {
-                    tickDurations_.erase(tickDurations_.begin());
+        for (const InputEntry& input : inputs) {
+            for (auto& [conn, info] : peerInfo_) {
+                if (info.isConnected && info.playerId != input.playerId) {
+                    net_.SendInputUpdate(conn, input.playerId, input.frame, input.input);
                 }
+            }
+        }
+    }
 
-                long long sum = 0;
-                for (long long d : tickDurations_) {
-                    sum += d;
-                }
-                double mean = static_cast<double>(sum) / tickDurations_.size();
+    bool IsInView(const ClientView& view, float x, float y) const {
+        if (view.everything) {
+            return true;
+        }
+        float dx = x - view.x;
+        float dy = y - view.y;
+        return dx * dx + dy * dy <= config_.interestRadius * config_.interestRadius;
+    }
 
-                double currentMs = durationUs / 1000.0 / TICKS_PER_SECOND;
-                double meanMs = mean / 1000.0 / TICKS_PER_SECOND;
+    // One game tick: simulate, then send events, deltas and full states.
+    // scheduledTick is when the tick was due, for the timing statistics.
+    void TickOnce(FixedTickScheduler::Clock::time_point scheduledTick) {
+        auto tickStart = FixedTickScheduler::Clock::now();
+        ProcessDisconnects();
+        ProcessPeerPackets();
+        ProcessHashChecks();
 
-                GameStateBlob s = server_.GetCurrentState();
+        int64_t frameDurationUs = static_cast<int64_t>(server_.GetCurrentFrame() * 1000000.0 / config_.ticksPerSecond);
+        frameZeroDueUs_.store(ToMicroseconds(scheduledTick) - frameDurationUs);
 
-                Debug::Info("Server") << "Current: " << std::fixed << std::setprecision(5) << currentMs << " ms | "
-                    << "Mean (last " << tickDurations_.size() << "): "
-                    << meanMs << " ms" << "\n";
+        // Run game simulation tick
+        StateUpdate update = server_.Tick();
+        net_.SetFrameReference(update.frame);
+
+        // Handle reconnections
+        for (auto& [conn, info] : peerInfo_) {
+            if (!info.isConnected) {
+                continue;
+            }
+            if (pendingReconnections_.find(info.playerId) != pendingReconnections_.end()) {
+                server_.OnPlayerReconnected(info.playerId);
+                pendingReconnections_.erase(info.playerId);
             }
+        }
+
+        RelayInputs();
+        SendStateUpdates(update);
+
+        // Everything queued this tick (events, deltas, input relays and acks
+        // from the network thread) leaves as one datagram per client and channel
+        net_.FlushOutgoing();
+
+        if (config_.tickStats) {
+            config_.tickStats->Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                FixedTickScheduler::Clock::now() - tickStart).count());
+        }
+
+        // Performance monitoring every 30 frames
+        if (server_.GetCurrentFrame() % 30 == 0) {
+
+            
 
-            nextTick += std::chrono::milliseconds(MS_PER_TICK);
-            std::this_thread::sleep_until(nextTick);
+            auto now = FixedTickScheduler::Clock::now();
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - scheduledTick);
+            long long durationUs = duration.count();
 
-            if (config_.maxFrames > 0 && server_.GetCurrentFrame() > config_.maxFrames) {
-                Debug::Info("Server") << "Reached maximum frames. Stopping server.\n";
-                running_ = false;
+            tickDurations_.push_back(durationUs);
+
+            if (tickDurations_.size() > MAX_SAMPLES) {
+                tickDurations_.erase(tickDurations_.begin());
+            }
+
+            long long sum = 0;
+            for (long long d : tickDurations_) {
+                sum += d;
             }
+            double mean = static_cast<double>(sum) / tickDurations_.size();
+
+            double currentMs = durationUs / 1000.0 / config_.ticksPerSecond;
+            double meanMs = mean / 1000.0 / config_.ticksPerSecond;
+
+            GameStateBlob s = server_.GetCurrentState();
+
+            Debug::Info("Server") << "Current: " << std::fixed << std::setprecision(5) << currentMs << " ms | "
+                << "Mean (last " << tickDurations_.size() << "): "
+                << meanMs << " ms" << "\n";
         }
 
-        // Clean shutdown
-        networkRunning.store(false);
-        networkThread.join();
+        if (config_.maxFrames > 0 && server_.GetCurrentFrame() > config_.maxFrames) {
+            Debug::Info("Server") << "Reached maximum frames. Stopping server.\n";
+            running_ = false;
+        }
     }
 
     void PrintServerConfig() {
         Debug::Info("Server") << "Waiting for " << config_.minPlayers << " clients to connect...\n";
+        Debug::Info("Server") << "Ticking at " << config_.ticksPerSecond << " Hz\n";
+        if (config_.snapshotsPerSecond > 0) {
+            Debug::Info("Server") << "Sending state every " << SnapshotIntervalFor(0) << " ticks by default\n";
+        }
+        if (config_.deltaBudgetBytes > 0) {
+            Debug::Info("Server") << "Capping deltas to " << config_.deltaBudgetBytes << " bytes per update\n";
+        }
+        if (config_.interestRadius > 0.0f) {
+            Debug::Info("Server") << "Sending clients what is within " << config_.interestRadius << " of them\n";
+        }
 
         if (config_.requireClientId) {
             Debug::Info("Server") << "Client ID validation is ENABLED\n";
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cstdint>
+
+// Tick durations of one or more servers, for load tests and soak runs.
+// Shared through ServerConfig so every match of a MatchHost records into the
+// same sink. Keeps the most recent MAX_SAMPLES ticks.
+class TickStats {
+public:
+    static constexpr size_t MAX_SAMPLES = 1 << 16;
+
+    // Safe from any thread
+    void Record(long long durationUs) {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (samples_.size() < MAX_SAMPLES) {
+            samples_.push_back(durationUs);
+        }
+        else {
+            samples_[next_] = durationUs;
+        }
+        next_ = (next_ + 1) % MAX_SAMPLES;
+        count_++;
+    }
+
+    // Duration in microseconds below which fraction p (0..1) of the kept ticks
+    // fall, or 0 before the first tick
+    long long Percentile(double p) const {
+        std::vector<long long> sorted;
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            sorted = samples_;
+        }
+        if (sorted.empty()) {
+            return 0;
+        }
+
+        size_t index = static_cast<size_t>(std::clamp(p, 0.0, 1.0) * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        return sorted[index];
+    }
+
+    // Ticks recorded in total, including those no longer kept
+    uint64_t GetTickCount() const {
+        std::lock_guard<std::mutex> lk(mtx_);
+        return count_;
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lk(mtx_);
+        samples_.clear();
+        next_ = 0;
+        count_ = 0;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    std::vector<long long> samples_;
+    size_t next_ = 0;
+    uint64_t count_ = 0;
+};
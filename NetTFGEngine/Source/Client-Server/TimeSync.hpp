@@ -0,0 +1,120 @@
+#pragma once
+
+#include "netcode/tick_scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Keeps a client's ticks just ahead of the server's, so its inputs reach the
+// server shortly before their frame is simulated: not so late that the
+// server applies them a frame later than predicted, not so early that the
+// client predicts further ahead than the network needs.
+//
+// The server reports with each input ack how long before its frame the input
+// arrived. The client runs its tick up to MAX_DILATION faster or slower until
+// the low end of the recent leads sits at TARGET_LEAD_US. An error too large
+// for dilation to correct quickly, as right after joining, is fixed at once
+// by running or skipping whole ticks.
+class TimeSync {
+public:
+    static constexpr double MAX_DILATION = 0.02;
+    static constexpr int64_t TARGET_LEAD_US = 2000;
+    static constexpr int64_t CORRECTION_TIME_US = 1000000;  // Dilation aims to close the error in about this long
+    static constexpr int JUMP_THRESHOLD_TICKS = 2;           // Larger errors are corrected with whole ticks
+    static constexpr int MAX_TICKS_PER_CALL = 8;             // Cap on ticks run at once while catching up
+    static constexpr size_t SAMPLE_WINDOW = 32;
+    static constexpr size_t MIN_SAMPLES = 8;
+    static constexpr double LOW_PERCENTILE = 0.1;
+
+    void SetTickRate(int ticksPerSecond) {
+        std::lock_guard<std::mutex> lk(mtx);
+        tickUs = 1000000.0 / ClampTickRate(ticksPerSecond);
+    }
+
+    // Lead of the input for frame, from an input ack. Called on the network thread.
+    void OnInputLead(int frame, int leadUs) {
+        std::lock_guard<std::mutex> lk(mtx);
+
+        // Inputs sent before the last whole-tick correction show the old timing
+        if (frame < ignoreBeforeFrame) {
+            return;
+        }
+
+        samples.push_back(leadUs);
+        if (samples.size() > SAMPLE_WINDOW) {
+            samples.pop_front();
+        }
+        if (samples.size() < MIN_SAMPLES) {
+            return;
+        }
+
+        std::vector<int64_t> sorted(samples.begin(), samples.end());
+        size_t index = static_cast<size_t>(LOW_PERCENTILE * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+        lowLeadUs = sorted[index];
+
+        // Positive: further ahead than needed
+        double errorUs = static_cast<double>(lowLeadUs - TARGET_LEAD_US);
+
+        if (std::abs(errorUs) > JUMP_THRESHOLD_TICKS * tickUs) {
+            pendingTicks -= static_cast<int>(std::lround(errorUs / tickUs));
+            ignoreBeforeFrame = lastTickedFrame + std::max(pendingTicks, 0) + 1;
+            samples.clear();
+            timeScale = 1.0;
+            return;
+        }
+
+        timeScale = 1.0 - std::clamp(errorUs / CORRECTION_TIME_US, -MAX_DILATION, MAX_DILATION);
+    }
+
+    // Ticks to run now that one is due: usually 1, more while catching up
+    // and 0 while skipping. frame is the client's current frame.
+    int TakeTicksDue(int frame) {
+        std::lock_guard<std::mutex> lk(mtx);
+        lastTickedFrame = frame;
+
+        if (pendingTicks < 0) {
+            pendingTicks++;
+            return 0;
+        }
+
+        int extra = std::min(pendingTicks, MAX_TICKS_PER_CALL - 1);
+        pendingTicks -= extra;
+        return 1 + extra;
+    }
+
+    // Rate the client's tick runs at relative to the server's
+    double GetTimeScale() const {
+        std::lock_guard<std::mutex> lk(mtx);
+        return timeScale;
+    }
+
+    // Low end of the recent input leads, in microseconds
+    int64_t GetInputLeadUs() const {
+        std::lock_guard<std::mutex> lk(mtx);
+        return lowLeadUs;
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lk(mtx);
+        samples.clear();
+        timeScale = 1.0;
+        lowLeadUs = 0;
+        pendingTicks = 0;
+        lastTickedFrame = 0;
+        ignoreBeforeFrame = 0;
+    }
+
+private:
+    mutable std::mutex mtx;
+    double tickUs = 1000000.0 / DEFAULT_TICKS_PER_SECOND;
+    std::deque<int64_t> samples;
+    double timeScale = 1.0;
+    int64_t lowLeadUs = 0;
+    int pendingTicks = 0;       // Positive: ticks to run early, negative: ticks to skip
+    int lastTickedFrame = 0;
+    int ignoreBeforeFrame = 0;
+};
@@ -158,8 +158,9 @@ public:
 
         Debug::Info("NetTFG_Engine") << "Starting engine\n";
 
-        const auto TICK_DURATION = std::chrono::microseconds(1000000 / TICKS_PER_SECOND);
-        auto nextTick = std::chrono::steady_clock::now();
+        // Each client ticks at its own rate, an online client at the one its
+        // server announced; the loop sleeps until the first one is due
+        std::unordered_map<Client*, FixedTickScheduler> schedulers;
 
         while (running_.load() && ClientWindow::isWindowThreadRunning()) {
             auto& mgr = ClientManager::Get();
@@ -171,10 +172,22 @@ public:
                 break;
             }
 
-            // Tick all active clients
+            // Tick the active clients that are due
+            auto now = FixedTickScheduler::Clock::now();
             for (size_t index : activeIndices) {
                 Client* client = mgr.GetClient(index);
                 if (client) {
+                    FixedTickScheduler& scheduler = schedulers[client];
+                    if (!scheduler.IsStarted()) {
+                        scheduler.Start(now);
+                    }
+                    scheduler.SetRate(client->GetTicksPerSecond());
+                    scheduler.SetTimeScale(client->GetTickTimeScale());
+                    if (!scheduler.IsDue(now)) {
+                        continue;
+                    }
+                    scheduler.Advance();
+
                     try {
                         client->TickClient();
                     }
@@ -201,9 +214,20 @@ public:
                 }
             }
 
+            // Deactivated clients are forgotten, so they start on a fresh
+            // schedule when activated again
+            auto wakeAt = now + std::chrono::microseconds(1000000 / DEFAULT_TICKS_PER_SECOND);
+            for (auto it = schedulers.begin(); it != schedulers.end();) {
+                if (!IsClientActive(it->first)) {
+                    it = schedulers.erase(it);
+                    continue;
+                }
+                wakeAt = std::min(wakeAt, it->second.NextTickTime());
+                ++it;
+            }
+
             // Fixed timestep - wait until next tick
-            nextTick += TICK_DURATION;
-            std::this_thread::sleep_until(nextTick);
+            std::this_thread::sleep_until(wakeAt);
         }
 
         ClientCleanup();
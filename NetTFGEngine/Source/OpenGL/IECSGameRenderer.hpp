@@ -108,7 +108,7 @@ public:
         ui_update->UpdateScreenSize(window->getLogicalWidth(), window->getLogicalHeight());
 
         auto t1 = std::chrono::high_resolution_clock::now();
-        world.Update(false, 1.0f / RENDER_TICKS_PER_SECOND);
+        world.Update(false, 1.0f / ClientWindow::getRenderTickRate());
         auto t2 = std::chrono::high_resolution_clock::now();
         //Debug::Info("Render") << "world.Update: "
         //    << std::chrono::duration<float, std::milli>(t2 - t1).count() << "ms\n";
@@ -120,7 +120,7 @@ public:
 
         frameCount++;
 
-        if (frameCount >= RENDER_TICKS_PER_SECOND * 25) {
+        if (frameCount >= ClientWindow::getRenderTickRate() * 25) {
             frameCount = 0;
             //renderSys->DumpBuffers();
         }
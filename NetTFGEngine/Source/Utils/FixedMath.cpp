@@ -0,0 +1,74 @@
+#include "FixedMath.hpp"
+
+// Boundary checks for FixedMath, evaluated by the compiler. Overflow inside a
+// constant expression does not compile, so these also prove the wrapping
+// paths are free of undefined behavior.
+
+namespace {
+
+template <typename S>
+constexpr bool Near(S value, S expected, int steps) {
+    return FixedMath::Abs(value - expected).raw <= steps;
+}
+
+// Add and subtract wrap around
+static_assert(Fixed::Max() + Fixed::Epsilon() == Fixed::Min());
+static_assert(Fixed::Min() - Fixed::Epsilon() == Fixed::Max());
+static_assert(-Fixed::Min() == Fixed::Min());
+static_assert(FixedMath::Abs(Fixed::Min()) == Fixed::Min());
+static_assert(-Fixed::Max() == Fixed::Min() + Fixed::Epsilon());
+static_assert(Fixed64::Max() + Fixed64::Epsilon() == Fixed64::Min());
+static_assert(Fixed64::Min() - Fixed64::Epsilon() == Fixed64::Max());
+static_assert(-Fixed64::Min() == Fixed64::Min());
+
+// Multiply rounds to nearest and wraps around
+static_assert(Fixed::FromInt(3) * Fixed::FromInt(-2) == Fixed::FromInt(-6));
+static_assert(Fixed::Epsilon() * Fixed::Half() == Fixed::Epsilon());
+static_assert(-Fixed::Epsilon() * Fixed::Half() == Fixed::Zero());
+static_assert(Fixed::FromInt(200) * Fixed::FromInt(200) == Fixed::FromRaw(-1673527296));
+static_assert(Fixed::FromInt(32768) == Fixed::Min());
+static_assert(Fixed::Max() * 2 == Fixed::FromRaw(-2));
+static_assert(Fixed::Min() * -1 == Fixed::Min());
+static_assert(Fixed64::FromInt(3) * Fixed64::FromInt(-2) == Fixed64::FromInt(-6));
+static_assert(Fixed64::Max() * Fixed64::One() == Fixed64::Max());
+static_assert(Fixed64::Min() * Fixed64::One() == Fixed64::Min());
+static_assert(Fixed64::Max() * 2 == Fixed64::FromRaw(-2));
+static_assert(Fixed64::Min() * -1 == Fixed64::Min());
+
+// Divide truncates toward zero, wraps around and saturates on zero
+static_assert(Fixed::One() / Fixed::FromInt(3) == Fixed::FromRaw(21845));
+static_assert(Fixed::FromRatio(-7, 2) == Fixed::FromRaw(-229376));
+static_assert(Fixed::Min() / -Fixed::One() == Fixed::Min());
+static_assert(Fixed::Min() / -1 == Fixed::Min());
+static_assert(Fixed::One() / Fixed::Zero() == Fixed::Max());
+static_assert(-Fixed::One() / Fixed::Zero() == Fixed::Min());
+static_assert(Fixed::Min() / 0 == Fixed::Min());
+static_assert(Fixed64::One() / Fixed64::FromInt(3) == Fixed64::FromRaw(1431655765));
+static_assert(Fixed64::Min() / Fixed64::One() == Fixed64::Min());
+static_assert(Fixed64::Min() / -Fixed64::One() == Fixed64::Min());
+static_assert(Fixed64::Min() / -1 == Fixed64::Min());
+static_assert(Fixed64::Max() / Fixed64::Zero() == Fixed64::Max());
+
+// Square root is floored, and zero for negative values
+static_assert(FixedMath::Sqrt(Fixed::FromInt(4)) == Fixed::FromInt(2));
+static_assert(FixedMath::Sqrt(Fixed::Epsilon()) == Fixed::FromRaw(256));
+static_assert(FixedMath::Sqrt(Fixed::Max()) == Fixed::FromRaw(11863283));
+static_assert(FixedMath::Sqrt(Fixed::Min()) == Fixed::Zero());
+static_assert(FixedMath::Sqrt(Fixed64::FromInt(4)) == Fixed64::FromInt(2));
+static_assert(FixedMath::Sqrt(Fixed64::Max()) == Fixed64::FromRaw(199032864766430));
+
+// Trig stays in range for every angle, down to the extremes
+static_assert(FixedMath::Sin(Fixed::Zero()) == Fixed::Zero());
+static_assert(Near(FixedMath::Sin(Fixed::FromInt(90)), Fixed::One(), 2));
+static_assert(Near(FixedMath::Sin(Fixed::FromInt(-90)), -Fixed::One(), 2));
+static_assert(Near(FixedMath::Cos(Fixed::FromInt(180)), -Fixed::One(), 2));
+static_assert(Near(FixedMath::Cos(Fixed::Max()), FixedMath::Cos(Fixed::Max() - Fixed::FromInt(360)), 2));
+static_assert(FixedMath::Abs(FixedMath::Cos(Fixed::Min())) <= Fixed::One());
+static_assert(Near(FixedMath::Atan2(Fixed::Min(), Fixed::Zero()), Fixed::FromInt(-90), 8));
+static_assert(Near(FixedMath::Atan2(Fixed::Zero(), Fixed::Min()), Fixed::FromInt(180), 8));
+static_assert(Near(FixedMath::Atan2(Fixed::Min(), Fixed::Min()), Fixed::FromInt(-135), 16));
+static_assert(Near(FixedMath::Sin(Fixed64::FromInt(90)), Fixed64::One(), 16));
+static_assert(Near(FixedMath::Cos(Fixed64::Min()), FixedMath::Cos(Fixed64::Min() + Fixed64::FromInt(360)), 16));
+static_assert(Near(FixedMath::Atan2(Fixed64::Min(), Fixed64::Min()), Fixed64::FromInt(-135), 1 << 12));
+
+} // namespace
@@ -0,0 +1,537 @@
+#ifndef FIXED_MATH_HPP
+#define FIXED_MATH_HPP
+
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+// Deterministic fixed-point math for simulation code. Every operation is done
+// on integers, so the same inputs give bit-identical results with any compiler
+// and CPU, which float math does not guarantee (fused multiply-adds, x87
+// precision, library trig). Fixed is Q16.16 (range +-32768, step 1/65536) and
+// Fixed64 is Q32.32, for worlds or products too large for Q16.16. Results that
+// do not fit wrap around in two's complement, so -Min() and Abs(Min()) are
+// Min(); division by zero saturates.
+//
+// Converting a float is deterministic too, so values can still be authored as
+// floats. Converting back is meant for rendering, not for feeding the result
+// into the simulation again.
+
+namespace FixedMathDetail {
+
+// Signed overflow is undefined, so wrapping arithmetic is done unsigned
+template <typename Raw>
+constexpr Raw WrappingAdd(Raw a, Raw b) {
+    using U = std::make_unsigned_t<Raw>;
+    return static_cast<Raw>(static_cast<U>(a) + static_cast<U>(b));
+}
+
+template <typename Raw>
+constexpr Raw WrappingSub(Raw a, Raw b) {
+    using U = std::make_unsigned_t<Raw>;
+    return static_cast<Raw>(static_cast<U>(a) - static_cast<U>(b));
+}
+
+template <typename Raw>
+constexpr Raw WrappingMul(Raw a, Raw b) {
+    using U = std::make_unsigned_t<Raw>;
+    return static_cast<Raw>(static_cast<U>(a) * static_cast<U>(b));
+}
+
+// Low 64 bits of (a * b + 2^(shift-1)) >> shift, with a 128-bit intermediate
+constexpr int64_t MulShift64(int64_t a, int64_t b, int shift) {
+    bool negative = (a < 0) != (b < 0);
+    uint64_t ua = a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    uint64_t ub = b < 0 ? 0 - static_cast<uint64_t>(b) : static_cast<uint64_t>(b);
+
+    uint64_t aLo = ua & 0xFFFFFFFFull, aHi = ua >> 32;
+    uint64_t bLo = ub & 0xFFFFFFFFull, bHi = ub >> 32;
+    uint64_t loLo = aLo * bLo;
+    uint64_t loHi = aLo * bHi;
+    uint64_t hiLo = aHi * bLo;
+    uint64_t cross = (loLo >> 32) + (loHi & 0xFFFFFFFFull) + (hiLo & 0xFFFFFFFFull);
+    uint64_t lo = (cross << 32) | (loLo & 0xFFFFFFFFull);
+    uint64_t hi = aHi * bHi + (loHi >> 32) + (hiLo >> 32) + (cross >> 32);
+
+    if (negative) {
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0 ? 1 : 0);
+    }
+
+    uint64_t rounded = lo + (1ull << (shift - 1));
+    hi += rounded < lo ? 1 : 0;
+    return static_cast<int64_t>((rounded >> shift) | (hi << (64 - shift)));
+}
+
+// (a << shift) / b truncated toward zero, with a 128-bit dividend. b != 0
+constexpr int64_t DivShift64(int64_t a, int64_t b, int shift) {
+    bool negative = (a < 0) != (b < 0);
+    uint64_t ua = a < 0 ? 0 - static_cast<uint64_t>(a) : static_cast<uint64_t>(a);
+    uint64_t ub = b < 0 ? 0 - static_cast<uint64_t>(b) : static_cast<uint64_t>(b);
+
+    uint64_t hi = ua >> (64 - shift);
+    uint64_t lo = ua << shift;
+    uint64_t remainder = 0;
+    uint64_t quotient = 0;
+    for (int bit = 127; bit >= 0; --bit) {
+        uint64_t next = bit >= 64 ? (hi >> (bit - 64)) & 1 : (lo >> bit) & 1;
+        bool carry = (remainder >> 63) != 0;
+        remainder = (remainder << 1) | next;
+        quotient <<= 1;
+        if (carry || remainder >= ub) {
+            remainder -= ub;
+            quotient |= 1;
+        }
+    }
+
+    return static_cast<int64_t>(negative ? 0 - quotient : quotient);
+}
+
+// floor(sqrt(value * 2^shift)) for an even shift, two bits at a time
+constexpr uint64_t SqrtShifted(uint64_t value, int shift) {
+    uint64_t remainder = 0;
+    uint64_t root = 0;
+    for (int pair = (64 + shift) / 2 - 1; pair >= 0; --pair) {
+        int position = 2 * pair - shift;
+        uint64_t bits = position >= 0 ? (value >> position) & 3 : 0;
+        remainder = (remainder << 2) | bits;
+        uint64_t trial = (root << 2) | 1;
+        root <<= 1;
+        if (remainder >= trial) {
+            remainder -= trial;
+            root |= 1;
+        }
+    }
+    return root;
+}
+
+} // namespace FixedMathDetail
+
+template <typename Raw, int FRACTION_BITS>
+struct FixedPoint {
+    static_assert(std::is_same_v<Raw, int32_t> || std::is_same_v<Raw, int64_t>,
+        "FixedPoint stores int32_t or int64_t");
+
+    static constexpr int FRACTION = FRACTION_BITS;
+    static constexpr Raw ONE = static_cast<Raw>(1) << FRACTION_BITS;
+
+    Raw raw = 0;
+
+    constexpr FixedPoint() = default;
+
+    static constexpr FixedPoint FromRaw(Raw value) {
+        FixedPoint result;
+        result.raw = value;
+        return result;
+    }
+
+    static constexpr FixedPoint FromInt(int value) {
+        return FromRaw(FixedMathDetail::WrappingMul(static_cast<Raw>(value), ONE));
+    }
+
+    // numerator / denominator, for exact constants such as 1/2
+    static constexpr FixedPoint FromRatio(int numerator, int denominator) {
+        return FromInt(numerator) / denominator;
+    }
+
+    static FixedPoint FromFloat(float value) { return FromDouble(value); }
+
+    static FixedPoint FromDouble(double value) {
+        return FromRaw(static_cast<Raw>(std::llround(value * static_cast<double>(ONE))));
+    }
+
+    float ToFloat() const { return static_cast<float>(ToDouble()); }
+    double ToDouble() const { return static_cast<double>(raw) / static_cast<double>(ONE); }
+
+    // Rounded toward negative infinity
+    constexpr int ToInt() const { return static_cast<int>(raw >> FRACTION_BITS); }
+
+    static constexpr FixedPoint Zero() { return FixedPoint(); }
+    static constexpr FixedPoint One() { return FromRaw(ONE); }
+    static constexpr FixedPoint Half() { return FromRaw(ONE / 2); }
+    static constexpr FixedPoint Epsilon() { return FromRaw(1); }
+    static constexpr FixedPoint Max() { return FromRaw((std::numeric_limits<Raw>::max)()); }
+    static constexpr FixedPoint Min() { return FromRaw((std::numeric_limits<Raw>::min)()); }
+    static constexpr FixedPoint Pi() {
+        return FromRaw(static_cast<Raw>(3.14159265358979323846 * static_cast<double>(ONE) + 0.5));
+    }
+
+    constexpr FixedPoint operator-() const { return FromRaw(FixedMathDetail::WrappingSub(Raw(0), raw)); }
+    constexpr FixedPoint operator+(FixedPoint other) const { return FromRaw(FixedMathDetail::WrappingAdd(raw, other.raw)); }
+    constexpr FixedPoint operator-(FixedPoint other) const { return FromRaw(FixedMathDetail::WrappingSub(raw, other.raw)); }
+
+    constexpr FixedPoint operator*(FixedPoint other) const {
+        if constexpr (sizeof(Raw) == 4) {
+            int64_t product = static_cast<int64_t>(raw) * other.raw;
+            return FromRaw(static_cast<Raw>((product + (int64_t(1) << (FRACTION_BITS - 1))) >> FRACTION_BITS));
+        } else {
+            return FromRaw(FixedMathDetail::MulShift64(raw, other.raw, FRACTION_BITS));
+        }
+    }
+
+    constexpr FixedPoint operator/(FixedPoint other) const {
+        if (other.raw == 0) {
+            return raw >= 0 ? Max() : Min();
+        }
+        if constexpr (sizeof(Raw) == 4) {
+            return FromRaw(static_cast<Raw>((static_cast<int64_t>(raw) << FRACTION_BITS) / other.raw));
+        } else {
+            return FromRaw(FixedMathDetail::DivShift64(raw, other.raw, FRACTION_BITS));
+        }
+    }
+
+    constexpr FixedPoint operator*(int factor) const {
+        return FromRaw(FixedMathDetail::WrappingMul(raw, static_cast<Raw>(factor)));
+    }
+
+    constexpr FixedPoint operator/(int divisor) const {
+        if (divisor == 0) {
+            return raw >= 0 ? Max() : Min();
+        }
+        // Min() / -1 overflows
+        if (divisor == -1) {
+            return -*this;
+        }
+        return FromRaw(static_cast<Raw>(raw / divisor));
+    }
+
+    FixedPoint& operator+=(FixedPoint other) { return *this = *this + other; }
+    FixedPoint& operator-=(FixedPoint other) { return *this = *this - other; }
+    FixedPoint& operator*=(FixedPoint other) { return *this = *this * other; }
+    FixedPoint& operator/=(FixedPoint other) { return *this = *this / other; }
+    FixedPoint& operator*=(int factor) { return *this = *this * factor; }
+    FixedPoint& operator/=(int divisor) { return *this = *this / divisor; }
+
+    constexpr auto operator<=>(const FixedPoint&) const = default;
+};
+
+template <typename Raw, int FRACTION_BITS>
+constexpr FixedPoint<Raw, FRACTION_BITS> operator*(int factor, FixedPoint<Raw, FRACTION_BITS> value) {
+    return value * factor;
+}
+
+using Fixed = FixedPoint<int32_t, 16>;
+using Fixed64 = FixedPoint<int64_t, 32>;
+
+template <typename S>
+struct FixedVec2T {
+    S x;
+    S y;
+
+    constexpr FixedVec2T() = default;
+    constexpr FixedVec2T(S x, S y) : x(x), y(y) {}
+
+    static FixedVec2T FromFloat(float x, float y) { return FixedVec2T(S::FromFloat(x), S::FromFloat(y)); }
+
+    constexpr FixedVec2T operator-() const { return FixedVec2T(-x, -y); }
+    constexpr FixedVec2T operator+(const FixedVec2T& o) const { return FixedVec2T(x + o.x, y + o.y); }
+    constexpr FixedVec2T operator-(const FixedVec2T& o) const { return FixedVec2T(x - o.x, y - o.y); }
+    constexpr FixedVec2T operator*(S s) const { return FixedVec2T(x * s, y * s); }
+    constexpr FixedVec2T operator/(S s) const { return FixedVec2T(x / s, y / s); }
+
+    FixedVec2T& operator+=(const FixedVec2T& o) { return *this = *this + o; }
+    FixedVec2T& operator-=(const FixedVec2T& o) { return *this = *this - o; }
+    FixedVec2T& operator*=(S s) { return *this = *this * s; }
+    FixedVec2T& operator/=(S s) { return *this = *this / s; }
+
+    constexpr bool operator==(const FixedVec2T&) const = default;
+};
+
+template <typename S>
+struct FixedVec3T {
+    S x;
+    S y;
+    S z;
+
+    constexpr FixedVec3T() = default;
+    constexpr FixedVec3T(S x, S y, S z) : x(x), y(y), z(z) {}
+    constexpr FixedVec3T(const FixedVec2T<S>& xy, S z) : x(xy.x), y(xy.y), z(z) {}
+
+    static FixedVec3T FromFloat(float x, float y, float z) {
+        return FixedVec3T(S::FromFloat(x), S::FromFloat(y), S::FromFloat(z));
+    }
+
+    constexpr FixedVec2T<S> xy() const { return FixedVec2T<S>(x, y); }
+
+    constexpr FixedVec3T operator-() const { return FixedVec3T(-x, -y, -z); }
+    constexpr FixedVec3T operator+(const FixedVec3T& o) const { return FixedVec3T(x + o.x, y + o.y, z + o.z); }
+    constexpr FixedVec3T operator-(const FixedVec3T& o) const { return FixedVec3T(x - o.x, y - o.y, z - o.z); }
+    constexpr FixedVec3T operator*(S s) const { return FixedVec3T(x * s, y * s, z * s); }
+    constexpr FixedVec3T operator/(S s) const { return FixedVec3T(x / s, y / s, z / s); }
+
+    FixedVec3T& operator+=(const FixedVec3T& o) { return *this = *this + o; }
+    FixedVec3T& operator-=(const FixedVec3T& o) { return *this = *this - o; }
+    FixedVec3T& operator*=(S s) { return *this = *this * s; }
+    FixedVec3T& operator/=(S s) { return *this = *this / s; }
+
+    constexpr bool operator==(const FixedVec3T&) const = default;
+};
+
+namespace FixedMath {
+
+template <typename S> constexpr S Abs(S value) { return value < S::Zero() ? -value : value; }
+template <typename S> constexpr S Min(S a, S b) { return b < a ? b : a; }
+template <typename S> constexpr S Max(S a, S b) { return a < b ? b : a; }
+template <typename S> constexpr S Clamp(S value, S low, S high) { return Max(low, Min(value, high)); }
+template <typename S> constexpr S Lerp(S a, S b, S t) { return a + (b - a) * t; }
+
+template <typename S>
+constexpr S Sqrt(S value) {
+    if (value.raw <= 0) {
+        return S::Zero();
+    }
+    uint64_t root = FixedMathDetail::SqrtShifted(static_cast<uint64_t>(value.raw), S::FRACTION);
+    return S::FromRaw(static_cast<decltype(value.raw)>(root));
+}
+
+template <typename S> constexpr S Radians(S degrees) { return degrees * S::Pi() / 180; }
+template <typename S> constexpr S Degrees(S radians) { return radians * 180 / S::Pi(); }
+
+// Angle in degrees wrapped to [0, 360)
+template <typename S>
+constexpr S WrapDegrees(S degrees) {
+    auto full = S::FromInt(360).raw;
+    auto wrapped = degrees.raw % full;
+    return S::FromRaw(wrapped < 0 ? wrapped + full : wrapped);
+}
+
+// Sine of an angle in degrees. The angle is folded into [0, 90] and the
+// Taylor series evaluated there, within two steps of the exact value
+template <typename S>
+constexpr S Sin(S degrees) {
+    auto angle = WrapDegrees(degrees).raw;
+    bool negate = false;
+    if (angle >= S::FromInt(180).raw) {
+        angle -= S::FromInt(180).raw;
+        negate = true;
+    }
+    if (angle > S::FromInt(90).raw) {
+        angle = S::FromInt(180).raw - angle;
+    }
+
+    S x = Radians(S::FromRaw(angle));
+    S x2 = x * x;
+    S series = S::One();
+    for (int n = 14; n >= 2; n -= 2) {
+        series = S::One() - x2 * series / (n * (n + 1));
+    }
+    S result = x * series;
+    return negate ? -result : result;
+}
+
+// Wrapped first so that adding 90 cannot overflow
+template <typename S> constexpr S Cos(S degrees) { return Sin(WrapDegrees(degrees) + S::FromInt(90)); }
+
+// Angle of (x, y) in degrees, in (-180, 180]
+template <typename S>
+constexpr S Atan2(S y, S x) {
+    if (x.raw == 0 && y.raw == 0) {
+        return S::Zero();
+    }
+    // Min() has no positive counterpart; halving both keeps the angle
+    if (x == S::Min() || y == S::Min()) {
+        x = S::FromRaw(x.raw / 2);
+        y = S::FromRaw(y.raw / 2);
+    }
+
+    S ax = Abs(x);
+    S ay = Abs(y);
+    bool steep = ay > ax;
+    S z = steep ? ax / ay : ay / ax;
+
+    // atan(z) = 2 atan(z / (1 + sqrt(1 + z^2))) brings z under tan(22.5)
+    S t = z / (S::One() + Sqrt(S::One() + z * z));
+    S t2 = t * t;
+    S series = S::FromRatio(1, 17);
+    for (int n = 15; n >= 1; n -= 2) {
+        series = S::FromRatio(1, n) - t2 * series;
+    }
+    S angle = Degrees(t * series * 2);
+
+    if (steep) angle = S::FromInt(90) - angle;
+    if (x.raw < 0) angle = S::FromInt(180) - angle;
+    if (y.raw < 0) angle = -angle;
+    return angle;
+}
+
+template <typename S> S Dot(const FixedVec2T<S>& a, const FixedVec2T<S>& b) { return a.x * b.x + a.y * b.y; }
+template <typename S> S Dot(const FixedVec3T<S>& a, const FixedVec3T<S>& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// z of the 3D cross product
+template <typename S> S Cross(const FixedVec2T<S>& a, const FixedVec2T<S>& b) { return a.x * b.y - a.y * b.x; }
+
+template <typename S>
+FixedVec3T<S> Cross(const FixedVec3T<S>& a, const FixedVec3T<S>& b) {
+    return FixedVec3T<S>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+template <typename S> S LengthSquared(const FixedVec2T<S>& v) { return Dot(v, v); }
+template <typename S> S LengthSquared(const FixedVec3T<S>& v) { return Dot(v, v); }
+
+// Q16.16 lengths are taken from the squared raw values in 64 bits, so they
+// do not overflow when the squared length would
+template <typename S>
+S Length(const FixedVec2T<S>& v) {
+    if constexpr (sizeof(v.x.raw) == 4) {
+        uint64_t sum = static_cast<uint64_t>(int64_t(v.x.raw) * v.x.raw) +
+            static_cast<uint64_t>(int64_t(v.y.raw) * v.y.raw);
+        return S::FromRaw(static_cast<int32_t>(FixedMathDetail::SqrtShifted(sum, 0)));
+    } else {
+        return Sqrt(Dot(v, v));
+    }
+}
+
+template <typename S>
+S Length(const FixedVec3T<S>& v) {
+    if constexpr (sizeof(v.x.raw) == 4) {
+        uint64_t sum = static_cast<uint64_t>(int64_t(v.x.raw) * v.x.raw) +
+            static_cast<uint64_t>(int64_t(v.y.raw) * v.y.raw) +
+            static_cast<uint64_t>(int64_t(v.z.raw) * v.z.raw);
+        return S::FromRaw(static_cast<int32_t>(FixedMathDetail::SqrtShifted(sum, 0)));
+    } else {
+        return Sqrt(Dot(v, v));
+    }
+}
+
+template <typename V> auto Distance(const V& a, const V& b) { return Length(b - a); }
+
+// Unit vector, or zero for a zero vector
+template <typename V>
+V Normalize(const V& v) {
+    auto length = Length(v);
+    return length.raw == 0 ? V() : v / length;
+}
+
+// v rotated counterclockwise by degrees
+template <typename S>
+FixedVec2T<S> Rotate(const FixedVec2T<S>& v, S degrees) {
+    S c = Cos(degrees);
+    S s = Sin(degrees);
+    return FixedVec2T<S>(v.x * c - v.y * s, v.x * s + v.y * c);
+}
+
+} // namespace FixedMath
+
+// Row-major 2x2 matrix, for 2D rotation and scale
+template <typename S>
+struct FixedMat2T {
+    S m[2][2];
+
+    static FixedMat2T Identity() { return Scale(FixedVec2T<S>(S::One(), S::One())); }
+
+    static FixedMat2T Scale(const FixedVec2T<S>& scale) {
+        FixedMat2T result{};
+        result.m[0][0] = scale.x;
+        result.m[1][1] = scale.y;
+        return result;
+    }
+
+    static FixedMat2T Rotation(S degrees) {
+        S c = FixedMath::Cos(degrees);
+        S s = FixedMath::Sin(degrees);
+        FixedMat2T result{};
+        result.m[0][0] = c; result.m[0][1] = -s;
+        result.m[1][0] = s; result.m[1][1] = c;
+        return result;
+    }
+
+    FixedVec2T<S> operator*(const FixedVec2T<S>& v) const {
+        return FixedVec2T<S>(m[0][0] * v.x + m[0][1] * v.y, m[1][0] * v.x + m[1][1] * v.y);
+    }
+
+    FixedMat2T operator*(const FixedMat2T& o) const {
+        FixedMat2T result{};
+        for (int r = 0; r < 2; ++r)
+            for (int c = 0; c < 2; ++c)
+                result.m[r][c] = m[r][0] * o.m[0][c] + m[r][1] * o.m[1][c];
+        return result;
+    }
+
+    FixedMat2T Transposed() const {
+        FixedMat2T result{};
+        for (int r = 0; r < 2; ++r)
+            for (int c = 0; c < 2; ++c)
+                result.m[r][c] = m[c][r];
+        return result;
+    }
+};
+
+// Row-major 3x3 matrix, for 3D rotation and scale
+template <typename S>
+struct FixedMat3T {
+    S m[3][3];
+
+    static FixedMat3T Identity() { return Scale(FixedVec3T<S>(S::One(), S::One(), S::One())); }
+
+    static FixedMat3T Scale(const FixedVec3T<S>& scale) {
+        FixedMat3T result{};
+        result.m[0][0] = scale.x;
+        result.m[1][1] = scale.y;
+        result.m[2][2] = scale.z;
+        return result;
+    }
+
+    static FixedMat3T RotationX(S degrees) {
+        S c = FixedMath::Cos(degrees);
+        S s = FixedMath::Sin(degrees);
+        FixedMat3T result = Identity();
+        result.m[1][1] = c; result.m[1][2] = -s;
+        result.m[2][1] = s; result.m[2][2] = c;
+        return result;
+    }
+
+    static FixedMat3T RotationY(S degrees) {
+        S c = FixedMath::Cos(degrees);
+        S s = FixedMath::Sin(degrees);
+        FixedMat3T result = Identity();
+        result.m[0][0] = c; result.m[0][2] = s;
+        result.m[2][0] = -s; result.m[2][2] = c;
+        return result;
+    }
+
+    static FixedMat3T RotationZ(S degrees) {
+        S c = FixedMath::Cos(degrees);
+        S s = FixedMath::Sin(degrees);
+        FixedMat3T result = Identity();
+        result.m[0][0] = c; result.m[0][1] = -s;
+        result.m[1][0] = s; result.m[1][1] = c;
+        return result;
+    }
+
+    FixedVec3T<S> operator*(const FixedVec3T<S>& v) const {
+        return FixedVec3T<S>(
+            m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+            m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+            m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z);
+    }
+
+    FixedMat3T operator*(const FixedMat3T& o) const {
+        FixedMat3T result{};
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                result.m[r][c] = m[r][0] * o.m[0][c] + m[r][1] * o.m[1][c] + m[r][2] * o.m[2][c];
+        return result;
+    }
+
+    FixedMat3T Transposed() const {
+        FixedMat3T result{};
+        for (int r = 0; r < 3; ++r)
+            for (int c = 0; c < 3; ++c)
+                result.m[r][c] = m[c][r];
+        return result;
+    }
+};
+
+using FixedVec2 = FixedVec2T<Fixed>;
+using FixedVec3 = FixedVec3T<Fixed>;
+using FixedMat2 = FixedMat2T<Fixed>;
+using FixedMat3 = FixedMat3T<Fixed>;
+
+using Fixed64Vec2 = FixedVec2T<Fixed64>;
+using Fixed64Vec3 = FixedVec3T<Fixed64>;
+using Fixed64Mat2 = FixedMat2T<Fixed64>;
+using Fixed64Mat3 = FixedMat3T<Fixed64>;
+
+#endif // FIXED_MATH_HPP
@@ -1,6 +1,8 @@
 #include "CollisionSystem.hpp"
 #include "CircleCollider2D.hpp"
 #include "BoxCollider2D.hpp"
+#include "FixedCircleCollider2D.hpp"
+#include "FixedBoxCollider2D.hpp"
 #include "SphereCollider3D.hpp"
 #include "BoxCollider3D.hpp"
 #include "CollisionHelpers.hpp"
@@ -33,6 +35,24 @@ void CollisionSystem::Update(EntityManager& entityManager, std::vector<EventEntr
         
         colliders2D.push_back({entity, collider});
     }
+
+    auto query2DFixedCircle = entityManager.CreateQuery<FixedCircleCollider2D, FixedTransform>();
+    for (auto [entity, collider, transform] : query2DFixedCircle) {
+        if (!collider->isEnabled) continue;
+
+        collider->transform = transform;
+
+        colliders2D.push_back({entity, collider});
+    }
+
+    auto query2DFixedBox = entityManager.CreateQuery<FixedBoxCollider2D, FixedTransform>();
+    for (auto [entity, collider, transform] : query2DFixedBox) {
+        if (!collider->isEnabled) continue;
+
+        collider->transform = transform;
+
+        colliders2D.push_back({entity, collider});
+    }
     
     auto query3D = entityManager.CreateQuery<SphereCollider3D, Transform>();
     for (auto [entity, collider, transform] : query3D) {
@@ -181,6 +201,7 @@ void CollisionSystem::InvokeCollisionEnter(Entity a, Entity b, ICollider* collid
         CollisionInfo infoB = info;
         infoB.otherEntity = a;
         infoB.normal = -infoB.normal; // Flip normal for other collider
+        infoB.fixedNormal = -infoB.fixedNormal;
         colliderB->onCollisionEnter(b, a, infoB);
     }
 }
@@ -197,6 +218,7 @@ void CollisionSystem::InvokeCollisionStay(Entity a, Entity b, ICollider* collide
         CollisionInfo infoB = info;
         infoB.otherEntity = a;
         infoB.normal = -infoB.normal;
+        infoB.fixedNormal = -infoB.fixedNormal;
         colliderB->onCollisionStay(b, a, infoB);
     }
 }
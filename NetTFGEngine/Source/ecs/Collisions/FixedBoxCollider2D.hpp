@@ -0,0 +1,56 @@
+#ifndef FIXEDBOXCOLLIDER2D_HPP
+#define FIXEDBOXCOLLIDER2D_HPP
+
+#include "IFixedCollider2D.hpp"
+#include <vector>
+
+// Deterministic counterpart of BoxCollider2D
+class FixedBoxCollider2D : public IFixedCollider2D {
+public:
+    FixedBoxCollider2D(const FixedVec2& size = FixedVec2(Fixed::One(), Fixed::One()),
+                       const FixedVec2& offset = FixedVec2())
+        : size(size)
+    {
+        this->offset = offset;
+    }
+
+    // Half extents (width/2, height/2)
+    FixedVec2 size;
+
+    // ICollider interface
+    int GetColliderType() const override { return COLLIDER_FIXED_BOX_2D; }
+
+    // IFixedCollider2D generic collision
+    bool CollidesWith(const IFixedCollider2D* other, CollisionInfo& info) const override;
+
+    // Bounds (AABB)
+    FixedVec2 GetMin() const override {
+        return GetCenter() - size;
+    }
+
+    FixedVec2 GetMax() const override {
+        return GetCenter() + size;
+    }
+
+    // Get corners (useful for OBB if entity is rotated)
+    std::vector<FixedVec2> GetCorners() const {
+        FixedVec2 center = GetCenter();
+        Fixed angle = transform ? transform->getRotation().z : Fixed::Zero();
+
+        std::vector<FixedVec2> corners;
+        FixedVec2 localCorners[] = {
+            FixedVec2(-size.x, -size.y),
+            FixedVec2(size.x, -size.y),
+            FixedVec2(size.x, size.y),
+            FixedVec2(-size.x, size.y)
+        };
+
+        for (const auto& local : localCorners) {
+            corners.push_back(center + FixedMath::Rotate(local, angle));
+        }
+
+        return corners;
+    }
+};
+
+#endif // FIXEDBOXCOLLIDER2D_HPP
@@ -0,0 +1,34 @@
+#ifndef FIXEDCIRCLECOLLIDER2D_HPP
+#define FIXEDCIRCLECOLLIDER2D_HPP
+
+#include "IFixedCollider2D.hpp"
+
+// Deterministic counterpart of CircleCollider2D
+class FixedCircleCollider2D : public IFixedCollider2D {
+public:
+    FixedCircleCollider2D(Fixed radius = Fixed::One(), const FixedVec2& offset = FixedVec2())
+        : radius(radius)
+    {
+        this->offset = offset;
+    }
+
+    // Radius
+    Fixed radius;
+
+    // ICollider interface
+    int GetColliderType() const override { return COLLIDER_FIXED_CIRCLE_2D; }
+
+    // IFixedCollider2D generic collision
+    bool CollidesWith(const IFixedCollider2D* other, CollisionInfo& info) const override;
+
+    // Bounds
+    FixedVec2 GetMin() const override {
+        return GetCenter() - FixedVec2(radius, radius);
+    }
+
+    FixedVec2 GetMax() const override {
+        return GetCenter() + FixedVec2(radius, radius);
+    }
+};
+
+#endif // FIXEDCIRCLECOLLIDER2D_HPP
@@ -0,0 +1,139 @@
+#include "FixedCircleCollider2D.hpp"
+#include "FixedBoxCollider2D.hpp"
+
+// Same tests as Collider2D.cpp in fixed point. Bounds are compared before
+// anything is squared, so far-apart colliders cannot overflow Q16.16.
+
+// ==================== FixedCircleCollider2D Implementation ====================
+
+bool FixedCircleCollider2D::CollidesWith(const IFixedCollider2D* other, CollisionInfo& info) const {
+    // Check if other is a FixedCircleCollider2D
+    if (const FixedCircleCollider2D* otherCircle = dynamic_cast<const FixedCircleCollider2D*>(other)) {
+        // Circle vs Circle
+        FixedVec2 center1 = GetCenter();
+        FixedVec2 center2 = otherCircle->GetCenter();
+
+        FixedVec2 delta = center2 - center1;
+        Fixed radiusSum = radius + otherCircle->radius;
+
+        if (FixedMath::Abs(delta.x) >= radiusSum || FixedMath::Abs(delta.y) >= radiusSum) {
+            return false; // No collision
+        }
+
+        Fixed distance = FixedMath::Length(delta);
+        if (distance >= radiusSum) {
+            return false;
+        }
+
+        if (distance > Fixed::Zero()) {
+            FixedVec2 normal = delta / distance;
+            SetContact(info, normal, radiusSum - distance, center1 + normal * radius);
+        } else {
+            // Circles are exactly on top of each other
+            SetContact(info, FixedVec2(Fixed::One(), Fixed::Zero()), radius, center1);
+        }
+
+        return true;
+    }
+
+    // Check if other is a FixedBoxCollider2D
+    if (const FixedBoxCollider2D* otherBox = dynamic_cast<const FixedBoxCollider2D*>(other)) {
+        // Circle vs Box
+        FixedVec2 circleCenter = GetCenter();
+        FixedVec2 boxCenter = otherBox->GetCenter();
+        FixedVec2 boxMin = otherBox->GetMin();
+        FixedVec2 boxMax = otherBox->GetMax();
+
+        // Clamp circle center to box bounds
+        FixedVec2 closestPoint(
+            FixedMath::Clamp(circleCenter.x, boxMin.x, boxMax.x),
+            FixedMath::Clamp(circleCenter.y, boxMin.y, boxMax.y));
+
+        FixedVec2 delta = circleCenter - closestPoint;
+        if (FixedMath::Abs(delta.x) >= radius || FixedMath::Abs(delta.y) >= radius) {
+            return false; // No collision
+        }
+
+        Fixed distance = FixedMath::Length(delta);
+        if (distance >= radius) {
+            return false;
+        }
+
+        if (distance > Fixed::Zero()) {
+            SetContact(info, delta / distance, radius - distance, closestPoint);
+        } else {
+            // Circle center is inside box - find closest edge
+            Fixed distToEdgeX = FixedMath::Min(circleCenter.x - boxMin.x, boxMax.x - circleCenter.x);
+            Fixed distToEdgeY = FixedMath::Min(circleCenter.y - boxMin.y, boxMax.y - circleCenter.y);
+
+            if (distToEdgeX < distToEdgeY) {
+                // Closest to left or right edge
+                Fixed sign = (circleCenter.x < boxCenter.x) ? -Fixed::One() : Fixed::One();
+                SetContact(info, FixedVec2(sign, Fixed::Zero()), radius + distToEdgeX, closestPoint);
+            } else {
+                // Closest to top or bottom edge
+                Fixed sign = (circleCenter.y < boxCenter.y) ? -Fixed::One() : Fixed::One();
+                SetContact(info, FixedVec2(Fixed::Zero(), sign), radius + distToEdgeY, closestPoint);
+            }
+        }
+
+        return true;
+    }
+
+    // Unknown collider type
+    return false;
+}
+
+// ==================== FixedBoxCollider2D Implementation ====================
+
+bool FixedBoxCollider2D::CollidesWith(const IFixedCollider2D* other, CollisionInfo& info) const {
+    // Check if other is a FixedCircleCollider2D
+    if (const FixedCircleCollider2D* otherCircle = dynamic_cast<const FixedCircleCollider2D*>(other)) {
+        // Box vs Circle (use circle's implementation and flip normal)
+        bool result = otherCircle->CollidesWith(this, info);
+        if (result) {
+            SetContact(info, -info.fixedNormal, info.fixedPenetration, info.fixedContactPoint);
+        }
+        return result;
+    }
+
+    // Check if other is a FixedBoxCollider2D
+    if (const FixedBoxCollider2D* otherBox = dynamic_cast<const FixedBoxCollider2D*>(other)) {
+        // Box vs Box (AABB)
+        FixedVec2 min1 = GetMin();
+        FixedVec2 max1 = GetMax();
+        FixedVec2 min2 = otherBox->GetMin();
+        FixedVec2 max2 = otherBox->GetMax();
+
+        // Check for separation
+        if (max1.x < min2.x || min1.x > max2.x ||
+            max1.y < min2.y || min1.y > max2.y) {
+            return false; // No collision
+        }
+
+        // Calculate overlap on each axis
+        Fixed overlapX = FixedMath::Min(max1.x - min2.x, max2.x - min1.x);
+        Fixed overlapY = FixedMath::Min(max1.y - min2.y, max2.y - min1.y);
+
+        FixedVec2 center1 = GetCenter();
+        FixedVec2 center2 = otherBox->GetCenter();
+
+        // Find axis of least penetration
+        if (overlapX < overlapY) {
+            // Separate on X axis
+            Fixed direction = (center2.x > center1.x) ? Fixed::One() : -Fixed::One();
+            FixedVec2 contact((center2.x > center1.x) ? min2.x : max2.x, (center1.y + center2.y) / 2);
+            SetContact(info, FixedVec2(direction, Fixed::Zero()), overlapX, contact);
+        } else {
+            // Separate on Y axis
+            Fixed direction = (center2.y > center1.y) ? Fixed::One() : -Fixed::One();
+            FixedVec2 contact((center1.x + center2.x) / 2, (center2.y > center1.y) ? min2.y : max2.y);
+            SetContact(info, FixedVec2(Fixed::Zero(), direction), overlapY, contact);
+        }
+
+        return true;
+    }
+
+    // Unknown collider type
+    return false;
+}
@@ -2,6 +2,7 @@
 #define ICOLLIDER_HPP
 
 #include "ecs/ecs.hpp"
+#include "Utils/FixedMath.hpp"
 #include <glm/glm.hpp>
 #include <functional>
 
@@ -36,6 +37,11 @@ struct CollisionInfo {
     glm::vec3 normal;        // Collision normal
     float penetration;       // Penetration depth
     glm::vec3 contactPoint;  // Point of contact
+
+    // The same contact in fixed point, set between fixed-point colliders
+    FixedVec2 fixedNormal;
+    Fixed fixedPenetration;
+    FixedVec2 fixedContactPoint;
 };
 
 // Collision callback function types
@@ -123,7 +129,9 @@ enum ColliderType {
     COLLIDER_SPHERE_3D = 3,
     COLLIDER_BOX_3D = 4,
     COLLIDER_CAPSULE_3D = 5,
-    COLLIDER_MESH_3D = 6
+    COLLIDER_MESH_3D = 6,
+    COLLIDER_FIXED_CIRCLE_2D = 7,
+    COLLIDER_FIXED_BOX_2D = 8
 };
 
 #endif // ICOLLIDER_HPP
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef IFIXEDCOLLIDER2D_HPP
+#define IFIXEDCOLLIDER2D_HPP
+
+#include "ICollider.hpp"
+#include "ecs/ecs_common.hpp"
+
+// Base 2D collider in fixed point, positioned by the entity's FixedTransform.
+// Fixed-point colliders only collide with each other, so a whole collision
+// pass gives the same contacts on every machine.
+class IFixedCollider2D : public ICollider {
+public:
+    virtual ~IFixedCollider2D() = default;
+
+    bool CheckCollision(const ICollider* other, CollisionInfo& info) const override {
+        const IFixedCollider2D* otherFixed = dynamic_cast<const IFixedCollider2D*>(other);
+        if (!otherFixed) return false;
+        return otherFixed->CollidesWith(this, info);
+    }
+
+    // Generic collision check - override in concrete classes
+    virtual bool CollidesWith(const IFixedCollider2D* other, CollisionInfo& info) const = 0;
+
+    // Get 2D bounds (for broad phase)
+    virtual FixedVec2 GetMin() const = 0;
+    virtual FixedVec2 GetMax() const = 0;
+
+    // Get center in world space
+    FixedVec2 GetCenter() const {
+        if (!transform) return offset;
+        return transform->getPosition().xy() + offset;
+    }
+
+    // Offset from entity position
+    FixedVec2 offset;
+
+    // Reference to entity's transform (set by collision system)
+    FixedTransform* transform = nullptr;
+
+protected:
+    // Fills both the fixed-point and the float fields of info
+    static void SetContact(CollisionInfo& info, const FixedVec2& normal, Fixed penetration,
+                           const FixedVec2& contactPoint) {
+        info.fixedNormal = normal;
+        info.fixedPenetration = penetration;
+        info.fixedContactPoint = contactPoint;
+        info.normal = glm::vec3(normal.x.ToFloat(), normal.y.ToFloat(), 0.0f);
+        info.penetration = penetration.ToFloat();
+        info.contactPoint = glm::vec3(contactPoint.x.ToFloat(), contactPoint.y.ToFloat(), 0.0f);
+    }
+};
+
+#endif // IFIXEDCOLLIDER2D_HPP
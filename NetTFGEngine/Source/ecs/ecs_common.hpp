@@ -4,6 +4,7 @@
 #include "netcode/netcode_common.hpp"
 #include "ecs.hpp"
 #include "OpenGL/Mesh.hpp"
+#include "Utils/FixedMath.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
@@ -133,6 +134,55 @@ private:
     }
 };
 
+// Transform in fixed point, for simulations that must give bit-identical
+// results on every machine. Games opting in move entities through it, store
+// its raw values in the game state and copy it into a Transform to render.
+class FixedTransform : public IComponent {
+public:
+    FixedTransform()
+        : scale(Fixed::One(), Fixed::One(), Fixed::One())
+    {}
+
+    // Position
+    void setPosition(const FixedVec3& pos) { position = pos; }
+    void translate(const FixedVec3& delta) { position += delta; }
+    const FixedVec3& getPosition() const { return position; }
+
+    // Rotation (Euler angles in degrees, kept in [0, 360))
+    void setRotation(const FixedVec3& rot) {
+        rotation = FixedVec3(FixedMath::WrapDegrees(rot.x), FixedMath::WrapDegrees(rot.y),
+            FixedMath::WrapDegrees(rot.z));
+    }
+
+    void rotate(const FixedVec3& delta) { setRotation(rotation + delta); }
+    const FixedVec3& getRotation() const { return rotation; }
+
+    // Scale
+    void setScale(const FixedVec3& scl) { scale = scl; }
+    void setScale(Fixed uniformScale) { scale = FixedVec3(uniformScale, uniformScale, uniformScale); }
+    const FixedVec3& getScale() const { return scale; }
+
+    // Rotation and scale, applied in the same order as Transform's model matrix
+    FixedMat3 getBasis() const {
+        return FixedMat3::RotationX(rotation.x) * FixedMat3::RotationY(rotation.y) *
+            FixedMat3::RotationZ(rotation.z) * FixedMat3::Scale(scale);
+    }
+
+    // Local point to world space
+    FixedVec3 transformPoint(const FixedVec3& local) const { return position + getBasis() * local; }
+
+    void ApplyTo(Transform& transform) const {
+        transform.setPosition(glm::vec3(position.x.ToFloat(), position.y.ToFloat(), position.z.ToFloat()));
+        transform.setRotation(glm::vec3(rotation.x.ToFloat(), rotation.y.ToFloat(), rotation.z.ToFloat()));
+        transform.setScale(glm::vec3(scale.x.ToFloat(), scale.y.ToFloat(), scale.z.ToFloat()));
+    }
+
+private:
+    FixedVec3 position;
+    FixedVec3 rotation;
+    FixedVec3 scale;
+};
+
 struct PointLightComponent : public IComponent {
     glm::vec3 color = glm::vec3(1.0f);
     float     intensity = 1.0f;   // candelas
@@ -11,6 +11,8 @@
 #include "Collisions/CircleCollider2D.hpp"
 #include "Collisions/BoxCollider3D.hpp"
 #include "Collisions/SphereCollider3D.hpp"
+#include "Collisions/FixedBoxCollider2D.hpp"
+#include "Collisions/FixedCircleCollider2D.hpp"
 
 #include "OpenAL/AudioComponents.hpp"
 
@@ -72,6 +74,7 @@ public:
 		deltaProcessor = new DeltaProcessor(isServer);
 
         world.GetEntityManager().RegisterComponentType<Transform>();
+        world.GetEntityManager().RegisterComponentType<FixedTransform>();
         world.GetEntityManager().RegisterComponentType<Playable>();
 
         if (isServer) {
@@ -79,6 +82,8 @@ public:
             world.GetEntityManager().RegisterComponentType<CircleCollider2D>();
             world.GetEntityManager().RegisterComponentType<BoxCollider3D>();
             world.GetEntityManager().RegisterComponentType<SphereCollider3D>();
+            world.GetEntityManager().RegisterComponentType<FixedBoxCollider2D>();
+            world.GetEntityManager().RegisterComponentType<FixedCircleCollider2D>();
             world.AddSystem(std::make_unique<CollisionSystem>());
         }
 
@@ -91,10 +96,14 @@ public:
 		GameState_To_ECSWorld(state);
 	}
 
+    // Steps the world, which already holds the previous frame, and writes
+    // the result to state. Only the server serializes the previous frame
+    // too, to generate deltas from.
     void SimulateFrame(GameStateBlob& state, std::vector<EventEntry> events, std::map<int, InputEntry> inputs) override {
         GameStateBlob prevState;
-        ECSWorld_To_GameState(prevState);
-		//GameState_To_ECSWorld(state);
+        if (isServer) {
+            ECSWorld_To_GameState(prevState);
+        }
         this->generatedEvents.clear();
 		this->generatedDeltas.clear();
 
@@ -102,7 +111,7 @@ public:
 
         ProcessEvents(events);
 		ProcessInputs(inputs);
-        gameFinished = world.Update(isServer, 1.0f / TICKS_PER_SECOND);
+        gameFinished = world.Update(isServer, 1.0f / ticksPerSecond);
         
         ECSWorld_To_GameState(state);
 
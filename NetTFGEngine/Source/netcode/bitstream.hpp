@@ -0,0 +1,343 @@
+#ifndef BITSTREAM_H
+#define BITSTREAM_H
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+// Bounded bit-level streams used by every netcode packet schema.
+//
+// A schema is written once as
+//     template<typename Stream> bool Serialize(Stream& stream, XPacket& packet)
+// and run with a WriteStream to encode, a ReadStream to decode and a
+// MeasureStream to size the packet before encoding it in place. Every
+// Serialize* call reads or writes its argument depending on the stream and
+// returns false when the data does not fit or is out of range, so a truncated
+// or corrupt packet is rejected instead of being read past its end.
+//
+// Bits are packed LSB first. Byte arrays are aligned to a byte boundary and
+// copied as a block.
+
+inline int BitsRequired(uint32_t range) {
+    int bits = 0;
+    while (range > 0) {
+        bits++;
+        range >>= 1;
+    }
+    return bits;
+}
+
+class BitWriter {
+public:
+    BitWriter(uint8_t* buffer, size_t capacityBytes)
+        : buf(buffer), capacityBits(capacityBytes * 8) {
+    }
+
+    bool WriteBits(uint32_t value, int bits) {
+        if (bits <= 0) return true;
+        if (bitsWritten + bits > capacityBits) {
+            overflow = true;
+            return false;
+        }
+
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        scratch |= (uint64_t(value) & mask) << scratchBits;
+        scratchBits += bits;
+        bitsWritten += bits;
+
+        while (scratchBits >= 8) {
+            buf[byteIndex++] = static_cast<uint8_t>(scratch);
+            scratch >>= 8;
+            scratchBits -= 8;
+        }
+        return true;
+    }
+
+    bool AlignToByte() {
+        return scratchBits == 0 || WriteBits(0, 8 - scratchBits);
+    }
+
+    bool WriteBytes(const uint8_t* data, size_t len) {
+        if (!AlignToByte()) return false;
+        if (bitsWritten + len * 8 > capacityBits) {
+            overflow = true;
+            return false;
+        }
+        std::memcpy(buf + byteIndex, data, len);
+        byteIndex += len;
+        bitsWritten += len * 8;
+        return true;
+    }
+
+    // Writes out the last partial byte
+    void Flush() {
+        if (scratchBits > 0) {
+            buf[byteIndex++] = static_cast<uint8_t>(scratch);
+            scratch = 0;
+            bitsWritten += 8 - scratchBits;
+            scratchBits = 0;
+        }
+    }
+
+    size_t BytesWritten() const { return (bitsWritten + 7) / 8; }
+    bool Overflowed() const { return overflow; }
+
+private:
+    uint8_t* buf;
+    size_t capacityBits;
+    size_t bitsWritten = 0;
+    size_t byteIndex = 0;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+    bool overflow = false;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* buffer, size_t lenBytes)
+        : buf(buffer), lenBits(lenBytes * 8) {
+    }
+
+    bool ReadBits(uint32_t& value, int bits) {
+        if (bits <= 0) {
+            value = 0;
+            return true;
+        }
+        if (bitsRead + bits > lenBits) return false;
+
+        while (scratchBits < bits) {
+            scratch |= uint64_t(buf[byteIndex++]) << scratchBits;
+            scratchBits += 8;
+        }
+
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        value = static_cast<uint32_t>(scratch & mask);
+        scratch >>= bits;
+        scratchBits -= bits;
+        bitsRead += bits;
+        return true;
+    }
+
+    bool AlignToByte() {
+        uint32_t padding = 0;
+        return scratchBits == 0 || ReadBits(padding, scratchBits);
+    }
+
+    bool ReadBytes(uint8_t* data, size_t len) {
+        if (!AlignToByte()) return false;
+        if (bitsRead + len * 8 > lenBits) return false;
+        std::memcpy(data, buf + byteIndex, len);
+        byteIndex += len;
+        bitsRead += len * 8;
+        return true;
+    }
+
+private:
+    const uint8_t* buf;
+    size_t lenBits;
+    size_t bitsRead = 0;
+    size_t byteIndex = 0;
+    uint64_t scratch = 0;
+    int scratchBits = 0;
+};
+
+// Encodings shared by the three streams. Derived supplies SerializeBits,
+// SerializeBytes and the IsWriting/IsReading flags.
+template<typename Derived>
+class StreamBase {
+public:
+    bool SerializeBool(bool& value) {
+        uint32_t bit = value ? 1 : 0;
+        if (!Self().SerializeBits(bit, 1)) return false;
+        if (Derived::IsReading) {
+            value = bit != 0;
+        }
+        return true;
+    }
+
+    // value in [min, max], using only the bits the range needs
+    bool SerializeInt(int& value, int min, int max) {
+        if (Derived::IsWriting && (value < min || value > max)) return false;
+        uint32_t offset = static_cast<uint32_t>(value - min);
+        if (!Self().SerializeBits(offset, BitsRequired(static_cast<uint32_t>(max - min)))) return false;
+        if (Derived::IsReading) {
+            if (offset > static_cast<uint32_t>(max - min)) return false;
+            value = min + static_cast<int>(offset);
+        }
+        return true;
+    }
+
+    // 7 bits per group plus a continuation bit; small values take one byte
+    bool SerializeVarint(uint32_t& value) {
+        if (Derived::IsWriting) {
+            uint32_t remaining = value;
+            do {
+                uint32_t group = remaining & 0x7F;
+                remaining >>= 7;
+                uint32_t more = remaining != 0 ? 1 : 0;
+                if (!Self().SerializeBits(group, 7) || !Self().SerializeBits(more, 1)) return false;
+            } while (remaining != 0);
+            return true;
+        }
+
+        uint32_t result = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint32_t group = 0, more = 0;
+            if (!Self().SerializeBits(group, 7) || !Self().SerializeBits(more, 1)) return false;
+            result |= group << shift;
+            if (!more) {
+                value = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Non-negative int as a varint
+    bool SerializeVarint(int& value) {
+        if (Derived::IsWriting && value < 0) return false;
+        uint32_t v = static_cast<uint32_t>(value);
+        if (!SerializeVarint(v)) return false;
+        if (Derived::IsReading) {
+            if (static_cast<int>(v) < 0) return false;
+            value = static_cast<int>(v);
+        }
+        return true;
+    }
+
+    // Any int, zigzag encoded so small negatives stay short
+    bool SerializeSignedVarint(int& value) {
+        uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        if (!SerializeVarint(zigzag)) return false;
+        if (Derived::IsReading) {
+            value = static_cast<int>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        }
+        return true;
+    }
+
+    bool SerializeUint64(uint64_t& value) {
+        uint32_t low = static_cast<uint32_t>(value);
+        uint32_t high = static_cast<uint32_t>(value >> 32);
+        if (!Self().SerializeBits(low, 32) || !Self().SerializeBits(high, 32)) return false;
+        if (Derived::IsReading) {
+            value = (static_cast<uint64_t>(high) << 32) | low;
+        }
+        return true;
+    }
+
+    // value clamped to [min, max] and quantized to steps of at most resolution
+    bool SerializeFloat(float& value, float min, float max, float resolution) {
+        uint32_t steps = static_cast<uint32_t>(std::ceil((max - min) / resolution));
+        uint32_t quantized = 0;
+        if (Derived::IsWriting) {
+            float normalized = (std::clamp(value, min, max) - min) / (max - min);
+            quantized = static_cast<uint32_t>(std::lround(normalized * steps));
+        }
+        if (!Self().SerializeBits(quantized, BitsRequired(steps))) return false;
+        if (Derived::IsReading) {
+            if (quantized > steps) return false;
+            value = min + (max - min) * static_cast<float>(quantized) / static_cast<float>(steps);
+        }
+        return true;
+    }
+
+    // Low 16 bits of a frame number. The reader rebuilds the full frame as the
+    // one closest to its reference frame, so both ends must stay within
+    // 32768 frames of each other; absolute anchors use SerializeFullFrame.
+    bool SerializeFrame(int& frame) {
+        uint32_t low = static_cast<uint32_t>(frame) & 0xFFFF;
+        if (!Self().SerializeBits(low, 16)) return false;
+        if (Derived::IsReading) {
+            int reference = Self().ReferenceFrame();
+            int16_t diff = static_cast<int16_t>(static_cast<uint16_t>(low - (static_cast<uint32_t>(reference) & 0xFFFF)));
+            frame = reference + diff;
+        }
+        return true;
+    }
+
+    bool SerializeFullFrame(int& frame) {
+        return SerializeSignedVarint(frame);
+    }
+
+    // Length-prefixed byte array of at most maxLen bytes
+    bool SerializeBlob(uint8_t* data, int& len, int maxLen) {
+        return SerializeInt(len, 0, maxLen) && Self().SerializeBytes(data, static_cast<size_t>(len));
+    }
+
+    // NUL-terminated string stored in a char buffer of capacity bytes
+    bool SerializeString(char* str, size_t capacity) {
+        int len = Derived::IsWriting ? static_cast<int>(strnlen(str, capacity - 1)) : 0;
+        if (!SerializeInt(len, 0, static_cast<int>(capacity - 1))) return false;
+        if (!Self().SerializeBytes(reinterpret_cast<uint8_t*>(str), static_cast<size_t>(len))) return false;
+        if (Derived::IsReading) {
+            str[len] = '\0';
+        }
+        return true;
+    }
+
+private:
+    Derived& Self() { return static_cast<Derived&>(*this); }
+};
+
+class WriteStream : public StreamBase<WriteStream> {
+public:
+    static constexpr bool IsWriting = true;
+    static constexpr bool IsReading = false;
+
+    WriteStream(uint8_t* buffer, size_t capacityBytes) : writer(buffer, capacityBytes) {}
+
+    bool SerializeBits(uint32_t& value, int bits) { return writer.WriteBits(value, bits); }
+    bool SerializeBytes(uint8_t* data, size_t len) { return writer.WriteBytes(data, len); }
+    int ReferenceFrame() const { return 0; }
+
+    void Flush() { writer.Flush(); }
+    size_t BytesUsed() const { return writer.BytesWritten(); }
+
+private:
+    BitWriter writer;
+};
+
+class ReadStream : public StreamBase<ReadStream> {
+public:
+    static constexpr bool IsWriting = false;
+    static constexpr bool IsReading = true;
+
+    ReadStream(const uint8_t* buffer, size_t lenBytes, int referenceFrame)
+        : reader(buffer, lenBytes), reference(referenceFrame) {
+    }
+
+    bool SerializeBits(uint32_t& value, int bits) { return reader.ReadBits(value, bits); }
+    bool SerializeBytes(uint8_t* data, size_t len) { return reader.ReadBytes(data, len); }
+    int ReferenceFrame() const { return reference; }
+
+private:
+    BitReader reader;
+    int reference;
+};
+
+// Runs a schema in writing mode without storing anything, to learn the size
+class MeasureStream : public StreamBase<MeasureStream> {
+public:
+    static constexpr bool IsWriting = true;
+    static constexpr bool IsReading = false;
+
+    bool SerializeBits(uint32_t&, int bits) {
+        bitsUsed += bits;
+        return true;
+    }
+
+    bool SerializeBytes(uint8_t*, size_t len) {
+        bitsUsed = (bitsUsed + 7) / 8 * 8 + len * 8;
+        return true;
+    }
+
+    int ReferenceFrame() const { return 0; }
+
+    size_t BytesUsed() const { return (bitsUsed + 7) / 8; }
+
+private:
+    size_t bitsUsed = 0;
+};
+
+#endif // BITSTREAM_H
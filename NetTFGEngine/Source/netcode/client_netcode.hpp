@@ -1,6 +1,7 @@
 #ifndef CLIENT_NETCODE_H
 #define CLIENT_NETCODE_H
 #include "netcode_common.hpp"
+#include "input_predictor.hpp"
 #include "Utils/Debug/Debug.hpp"
 #include <functional>
 #include <map>
@@ -15,13 +16,52 @@ public:
 		SetGameLogic(std::move(logic));
 	}
 
-	int SubmitLocalInput(const InputBlob& input)
+	// Applies a local input inputDelay frames from now and appends what was
+	// submitted to entries. After the delay grew the input also fills the
+	// frames it skips; after it shrank the frame has an input already and
+	// this one is dropped.
+	void SubmitLocalInput(const InputBlob& input, std::vector<InputEntry>& entries)
 	{
 		std::lock_guard<std::mutex> lock(mtx);
-		Snapshot& currentSnapshot = GetSnapshot(currentFrame);
-		currentSnapshot.inputs[localPlayerId] = InputEntry{ currentFrame, input, localPlayerId };
+		int targetFrame = currentFrame + inputDelay;
+		for (int frame = std::max(lastInputFrame + 1, currentFrame); frame <= targetFrame; ++frame)
+		{
+			InputEntry entry{ frame, input, localPlayerId };
+			GetSnapshot(frame).inputs[localPlayerId] = entry;
+			entries.push_back(entry);
+		}
+		lastInputFrame = std::max(lastInputFrame, targetFrame);
+	}
 
-		return currentFrame;
+	// Frames between sampling a local input and the frame it is applied at.
+	// Each frame of delay takes a frame off the prediction, and so off the
+	// rollbacks.
+	void SetInputDelay(int frames)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		inputDelay = std::clamp(frames, 0, MAX_INPUT_DELAY_FRAMES);
+	}
+
+	int GetInputDelay() const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return inputDelay;
+	}
+
+	// Furthest the prediction may run past the last confirmed frame, which
+	// bounds the frames a rollback re-simulates
+	void SetPredictionWindow(int frames)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		predictionWindow = std::max(frames, 1);
+	}
+
+	// False while the prediction is as far ahead as the window allows: the
+	// caller skips the tick and waits for the server to confirm more frames
+	bool CanAdvance() const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return currentFrame - lastConfirmedFrame < predictionWindow;
 	}
 
 	void OnServerEventUpdate(const EventEntry& event)
@@ -37,17 +77,73 @@ public:
 		// Store the server-confirmed input in the corresponding snapshot
 		Snapshot& snapshot = GetSnapshot(inputEntry.frame);
 		snapshot.inputs[inputEntry.playerId] = inputEntry;
+
+		if (inputEntry.playerId == localPlayerId)
+		{
+			return;
+		}
+
+		RemotePlayer& remote = remotePlayers[inputEntry.playerId];
+		remote.known[inputEntry.frame] = inputEntry;
+		while (remote.known.size() > INPUT_HISTORY_FRAMES)
+		{
+			remote.known.erase(remote.known.begin());
+		}
+
+		// The frame was predicted with a guess: score it
+		auto guess = snapshot.predictedInputs.find(inputEntry.playerId);
+		if (guess != snapshot.predictedInputs.end())
+		{
+			remote.stats.predicted++;
+			if (guess->second != inputEntry.input)
+			{
+				remote.stats.mispredicted++;
+			}
+			snapshot.predictedInputs.erase(guess);
+		}
 	}
 
+	// Guesses inputs of remote players that have not arrived. Defaults to
+	// repeating each player's last input; null predicts nothing.
+	void SetInputPredictor(std::unique_ptr<IInputPredictor> predictor)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		inputPredictor = std::move(predictor);
+	}
+
+	// Guesses scored so far, by remote player
+	std::map<int, InputPredictionStats> GetInputPredictionStats() const
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		std::map<int, InputPredictionStats> stats;
+		for (const auto& [playerId, remote] : remotePlayers)
+		{
+			stats[playerId] = remote.stats;
+		}
+		return stats;
+	}
+
+	// Least number of frames the prediction stays ahead of the confirmed state
 	void UpdateCurrentFrame(int framesAboveServer)
 	{
 		std::lock_guard<std::mutex> lock(mtx);
 		framesAheadOfServer = framesAboveServer;
 	}
 
-	void OnServerDeltasUpdate(std::vector<DeltaStateBlob>& deltas, int& deltaFrame)
+	// Deltas the server computed against the state the client confirmed at
+	// baseFrame. They only confirm deltaFrame on top of that state or a
+	// newer one; otherwise an update in between was lost, and the server
+	// resends its changes against the base the client acks.
+	void OnServerDeltasUpdate(const std::vector<DeltaStateBlob>& deltas, int deltaFrame, int baseFrame)
 	{
 		std::lock_guard<std::mutex>lock(mtx);
+
+		// Deltas travel unsequenced: one older than the confirmed frame is stale
+		if (deltaFrame < lastConfirmedFrame || baseFrame > lastConfirmedFrame)
+		{
+			return;
+		}
+
 		Snapshot& snapshot = GetSnapshot(deltaFrame);
 		lastConfirmedFrame = deltaFrame;
 		snapshot.stateConfirmed = true;
@@ -66,19 +162,21 @@ public:
 
 		if (needsCorrection)
 		{
-			currentFrame = lastConfirmedFrame + framesAheadOfServer;
+			// The client's own clock decides how far ahead it runs; only one
+			// that fell behind the server is moved forward
+			currentFrame = std::max(currentFrame, lastConfirmedFrame + framesAheadOfServer);
 
-			gameLogic->Synchronize(snapshot.state);
+			RestoreWorld(deltaFrame);
 
 			// Re-simulate all frames after the server frame
 			for (int frame = deltaFrame; frame < currentFrame; ++frame) {
 				SimulateFrame(frame, true);
 			}
+			CountRollback(deltaFrame);
 
 			// Update current client state from the last predicted snapshotQ
 			Snapshot& lastSnapshot = GetSnapshot(currentFrame);
-			currentState.len = lastSnapshot.state.len;
-			memcpy(currentState.data, lastSnapshot.state.data, currentState.len);
+			currentState.CopyBytesFrom(lastSnapshot.state);
 
 			Debug::Info("ClientNetcode") << "[CLIENT] Reconciled to server state at frame " << deltaFrame
 				<< ". Current frame: " << currentFrame << "\n";
@@ -93,49 +191,36 @@ public:
 
 		//Debug::Info("Client Netcode") << "Received server state\n";
 
-		Snapshot& snapshot = GetSnapshot(update.frame);
-		lastConfirmedFrame = update.frame;
-		snapshot.stateConfirmed = true;
-		latestServerState = update.state;
-		latestServerState.frame = update.frame;
-
-
+		ReconcileToServerState(update.frame, update.state);
+	}
 
+	// Overwrites the sections of the state at frame that the server found
+	// diverged, keeps the rest, and reconciles as for a full state. A repair
+	// older than the confirmed frame is dropped; the next hash check retries.
+	void OnServerStateRepair(int frame, const GameStateBlob& source, const std::vector<StateSection>& sections)
+	{
+		std::lock_guard<std::mutex>lock(mtx);
 
-		if (gameLogic->CompareStates(snapshot.state, update.state))
+		if (frame < lastConfirmedFrame)
 		{
-			return; // No reconciliation needed
+			return;
 		}
 
-		//std::cout << "aaaa\n";
-		//gameLogic->PrintState(latestServerState);
-		//gameLogic->PrintState(snapshot.state);
-
-		currentFrame = lastConfirmedFrame + framesAheadOfServer;
-
-		// Copy server state safely into snapshot
-		snapshot.state.len = update.state.len;
-		if (snapshot.state.len > sizeof(snapshot.state.data))
-			snapshot.state.len = sizeof(snapshot.state.data);
-		memcpy(snapshot.state.data, update.state.data, snapshot.state.len);
-
-		gameLogic->Synchronize(snapshot.state);
-
-		// Re-simulate all frames after the server frame
-		for (int frame = update.frame; frame < currentFrame; ++frame) {
-			SimulateFrame(frame, true);
+		GameStateBlob repaired = GetSnapshot(frame).state;
+		repaired.Resize(source.len);
+		uint8_t* bytes = repaired.MutableData();
+		for (const StateSection& section : sections)
+		{
+			if (section.offset + section.len <= static_cast<uint32_t>(repaired.len))
+			{
+				memcpy(bytes + section.offset, source.Data() + section.offset, section.len);
+			}
 		}
 
-		// Update current client state from the last predicted snapshotQ
-		Snapshot& lastSnapshot = GetSnapshot(currentFrame);
-		currentState.len = lastSnapshot.state.len;
-		memcpy(currentState.data, lastSnapshot.state.data, currentState.len);
-
-		Debug::Info("ClientNetcode") << "[CLIENT] Reconciled to server state at frame " << update.frame
-			<< ". Current frame: " << currentFrame << "\n";
-
-		RemoveYetConfirmedSnapshots();
+		Debug::Info("ClientNetcode") << "[CLIENT] Repairing " << sections.size()
+			<< " state sections at frame " << frame << "\n";
 
+		ReconcileToServerState(frame, repaired);
 	}
 
 	void Tick()
@@ -160,6 +245,8 @@ public:
 		currentState.frame = 0;
 		currentFrame = 0;
 		lastConfirmedFrame = 0;
+		lastInputFrame = -1;
+		worldFrame = 0;
 		//Create initial snapshot
 		Snapshot& initSnapshot = GetSnapshot(0);
 
@@ -175,6 +262,27 @@ public:
 		return latestServerState;
 	}
 
+	int GetCurrentFrame() const {
+		std::lock_guard<std::mutex> lock(mtx);
+		return currentFrame;
+	}
+
+	int GetLastConfirmedFrame() const {
+		std::lock_guard<std::mutex> lock(mtx);
+		return lastConfirmedFrame;
+	}
+
+	// Reconciliations that rolled back and re-simulated, and the frames they re-simulated
+	uint64_t GetRollbackCount() const {
+		std::lock_guard<std::mutex> lock(mtx);
+		return rollbackCount;
+	}
+
+	uint64_t GetResimulatedFrames() const {
+		std::lock_guard<std::mutex> lock(mtx);
+		return resimulatedFrames;
+	}
+
 	IGameLogic* GetGameLogic() const {
 		return gameLogic.get();
 	}
@@ -188,15 +296,29 @@ public:
 	}
 
 private:
+	static constexpr size_t INPUT_HISTORY_FRAMES = 32;     // Known inputs kept per remote player
+
+	struct RemotePlayer {
+		std::map<int, InputEntry> known;        // Latest inputs by frame
+		InputPredictionStats stats;
+	};
 
 	std::unique_ptr<IGameLogic> gameLogic;
 	int localPlayerId;
+	std::unique_ptr<IInputPredictor> inputPredictor = std::make_unique<RepeatLastInputPredictor>();
+	std::map<int, RemotePlayer> remotePlayers;
 
 	GameStateBlob currentState;
 	GameStateBlob latestServerState;
 	int currentFrame = 0;           // Current client frame
 	int lastConfirmedFrame = 0;
-	int framesAheadOfServer = 0;
+	int framesAheadOfServer = 0;    // Minimum lead over lastConfirmedFrame after a correction
+	int worldFrame = -1;            // Frame the game logic's own world is at, -1 if unknown
+	int inputDelay = 0;
+	int lastInputFrame = -1;        // Latest frame given a local input
+	int predictionWindow = MAX_ROLLBACK_FRAMES;
+	uint64_t rollbackCount = 0;
+	uint64_t resimulatedFrames = 0;
 
 	std::map<int, Snapshot> snapshots;
 
@@ -228,24 +350,108 @@ private:
 		return snapshots[frame];
 	}
 
+	// Assumes caller holds mtx lock
+	void ReconcileToServerState(int frame, const GameStateBlob& state)
+	{
+		Snapshot& snapshot = GetSnapshot(frame);
+		lastConfirmedFrame = frame;
+		snapshot.stateConfirmed = true;
+		latestServerState = state;
+		latestServerState.frame = frame;
+
+		if (gameLogic->CompareStates(snapshot.state, state))
+		{
+			return; // No reconciliation needed
+		}
+
+		// The client's own clock decides how far ahead it runs; only one
+		// that fell behind the server is moved forward
+		currentFrame = std::max(currentFrame, lastConfirmedFrame + framesAheadOfServer);
+
+		snapshot.state.CopyBytesFrom(state);
+
+		RestoreWorld(frame);
+
+		// Re-simulate all frames after the server frame
+		for (int f = frame; f < currentFrame; ++f) {
+			SimulateFrame(f, true);
+		}
+		CountRollback(frame);
+
+		// Update current client state from the last predicted snapshotQ
+		Snapshot& lastSnapshot = GetSnapshot(currentFrame);
+		currentState.CopyBytesFrom(lastSnapshot.state);
+
+		Debug::Info("ClientNetcode") << "[CLIENT] Reconciled to server state at frame " << frame
+			<< ". Current frame: " << currentFrame << "\n";
+
+		RemoveYetConfirmedSnapshots();
+	}
+
+	void CountRollback(int fromFrame)
+	{
+		rollbackCount++;
+		if (currentFrame > fromFrame) resimulatedFrames += static_cast<uint64_t>(currentFrame - fromFrame);
+	}
+
+	// Fills in a guess for every remote player without an input at frame and
+	// remembers it in the snapshot, to score once the real input arrives.
+	// A rollback guesses again with what is known by then.
+	void PredictMissingInputs(int frame, Snapshot& snapshot, std::map<int, InputEntry>& inputs)
+	{
+		snapshot.predictedInputs.clear();
+		if (!inputPredictor)
+		{
+			return;
+		}
+
+		for (const auto& [playerId, remote] : remotePlayers)
+		{
+			InputBlob guess;
+			if (inputs.count(playerId) == 0 &&
+				inputPredictor->PredictInput(playerId, frame, remote.known, guess))
+			{
+				snapshot.predictedInputs[playerId] = guess;
+				inputs[playerId] = InputEntry{ frame, guess, playerId };
+			}
+		}
+	}
+
+	// Loads the snapshot at frame into the game logic's world
+	void RestoreWorld(int frame)
+	{
+		gameLogic->Synchronize(GetSnapshot(frame).state);
+		worldFrame = frame;
+	}
+
+	// The world is only restored from the snapshot when it is not at frame
+	// already, so a rollback restores it once and then steps it forward
+	// frame after frame, serializing each result into its snapshot.
 	void SimulateFrame(int frame, bool debug)
 	{
 		// Get the snapshot for this frame
 		Snapshot& currentSnapshot = GetSnapshot(frame);
 
-		gameLogic->Synchronize(currentSnapshot.state);
+		if (worldFrame != frame)
+		{
+			RestoreWorld(frame);
+		}
+
+		std::map<int, InputEntry> inputs = currentSnapshot.inputs;
+		PredictMissingInputs(frame, currentSnapshot, inputs);
 
 		// Create a fresh, deterministic copy of the state
 		GameStateBlob stateToSimulate;
 
 		// Simulate deterministically: write into our local copy
-		gameLogic->SimulateFrame(stateToSimulate, currentSnapshot.events, currentSnapshot.inputs);
+		gameLogic->SimulateFrame(stateToSimulate, currentSnapshot.events, inputs);
 
 		// Save the result back into the next snapshot
 		Snapshot& predictedSnapshot = GetSnapshot(frame + 1);
 		predictedSnapshot.frame = frame + 1;
 		predictedSnapshot.state = stateToSimulate;
 		predictedSnapshot.stateConfirmed = false;
+		worldFrame = frame + 1;
 	}
 
 	void RemoveYetConfirmedSnapshots()
@@ -1,13 +1,14 @@
 ﻿#ifndef NETCODE_CLIENT_WINDOW_H
 #define NETCODE_CLIENT_WINDOW_H
 #include "netcode_common.hpp"
+#include "tick_scheduler.hpp"
+#include "jitter_buffer.hpp"
 #include "OpenGL/OpenGLWindow.hpp"
 #include "OpenGL/Mesh.hpp"
 #include "Utils/Input.hpp"
 #include "Utils/Debug/Debug.hpp"
 
-const int RENDER_TICKS_PER_SECOND = 144;
-const int RENDER_MS_PER_TICK = 1000 / RENDER_TICKS_PER_SECOND;
+const int DEFAULT_RENDER_TICKS_PER_SECOND = 144;
 
 class ClientWindow {
 
@@ -24,17 +25,18 @@ class ClientWindow {
     static std::thread renderThread;
     static std::vector<ClientWindow*> activeInstances;  // Changed: vector of active instances
     static bool threadRunning;
+    static int renderTicksPerSecond;
+
+    float msPerTick = 1000.0f / DEFAULT_TICKS_PER_SECOND;    // Game tick the local interpolation sweeps over
 
 public:
 
     std::mutex gStateMutex;
-    GameStateBlob PreviousServerState;
-    GameStateBlob CurrentServerState;
+    StateJitterBuffer serverStates;         // Played back behind arrival, see StateJitterBuffer
+    GameStateBlob CurrentServerState;       // Newest server state received
     GameStateBlob RenderState;
     GameStateBlob PreviousLocalState;
     GameStateBlob CurrentLocalState;
-    std::chrono::steady_clock::time_point lastStateUpdate;
-    std::chrono::steady_clock::time_point previousStateUpdate;
     std::chrono::steady_clock::time_point lastLocalUpdate;
     std::chrono::steady_clock::time_point previousLocalUpdate;
     std::function<void(GameStateBlob&, OpenGLWindow*)> renderInitCallback;
@@ -48,12 +50,9 @@ public:
         std::function<void(const GameStateBlob&, const GameStateBlob&, const GameStateBlob&, const GameStateBlob&, GameStateBlob&, float, float)> interpolationCb)
         : renderInitCallback(initCb), renderCallback(renderCb), interpolationCallback(interpolationCb), needsInit(true)
     {
-        lastStateUpdate = std::chrono::steady_clock::now();
-        previousStateUpdate = std::chrono::steady_clock::now();
         lastLocalUpdate = std::chrono::steady_clock::now();
         previousLocalUpdate = std::chrono::steady_clock::now();
 
-        PreviousServerState.frame = -1;
         CurrentServerState.frame = -1;
         PreviousLocalState.frame = -1;
         CurrentLocalState.frame = -1;
@@ -123,15 +122,32 @@ public:
 
     bool isRunning() const { return gRunning; }
 
+    // Rate the game states come in at. Call before activate.
+    void setTickRate(int ticksPerSecond) {
+        msPerTick = 1000.0f / ClampTickRate(ticksPerSecond);
+        std::lock_guard<std::mutex> lock(gStateMutex);
+        serverStates.SetTickRate(ticksPerSecond);
+    }
+
+    // Server ticks between the states passed to setServerState
+    void setSnapshotInterval(int ticks) {
+        std::lock_guard<std::mutex> lock(gStateMutex);
+        serverStates.SetSnapshotInterval(ticks);
+    }
+
+    // Frames rendered per second. Call before startRenderThread.
+    static void setRenderTickRate(int ticksPerSecond) {
+        renderTicksPerSecond = std::max(1, ticksPerSecond);
+    }
+
+    static int getRenderTickRate() { return renderTicksPerSecond; }
+
     void setServerState(GameStateBlob state) {
         std::lock_guard<std::mutex> lock(gStateMutex);
 
 
-        if (state.frame > CurrentServerState.frame) {
-            PreviousServerState = CurrentServerState;
-            previousStateUpdate = lastStateUpdate;
+        if (serverStates.Push(state)) {
             CurrentServerState = state;
-            lastStateUpdate = std::chrono::steady_clock::now();
         }
     }
 
@@ -156,6 +172,12 @@ public:
         return CurrentServerState;
     }
 
+    // How far behind their arrival server states are rendered
+    double getServerPlaybackDelayMs() {
+        std::lock_guard<std::mutex> lock(gStateMutex);
+        return serverStates.GetDelayMs();
+    }
+
     static bool isWindowThreadRunning() {
         std::lock_guard<std::mutex> lock(windowMutex);
         return threadRunning;
@@ -169,7 +191,8 @@ public:
 private:
     // The persistent render loop running on the dedicated thread
     static void renderLoop() {
-        auto nextTick = std::chrono::high_resolution_clock::now();
+        FixedTickScheduler scheduler(renderTicksPerSecond);
+        scheduler.Start();
         auto frameStart = std::chrono::high_resolution_clock::now();
 
         int tickCount = 0;
@@ -203,24 +226,21 @@ private:
                 // Calculate interpolation factors
                 auto now = std::chrono::steady_clock::now();
 
-                // Server: sweeps 0->1 over MS_PER_TICK after each new state arrives.
-                // factor=0: render at prevServer. factor=1: render at currServer.
+                // Server: the buffered states around the playback position.
+                // factor=0: render at fromServer. factor=1: render at toServer,
+                // above 1 when extrapolating past the newest state.
+                const GameStateBlob* fromServer = &instance->CurrentServerState;
+                const GameStateBlob* toServer = &instance->CurrentServerState;
                 float serverInterpolationFactor = 0.0f;
-                if (instance->CurrentServerState.frame != instance->PreviousServerState.frame) {
-                    auto elapsed = now - instance->lastStateUpdate;
-                    float elapsedMs = std::chrono::duration<float, std::milli>(elapsed).count();
-                    serverInterpolationFactor = elapsedMs / static_cast<float>(MS_PER_TICK);
-                    if (serverInterpolationFactor < 0.0f) serverInterpolationFactor = 0.0f;
-                    if (serverInterpolationFactor > 1.0f) serverInterpolationFactor = 1.0f;
-                }
+                instance->serverStates.Sample(now, fromServer, toServer, serverInterpolationFactor);
 
-                // Local: sweeps 0->1 over MS_PER_TICK after each new predicted state.
+                // Local: sweeps 0->1 over one game tick after each new predicted state.
                 // factor=0: render at prevLocal. factor=1: render at currLocal.
                 float localInterpolationFactor = 0.0f;
                 if (instance->CurrentLocalState.frame != instance->PreviousLocalState.frame) {
                     auto elapsed = now - instance->lastLocalUpdate;
                     float elapsedMs = std::chrono::duration<float, std::milli>(elapsed).count();
-                    localInterpolationFactor = elapsedMs / static_cast<float>(MS_PER_TICK);
+                    localInterpolationFactor = elapsedMs / instance->msPerTick;
                     if (localInterpolationFactor < 0.0f) localInterpolationFactor = 0.0f;
                     if (localInterpolationFactor > 1.0f) localInterpolationFactor = 1.0f;
                 }
@@ -228,8 +248,8 @@ private:
                 // Interpolate
                 if (instance->interpolationCallback) {
                     instance->interpolationCallback(
-                        instance->PreviousServerState,
-                        instance->CurrentServerState,
+                        *fromServer,
+                        *toServer,
                         instance->PreviousLocalState,
                         instance->CurrentLocalState,
                         instance->RenderState,
@@ -261,7 +281,7 @@ private:
             }
 
             tickCount++;
-            if (tickCount == RENDER_TICKS_PER_SECOND) {
+            if (tickCount == renderTicksPerSecond) {
                 tickCount = 0;
 
                 auto frameEnd = std::chrono::high_resolution_clock::now();
@@ -294,8 +314,8 @@ private:
 
             Input::Update();
 
-            nextTick += std::chrono::milliseconds(RENDER_MS_PER_TICK);
-            std::this_thread::sleep_until(nextTick);
+            scheduler.Advance();
+            scheduler.SleepUntilNext();
         }
     }
 };
@@ -306,5 +326,6 @@ std::mutex ClientWindow::windowMutex;
 std::thread ClientWindow::renderThread;
 std::vector<ClientWindow*> ClientWindow::activeInstances;
 bool ClientWindow::threadRunning = false;
+int ClientWindow::renderTicksPerSecond = DEFAULT_RENDER_TICKS_PER_SECOND;
 
 #endif //NETCODE_CLIENT_WINDOW_H
\ No newline at end of file
@@ -0,0 +1,276 @@
+#ifndef GNS_TRANSPORT_H
+#define GNS_TRANSPORT_H
+
+#include "transport.hpp"
+#include <GameNetworkingSockets/steam/steamnetworkingtypes.h>
+#include <GameNetworkingSockets/steam/steamnetworkingsockets.h>
+#include <vector>
+#include <mutex>
+#include "Utils/Debug/Debug.hpp"
+
+// ITransport over GameNetworkingSockets. Every connection, accepted or
+// opened by Connect, joins the transport's poll group, so Receive reads them
+// all with one call.
+class GnsTransport : public ITransport {
+public:
+    ~GnsTransport() override {
+        Shutdown();
+    }
+
+    // GNS is process-wide: every transport holds a reference and the library
+    // is shut down when the last one goes, so a server and any number of
+    // clients can share a process
+    bool Init() override {
+        if (holdsGNS) {
+            Debug::Info("Sockets") << "GameNetworkingSockets already initialized\n";
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(s_initMutex);
+            if (s_initCount == 0) {
+                // No GNS service thread: sockets are serviced by whichever thread waits
+                // in Wait, which wakes as soon as a datagram arrives instead of
+                // sleeping between polls. Must be set before GNS is initialized.
+                SteamNetworkingSockets_SetManualPollMode(true);
+
+                SteamNetworkingErrMsg errMsg;
+                if (!GameNetworkingSockets_Init(nullptr, errMsg)) {
+                    Debug::Error("Sockets") << "GameNetworkingSockets initialization failed: " << errMsg << "\n";
+                    return false;
+                }
+            }
+            s_initCount++;
+        }
+
+        holdsGNS = true;
+        sockets = SteamNetworkingSockets();
+        if (!sockets) {
+            Debug::Error("Sockets") << "Failed to get SteamNetworkingSockets interface\n";
+            return false;
+        }
+
+        pollGroup = sockets->CreatePollGroup();
+        if (pollGroup == k_HSteamNetPollGroup_Invalid) {
+            Debug::Error("Sockets") << "Failed to create poll group\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    void Shutdown() override {
+        if (sockets) {
+            if (pollGroup != k_HSteamNetPollGroup_Invalid) {
+                sockets->DestroyPollGroup(pollGroup);
+                pollGroup = k_HSteamNetPollGroup_Invalid;
+            }
+            if (listenSocket != k_HSteamListenSocket_Invalid) {
+                sockets->CloseListenSocket(listenSocket);
+                listenSocket = k_HSteamListenSocket_Invalid;
+            }
+        }
+
+        if (s_pInstance == this) {
+            s_pInstance = nullptr;
+        }
+
+        if (holdsGNS) {
+            holdsGNS = false;
+            sockets = nullptr;
+
+            std::lock_guard<std::mutex> lk(s_initMutex);
+            if (--s_initCount == 0) {
+                GameNetworkingSockets_Kill();
+            }
+        }
+    }
+
+    bool Listen(uint16_t port) override {
+        if (!sockets) {
+            Debug::Error("Sockets") << "GNS not initialized\n";
+            return false;
+        }
+
+        SteamNetworkingIPAddr serverAddr;
+        serverAddr.Clear();
+        serverAddr.m_port = port;
+
+        // Set up callback for connection state changes
+        SteamNetworkingConfigValue_t opt;
+        opt.SetPtr(k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged,
+            (void*)SteamNetConnectionStatusChangedCallback);
+
+        listenSocket = sockets->CreateListenSocketIP(serverAddr, 1, &opt);
+        if (listenSocket == k_HSteamListenSocket_Invalid) {
+            Debug::Error("Sockets") << "Failed to create listen socket on port " << port << "\n";
+            return false;
+        }
+
+        // Store this instance for the static callback
+        s_pInstance = this;
+
+        Debug::Info("Sockets") << "Server listening on port " << port << "\n";
+        return true;
+    }
+
+    ConnectionCode Connect(const std::string& hostStr, uint16_t port, HSteamNetConnection& conn) override {
+        if (!sockets)
+            return CONN_SOCKETS_FAILED;
+
+        SteamNetworkingIPAddr serverAddr;
+        serverAddr.Clear();
+        if (!serverAddr.ParseString(hostStr.c_str()))
+            return CONN_PARSE_ERROR;
+
+        serverAddr.m_port = port;
+
+        SteamNetworkingConfigValue_t opt;
+        opt.SetInt32(k_ESteamNetworkingConfig_TimeoutInitial, 10000);
+
+        conn = sockets->ConnectByIPAddress(serverAddr, 1, &opt);
+        if (conn == k_HSteamNetConnection_Invalid)
+            return CONN_SOCKETS_FAILED;
+
+        sockets->SetConnectionPollGroup(conn, pollGroup);
+        return CONN_SUCCESS;
+    }
+
+    TransportState GetConnectionState(HSteamNetConnection conn) override {
+        SteamNetConnectionInfo_t info;
+        if (!sockets || !sockets->GetConnectionInfo(conn, &info)) {
+            return TRANSPORT_INVALID;
+        }
+
+        switch (info.m_eState) {
+        case k_ESteamNetworkingConnectionState_Connecting:
+        case k_ESteamNetworkingConnectionState_FindingRoute:
+            return TRANSPORT_CONNECTING;
+        case k_ESteamNetworkingConnectionState_Connected:
+            return TRANSPORT_CONNECTED;
+        case k_ESteamNetworkingConnectionState_ClosedByPeer:
+        case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
+        case k_ESteamNetworkingConnectionState_Dead:
+            return TRANSPORT_CLOSED;
+        default:
+            return TRANSPORT_INVALID;
+        }
+    }
+
+    void CloseConnection(HSteamNetConnection conn, bool linger) override {
+        if (sockets) {
+            sockets->CloseConnection(conn, k_ESteamNetConnectionEnd_App_Generic, nullptr, linger);
+        }
+    }
+
+    // One SendMessages call for the whole batch. Each message references its
+    // MessageBuffer, which GNS releases once the message is gone.
+    void Send(const OutgoingDatagram* datagrams, int count) override {
+        if (!sockets || count <= 0) return;
+
+        std::vector<SteamNetworkingMessage_t*> messages;
+        messages.reserve(count);
+
+        for (int i = 0; i < count; i++) {
+            const OutgoingDatagram& datagram = datagrams[i];
+            SteamNetworkingMessage_t* msg = SteamNetworkingUtils()->AllocateMessage(0);
+            if (!msg) continue;
+
+            datagram.buffer->AttachTo(msg, datagram.offset, datagram.len);
+            msg->m_conn = datagram.conn;
+            msg->m_nFlags = datagram.channel == CHANNEL_RELIABLE ?
+                k_nSteamNetworkingSend_Reliable :
+                k_nSteamNetworkingSend_UnreliableNoNagle;
+            messages.push_back(msg);
+        }
+
+        if (!messages.empty()) {
+            sockets->SendMessages(static_cast<int>(messages.size()), messages.data(), nullptr);
+        }
+    }
+
+    int Receive(const DatagramHandler& handler, int maxDatagrams) override {
+        if (!sockets || pollGroup == k_HSteamNetPollGroup_Invalid) return 0;
+
+        ISteamNetworkingMessage* pMsgs[64];
+        int numMsgs = sockets->ReceiveMessagesOnPollGroup(pollGroup, pMsgs, std::min(maxDatagrams, 64));
+
+        for (int i = 0; i < numMsgs; i++) {
+            handler(static_cast<const uint8_t*>(pMsgs[i]->m_pData), pMsgs[i]->m_cbSize, pMsgs[i]->m_conn);
+            pMsgs[i]->Release();
+        }
+        return numMsgs;
+    }
+
+    void RunCallbacks() override {
+        if (sockets) {
+            sockets->RunCallbacks();
+        }
+    }
+
+    void Wait(int maxWaitMs) override {
+        if (sockets) {
+            SteamNetworkingSockets_Poll(maxWaitMs);
+        }
+        else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(maxWaitMs));
+        }
+    }
+
+    ISteamNetworkingSockets* GetSockets() { return sockets; }
+
+private:
+    ISteamNetworkingSockets* sockets = nullptr;
+    HSteamListenSocket listenSocket = k_HSteamListenSocket_Invalid;
+    HSteamNetPollGroup pollGroup = k_HSteamNetPollGroup_Invalid;
+    bool holdsGNS = false;          // This transport counts in s_initCount
+
+    static inline GnsTransport* s_pInstance = nullptr;
+    static inline std::mutex s_initMutex;
+    static inline int s_initCount = 0;
+
+    // Server-side: accept connecting clients
+    void OnConnectionStateChanged(SteamNetConnectionStatusChangedCallback_t* pInfo) {
+        switch (pInfo->m_info.m_eState) {
+        case k_ESteamNetworkingConnectionState_Connecting:
+            Debug::Info("Sockets") << "New connection attempt from " << pInfo->m_info.m_szConnectionDescription << "\n";
+            if (sockets->AcceptConnection(pInfo->m_hConn) == k_EResultOK) {
+                Debug::Info("Sockets") << "Connection accepted, waiting to add to poll group...\n";
+            }
+            else {
+                Debug::Error("Sockets") << "Failed to accept connection\n";
+                sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
+            }
+            break;
+
+        case k_ESteamNetworkingConnectionState_Connected:
+            Debug::Info("Sockets") << "Connection now established, adding to poll group\n";
+            if (!sockets->SetConnectionPollGroup(pInfo->m_hConn, pollGroup)) {
+                Debug::Error("Sockets") << "Failed to set poll group\n";
+                sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
+            }
+            break;
+
+        case k_ESteamNetworkingConnectionState_ClosedByPeer:
+            Debug::Info("Sockets") << "Connection closed by peer: " << pInfo->m_info.m_szEndDebug << "\n";
+            sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
+            break;
+
+        case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
+            Debug::Error("Sockets") << "Connection problem detected locally: " << pInfo->m_info.m_szEndDebug << "\n";
+            sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    static void SteamNetConnectionStatusChangedCallback(SteamNetConnectionStatusChangedCallback_t* pInfo) {
+        if (s_pInstance) {
+            s_pInstance->OnConnectionStateChanged(pInfo);
+        }
+    }
+};
+
+#endif // GNS_TRANSPORT_H
@@ -0,0 +1,47 @@
+#ifndef NETCODE_INPUT_PREDICTOR_H
+#define NETCODE_INPUT_PREDICTOR_H
+
+#include "netcode_common.hpp"
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+// Guesses the input of a remote player for a frame its input has not
+// arrived for yet, so the client predicts with something closer to what the
+// server will simulate than no input at all. Games provide their own when
+// they know more about how their inputs evolve.
+class IInputPredictor {
+public:
+    virtual ~IInputPredictor() = default;
+
+    // known holds the player's latest inputs by frame. During a rollback it
+    // can hold inputs after frame too. False leaves the player without an
+    // input for the frame.
+    virtual bool PredictInput(int playerId, int frame, const std::map<int, InputEntry>& known, InputBlob& predicted) = 0;
+};
+
+// The player keeps doing what it did last, as the server does for an input
+// that arrives too late
+class RepeatLastInputPredictor : public IInputPredictor {
+public:
+    bool PredictInput(int /*playerId*/, int frame, const std::map<int, InputEntry>& known, InputBlob& predicted) override {
+        auto it = known.lower_bound(frame);
+        if (it == known.begin()) {
+            return false;
+        }
+        predicted = std::prev(it)->second.input;
+        return true;
+    }
+};
+
+// How often the guesses for one remote player turned out right
+struct InputPredictionStats {
+    uint64_t predicted = 0;         // Guessed inputs whose real input arrived later
+    uint64_t mispredicted = 0;      // Of those, the ones that were wrong
+
+    double GetMispredictionRate() const {
+        return predicted > 0 ? static_cast<double>(mispredicted) / predicted : 0.0;
+    }
+};
+
+#endif // NETCODE_INPUT_PREDICTOR_H
@@ -0,0 +1,81 @@
+#ifndef NETCODE_INTEREST_GRID_H
+#define NETCODE_INTEREST_GRID_H
+
+#include "netcode_common.hpp"
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Uniform grid over entity positions, rebuilt every tick, to find the
+// entities within a client's area of interest without testing every entity
+// against every client. Cells are one interest radius wide, so a query only
+// looks at the 3x3 cells around the viewer.
+class InterestGrid {
+public:
+    void Build(const std::vector<EntityPosition>& positions, float radius) {
+        cells.clear();
+        placed.clear();
+        cellSize = radius > 0.0f ? radius : 1.0f;
+
+        for (const EntityPosition& position : positions) {
+            cells[CellKey(CellOf(position.x), CellOf(position.y))].push_back(position);
+            placed.insert(position.entityId);
+        }
+    }
+
+    // Entities in the grid within radius of (x, y)
+    void FindVisible(float x, float y, float radius, std::unordered_set<int>& visible) const {
+        visible.clear();
+
+        int cx = CellOf(x);
+        int cy = CellOf(y);
+        int reach = static_cast<int>(std::ceil(radius / cellSize));
+        float radiusSq = radius * radius;
+
+        for (int dy = -reach; dy <= reach; ++dy) {
+            for (int dx = -reach; dx <= reach; ++dx) {
+                auto it = cells.find(CellKey(cx + dx, cy + dy));
+                if (it == cells.end()) {
+                    continue;
+                }
+                for (const EntityPosition& position : it->second) {
+                    float ex = position.x - x;
+                    float ey = position.y - y;
+                    if (ex * ex + ey * ey <= radiusSq) {
+                        visible.insert(position.entityId);
+                    }
+                }
+            }
+        }
+    }
+
+    bool IsPlaced(int entityId) const { return placed.count(entityId) > 0; }
+
+private:
+    float cellSize = 1.0f;
+    std::unordered_map<uint64_t, std::vector<EntityPosition>> cells;
+    std::unordered_set<int> placed;
+
+    int CellOf(float coordinate) const {
+        return static_cast<int>(std::floor(coordinate / cellSize));
+    }
+
+    static uint64_t CellKey(int cx, int cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+};
+
+// What one client is sent: entities with a position in the grid only when
+// they are near it, everything else always
+struct InterestSet {
+    const InterestGrid* grid = nullptr;     // Null: everything
+    std::unordered_set<int> visible;
+
+    bool IsVisible(int entityId) const {
+        return !grid || !grid->IsPlaced(entityId) || visible.count(entityId) > 0;
+    }
+};
+
+#endif // NETCODE_INTEREST_GRID_H
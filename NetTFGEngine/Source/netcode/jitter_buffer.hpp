@@ -0,0 +1,158 @@
+#ifndef NETCODE_JITTER_BUFFER_H
+#define NETCODE_JITTER_BUFFER_H
+
+#include "netcode_common.hpp"
+#include "tick_scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+
+// Server states waiting to be rendered, played back a little behind their
+// arrival so a late packet does not stall remote entities.
+//
+// Each arrival updates the mean time server frames take to get here and the
+// interarrival jitter (as in RFC 3550). States are played back one snapshot
+// interval plus JITTER_DEVIATIONS times the jitter behind the mean arrival:
+// the interval so the next state is normally here already, the jitter margin
+// for the ones that come late. Playback speeds up or slows down a little to
+// follow changes in that delay. When the buffer runs dry anyway, the last two
+// states are extrapolated for up to MAX_EXTRAPOLATION_MS.
+class StateJitterBuffer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t CAPACITY = 32;
+    static constexpr double JITTER_DEVIATIONS = 2.0;
+    static constexpr double MAX_DELAY_MS = 500.0;
+    static constexpr double MAX_EXTRAPOLATION_MS = 100.0;
+    static constexpr double TRANSIT_SMOOTHING = 0.05;       // Weight of each arrival in the mean transit
+    static constexpr double JITTER_SMOOTHING = 1.0 / 16.0;
+    static constexpr double MAX_PLAYBACK_SLEW = 0.1;        // Playback runs at most this much faster or slower
+    static constexpr double SNAP_TICKS = 4.0;               // Further off than this, playback jumps
+
+    void SetTickRate(int ticksPerSecond) {
+        msPerTick = 1000.0 / ClampTickRate(ticksPerSecond);
+    }
+
+    // Server ticks between the states the client is sent
+    void SetSnapshotInterval(int ticks) {
+        snapshotInterval = std::max(ticks, 1);
+    }
+
+    // Adds a state that just arrived. Older or repeated frames are ignored.
+    bool Push(const GameStateBlob& state, Clock::time_point arrival = Clock::now()) {
+        if (!states.empty() && state.frame <= states.back().frame) {
+            return false;
+        }
+
+        double arrivalMs = ToMs(arrival);
+        double transitMs = arrivalMs - state.frame * msPerTick;
+
+        if (!hasTiming) {
+            meanTransitMs = transitMs;
+            hasTiming = true;
+        }
+        else {
+            double expectedMs = (state.frame - lastFrame) * msPerTick;
+            double deviationMs = std::abs((arrivalMs - lastArrivalMs) - expectedMs);
+            jitterMs += (deviationMs - jitterMs) * JITTER_SMOOTHING;
+            meanTransitMs += (transitMs - meanTransitMs) * TRANSIT_SMOOTHING;
+        }
+        lastFrame = state.frame;
+        lastArrivalMs = arrivalMs;
+
+        states.push_back(state);
+        if (states.size() > CAPACITY) {
+            states.pop_front();
+        }
+        return true;
+    }
+
+    // The two states around the playback position at now, and where between
+    // them it is: 0 at from, 1 at to, above 1 while extrapolating past the
+    // newest state. False while the buffer is empty.
+    bool Sample(Clock::time_point now, const GameStateBlob*& from, const GameStateBlob*& to, float& factor) {
+        if (states.empty()) {
+            return false;
+        }
+
+        AdvancePlayback(ToMs(now));
+
+        // States behind the playback position are not needed any more
+        while (states.size() > 2 && states[1].frame <= playbackFrame) {
+            states.pop_front();
+        }
+
+        if (states.size() == 1) {
+            from = to = &states.front();
+            factor = 0.0f;
+            return true;
+        }
+
+        size_t next = 1;
+        while (next + 1 < states.size() && states[next].frame <= playbackFrame) {
+            next++;
+        }
+        from = &states[next - 1];
+        to = &states[next];
+
+        double position = (playbackFrame - from->frame) / static_cast<double>(to->frame - from->frame);
+        factor = static_cast<float>(std::max(position, 0.0));
+        return true;
+    }
+
+    // How far behind the mean arrival states are played back
+    double GetDelayMs() const {
+        return std::min(snapshotInterval * msPerTick + JITTER_DEVIATIONS * jitterMs, MAX_DELAY_MS);
+    }
+
+    double GetJitterMs() const { return jitterMs; }
+
+    void Clear() {
+        states.clear();
+        hasTiming = false;
+        playing = false;
+        jitterMs = 0.0;
+    }
+
+private:
+    std::deque<GameStateBlob> states;     // Oldest first
+    double msPerTick = 1000.0 / DEFAULT_TICKS_PER_SECOND;
+    int snapshotInterval = 1;
+
+    bool hasTiming = false;
+    double meanTransitMs = 0.0;         // Arrival time of a frame minus its frame time
+    double jitterMs = 0.0;
+    int lastFrame = 0;
+    double lastArrivalMs = 0.0;
+
+    bool playing = false;
+    double playbackFrame = 0.0;         // Server frame being shown, fractional
+    double lastSampleMs = 0.0;
+
+    static double ToMs(Clock::time_point time) {
+        return std::chrono::duration<double, std::milli>(time.time_since_epoch()).count();
+    }
+
+    void AdvancePlayback(double nowMs) {
+        double targetFrame = (nowMs - meanTransitMs - GetDelayMs()) / msPerTick;
+
+        if (!playing || std::abs(targetFrame - playbackFrame) > SNAP_TICKS) {
+            playbackFrame = targetFrame;
+            playing = true;
+        }
+        else {
+            double elapsedTicks = std::max(nowMs - lastSampleMs, 0.0) / msPerTick;
+            double maxCorrection = elapsedTicks * MAX_PLAYBACK_SLEW;
+            playbackFrame += elapsedTicks;
+            playbackFrame += std::clamp(targetFrame - playbackFrame, -maxCorrection, maxCorrection);
+        }
+        lastSampleMs = nowMs;
+
+        double newestFrame = states.back().frame + MAX_EXTRAPOLATION_MS / msPerTick;
+        playbackFrame = std::clamp(playbackFrame, static_cast<double>(states.front().frame), newestFrame);
+    }
+};
+
+#endif // NETCODE_JITTER_BUFFER_H
@@ -0,0 +1,409 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include "transport.hpp"
+#include "mpsc_queue.hpp"
+#include <condition_variable>
+#include <shared_mutex>
+#include <unordered_map>
+#include <queue>
+#include <deque>
+#include <random>
+#include <memory>
+#include "Utils/Debug/Debug.hpp"
+
+// Conditions of the link a LoopbackTransport sends over
+struct LoopbackLinkConfig {
+    int latencyMs = 0;          // One-way delay
+    int jitterMs = 0;           // Each datagram's delay varies by up to this much either way
+    float lossPercent = 0.0f;   // Unreliable datagrams are dropped; reliable ones arrive a round trip late, as if resent
+    uint32_t seed = 1;          // Same seed, same losses and delays
+};
+
+class LoopbackTransport;
+
+// The in-process "network" LoopbackTransports connect over. Any host name
+// reaches the transport listening on the port.
+class LoopbackNetwork {
+public:
+    static LoopbackNetwork& Instance() {
+        static LoopbackNetwork network;
+        return network;
+    }
+
+    bool Bind(uint16_t port, LoopbackTransport* listener) {
+        std::lock_guard<std::mutex> lk(mtx);
+        return listeners.emplace(port, listener).second;
+    }
+
+    void Unbind(uint16_t port, LoopbackTransport* listener) {
+        std::lock_guard<std::mutex> lk(mtx);
+        auto it = listeners.find(port);
+        if (it != listeners.end() && it->second == listener) {
+            listeners.erase(it);
+        }
+    }
+
+    // Connects client to the listener on port; both ends are connected at once
+    inline bool Connect(LoopbackTransport& client, uint16_t port, HSteamNetConnection& conn);
+
+private:
+    std::mutex mtx;
+    std::unordered_map<uint16_t, LoopbackTransport*> listeners;
+    HSteamNetConnection nextHandle = 1;
+};
+
+// ITransport that never leaves the process: datagrams go straight into the
+// receiving transport's lock-free inbox, after an optional simulated delay
+// and loss. Full client/server sessions run on it without sockets, so netcode
+// benchmarks and latency tests are fast and reproducible.
+//
+// Reliable datagrams keep their order and are never lost: when the receiver's
+// inbox is full they wait in the sender and are pushed again on its next Send
+// or Receive. Unreliable ones may be dropped, and reordered by jitter.
+// Datagrams already sent are delivered even if the sender closes the
+// connection, as long as the sending transport is not shut down.
+class LoopbackTransport : public ITransport {
+public:
+    explicit LoopbackTransport(const LoopbackLinkConfig& config = LoopbackLinkConfig(),
+        LoopbackNetwork& network = LoopbackNetwork::Instance())
+        : config(config)
+        , network(network)
+        , rng(config.seed)
+        , inbox(std::make_shared<Inbox>())
+    {
+    }
+
+    ~LoopbackTransport() override {
+        Shutdown();
+    }
+
+    bool Init() override {
+        return true;
+    }
+
+    void Shutdown() override {
+        if (listenPort >= 0) {
+            network.Unbind(static_cast<uint16_t>(listenPort), this);
+            listenPort = -1;
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> lk(connMtx);
+            for (auto& [conn, peer] : connections) {
+                peer.closed->store(true);
+            }
+            connections.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> linkLock(linkMtx);
+            for (auto& [receiver, waiting] : overflow) {
+                for (Datagram& datagram : waiting) {
+                    datagram.buffer->Release();
+                }
+            }
+            overflow.clear();
+        }
+
+        Datagram datagram;
+        while (inbox->queue.TryPop(datagram)) {
+            datagram.buffer->Release();
+        }
+        while (!delayed.empty()) {
+            delayed.top().datagram.buffer->Release();
+            delayed.pop();
+        }
+    }
+
+    bool Listen(uint16_t port) override {
+        if (!network.Bind(port, this)) {
+            Debug::Error("Loopback") << "Port " << port << " is already in use\n";
+            return false;
+        }
+        listenPort = port;
+        return true;
+    }
+
+    ConnectionCode Connect(const std::string&, uint16_t port, HSteamNetConnection& conn) override {
+        return network.Connect(*this, port, conn) ? CONN_SUCCESS : CONN_TIMEOUT;
+    }
+
+    TransportState GetConnectionState(HSteamNetConnection conn) override {
+        std::shared_lock<std::shared_mutex> lk(connMtx);
+        auto it = connections.find(conn);
+        if (it == connections.end()) {
+            return TRANSPORT_INVALID;
+        }
+        return it->second.closed->load() ? TRANSPORT_CLOSED : TRANSPORT_CONNECTED;
+    }
+
+    void CloseConnection(HSteamNetConnection conn, bool) override {
+        std::unique_lock<std::shared_mutex> lk(connMtx);
+        auto it = connections.find(conn);
+        if (it != connections.end()) {
+            it->second.closed->store(true);
+            connections.erase(it);
+        }
+    }
+
+    void Send(const OutgoingDatagram* datagrams, int count) override {
+        int64_t now = NowUs();
+
+        std::shared_lock<std::shared_mutex> lk(connMtx);
+        std::lock_guard<std::mutex> linkLock(linkMtx);
+        RetryOverflow();
+
+        for (int i = 0; i < count; i++) {
+            const OutgoingDatagram& out = datagrams[i];
+            auto it = connections.find(out.conn);
+            if (it == connections.end() || it->second.closed->load()) {
+                continue;
+            }
+            Peer& peer = it->second;
+
+            int64_t deliverAt = now + DelayUs();
+            if (Lost()) {
+                if (out.channel != CHANNEL_RELIABLE) {
+                    continue;
+                }
+                deliverAt += 2 * static_cast<int64_t>(config.latencyMs) * 1000;
+            }
+
+            // Reliable datagrams never overtake each other
+            if (out.channel == CHANNEL_RELIABLE) {
+                deliverAt = std::max(deliverAt, peer.lastReliableUs);
+                peer.lastReliableUs = deliverAt;
+            }
+
+            Datagram datagram;
+            datagram.buffer = out.buffer;
+            datagram.offset = static_cast<uint32_t>(out.offset);
+            datagram.len = static_cast<uint32_t>(out.len);
+            datagram.conn = peer.remoteConn;
+            datagram.deliverAtUs = deliverAt;
+
+            out.buffer->AddRef();
+
+            // Reliable datagrams queue behind the ones already waiting
+            bool reliable = out.channel == CHANNEL_RELIABLE;
+            auto waiting = overflow.find(peer.inbox);
+            if (reliable && waiting != overflow.end()) {
+                waiting->second.push_back(datagram);
+            }
+            else if (!peer.inbox->Push(datagram)) {
+                // Receiver is not keeping up; an unreliable datagram is lost
+                // like in a full socket buffer
+                if (reliable) {
+                    overflow[peer.inbox].push_back(datagram);
+                }
+                else {
+                    out.buffer->Release();
+                }
+            }
+        }
+    }
+
+    int Receive(const DatagramHandler& handler, int maxDatagrams) override {
+        {
+            std::lock_guard<std::mutex> linkLock(linkMtx);
+            RetryOverflow();
+        }
+
+        Datagram datagram;
+        while (inbox->queue.TryPop(datagram)) {
+            delayed.push(Pending{ datagram, nextSequence++ });
+            popped++;
+        }
+
+        int64_t now = NowUs();
+        int received = 0;
+
+        while (received < maxDatagrams && !delayed.empty() && delayed.top().datagram.deliverAtUs <= now) {
+            Datagram due = delayed.top().datagram;
+            delayed.pop();
+
+            // Dropped if closed on this side since it was sent. The handler
+            // runs unlocked, as it may send or close connections.
+            if (GetConnectionState(due.conn) != TRANSPORT_INVALID) {
+                handler(due.buffer->Data() + due.offset, static_cast<int>(due.len), due.conn);
+                received++;
+            }
+            due.buffer->Release();
+        }
+        return received;
+    }
+
+    void RunCallbacks() override {
+    }
+
+    // Sleeps until a datagram is pushed, the next delayed one is due, or maxWaitMs passes
+    void Wait(int maxWaitMs) override {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(maxWaitMs);
+        if (!delayed.empty()) {
+            auto due = std::chrono::steady_clock::time_point(std::chrono::microseconds(delayed.top().datagram.deliverAtUs));
+            deadline = std::min(deadline, due);
+        }
+
+        inbox->waiters.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lk(inbox->waitMutex);
+            inbox->arrived.wait_until(lk, deadline, [&]() { return inbox->pushed.load() > popped; });
+        }
+        inbox->waiters.fetch_sub(1);
+    }
+
+private:
+    friend class LoopbackNetwork;
+
+    struct Datagram {
+        MessageBuffer* buffer = nullptr;
+        uint32_t offset = 0;
+        uint32_t len = 0;
+        HSteamNetConnection conn = k_HSteamNetConnection_Invalid;   // Receiver's handle
+        int64_t deliverAtUs = 0;
+    };
+
+    // Receiving end of a transport, shared with the peers that send to it so
+    // it outlives whichever side goes first
+    struct Inbox {
+        static constexpr size_t CAPACITY = 4096;
+
+        MpscQueue<Datagram, CAPACITY> queue;
+        std::atomic<uint64_t> pushed{ 0 };
+        std::atomic<int> waiters{ 0 };
+        std::mutex waitMutex;
+        std::condition_variable arrived;
+
+        ~Inbox() {
+            Datagram datagram;
+            while (queue.TryPop(datagram)) {
+                datagram.buffer->Release();
+            }
+        }
+
+        // Lock-free unless the receiver is asleep in Wait
+        bool Push(const Datagram& datagram) {
+            if (!queue.TryPush(datagram)) {
+                return false;
+            }
+            pushed.fetch_add(1);
+            if (waiters.load() > 0) {
+                std::lock_guard<std::mutex> lk(waitMutex);
+                arrived.notify_one();
+            }
+            return true;
+        }
+    };
+
+    struct Peer {
+        std::shared_ptr<Inbox> inbox;
+        HSteamNetConnection remoteConn = k_HSteamNetConnection_Invalid;
+        std::shared_ptr<std::atomic<bool>> closed;  // Shared by both ends
+        int64_t lastReliableUs = 0;
+    };
+
+    // Ordered by delivery time, then by arrival so equal times keep their order
+    struct Pending {
+        Datagram datagram;
+        uint64_t sequence = 0;
+
+        bool operator>(const Pending& other) const {
+            if (datagram.deliverAtUs != other.datagram.deliverAtUs) {
+                return datagram.deliverAtUs > other.datagram.deliverAtUs;
+            }
+            return sequence > other.sequence;
+        }
+    };
+
+    LoopbackLinkConfig config;
+    LoopbackNetwork& network;
+    int listenPort = -1;
+
+    std::shared_mutex connMtx;
+    std::unordered_map<HSteamNetConnection, Peer> connections;
+
+    std::mutex linkMtx;             // Guards rng, overflow and the peers' lastReliableUs
+    std::mt19937 rng;
+
+    // Reliable datagrams that found the receiver's inbox full, oldest first.
+    // Keyed by inbox rather than connection so closing does not lose them.
+    std::unordered_map<std::shared_ptr<Inbox>, std::deque<Datagram>> overflow;
+
+    std::shared_ptr<Inbox> inbox;
+
+    // Only touched by the receiving thread
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<Pending>> delayed;
+    uint64_t nextSequence = 0;
+    uint64_t popped = 0;
+
+    static int64_t NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Assumes linkMtx is held
+    int64_t DelayUs() {
+        int64_t delay = static_cast<int64_t>(config.latencyMs) * 1000;
+        if (config.jitterMs > 0) {
+            std::uniform_int_distribution<int64_t> jitter(-config.jitterMs * 1000LL, config.jitterMs * 1000LL);
+            delay += jitter(rng);
+        }
+        return std::max<int64_t>(delay, 0);
+    }
+
+    // Pushes what fits of the waiting reliable datagrams. Assumes linkMtx is held.
+    void RetryOverflow() {
+        for (auto it = overflow.begin(); it != overflow.end(); ) {
+            std::deque<Datagram>& waiting = it->second;
+            while (!waiting.empty() && it->first->Push(waiting.front())) {
+                waiting.pop_front();
+            }
+            it = waiting.empty() ? overflow.erase(it) : std::next(it);
+        }
+    }
+
+    // Assumes linkMtx is held
+    bool Lost() {
+        if (config.lossPercent <= 0.0f) {
+            return false;
+        }
+        std::uniform_real_distribution<float> roll(0.0f, 100.0f);
+        return roll(rng) < config.lossPercent;
+    }
+
+    void AddPeer(HSteamNetConnection conn, const Peer& peer) {
+        std::unique_lock<std::shared_mutex> lk(connMtx);
+        connections[conn] = peer;
+    }
+};
+
+inline bool LoopbackNetwork::Connect(LoopbackTransport& client, uint16_t port, HSteamNetConnection& conn) {
+    std::lock_guard<std::mutex> lk(mtx);
+    auto it = listeners.find(port);
+    if (it == listeners.end()) {
+        return false;
+    }
+    LoopbackTransport& server = *it->second;
+
+    auto closed = std::make_shared<std::atomic<bool>>(false);
+    HSteamNetConnection clientConn = nextHandle++;
+    HSteamNetConnection serverConn = nextHandle++;
+
+    LoopbackTransport::Peer toServer;
+    toServer.inbox = server.inbox;
+    toServer.remoteConn = serverConn;
+    toServer.closed = closed;
+    client.AddPeer(clientConn, toServer);
+
+    LoopbackTransport::Peer toClient;
+    toClient.inbox = client.inbox;
+    toClient.remoteConn = clientConn;
+    toClient.closed = closed;
+    server.AddPeer(serverConn, toClient);
+
+    conn = clientConn;
+    return true;
+}
+
+#endif // LOOPBACK_TRANSPORT_H
@@ -0,0 +1,134 @@
+#ifndef MESSAGE_BUFFER_POOL_H
+#define MESSAGE_BUFFER_POOL_H
+
+#include <GameNetworkingSockets/steam/steamnetworkingtypes.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class MessageBufferPool;
+
+// Reference counted byte buffer holding an outgoing datagram, or the bytes
+// of a game state too large for its inline storage. A transport
+// that keeps it past Send takes a reference; with GNS that is the message
+// payload, released through FreeMessageData once GNS is done with it. The
+// last reference returns the buffer to its pool.
+// The same buffer can back messages to several connections at once.
+class MessageBuffer {
+public:
+    uint8_t* Data() { return bytes.get(); }
+    const uint8_t* Data() const { return bytes.get(); }
+    size_t Capacity() const { return capacity; }
+
+    // Someone else holds a reference too, so writing would be seen by them
+    bool IsShared() const { return refs.load(std::memory_order_acquire) > 1; }
+
+    void AddRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+    inline void Release();
+
+    // Points msg at len bytes of this buffer starting at offset and takes a
+    // reference that GNS gives back through m_pfnFreeData
+    void AttachTo(SteamNetworkingMessage_t* msg, size_t offset, size_t len) {
+        AddRef();
+        msg->m_pData = bytes.get() + offset;
+        msg->m_cbSize = static_cast<int>(len);
+        msg->m_nUserData = static_cast<int64>(reinterpret_cast<intptr_t>(this));
+        msg->m_pfnFreeData = &MessageBuffer::FreeMessageData;
+    }
+
+private:
+    friend class MessageBufferPool;
+
+    MessageBuffer(size_t cap, int cls)
+        : bytes(new uint8_t[cap]), capacity(cap), sizeClass(cls) {
+    }
+
+    static void FreeMessageData(SteamNetworkingMessage_t* msg) {
+        reinterpret_cast<MessageBuffer*>(static_cast<intptr_t>(msg->m_nUserData))->Release();
+    }
+
+    std::unique_ptr<uint8_t[]> bytes;
+    size_t capacity;
+    int sizeClass;              // -1 for buffers too large to be pooled
+    std::atomic<int> refs{ 0 };
+};
+
+// Free lists of MessageBuffers in power of two size classes. Process wide, as
+// a transport may still hold datagrams after the session that sent them is gone.
+class MessageBufferPool {
+public:
+    static constexpr size_t MIN_CLASS_BYTES = 256;
+    static constexpr int CLASS_COUNT = 9;                 // 256 B .. 64 KB
+    static constexpr size_t MAX_FREE_PER_CLASS = 256;
+
+    static MessageBufferPool& Instance() {
+        static MessageBufferPool pool;
+        return pool;
+    }
+
+    // Returns a buffer of at least len bytes holding one reference
+    MessageBuffer* Acquire(size_t len) {
+        int cls = ClassFor(len);
+        MessageBuffer* buffer = nullptr;
+
+        if (cls >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!freeLists[cls].empty()) {
+                buffer = freeLists[cls].back();
+                freeLists[cls].pop_back();
+            }
+        }
+
+        if (!buffer) {
+            size_t cap = cls >= 0 ? MIN_CLASS_BYTES << cls : len;
+            buffer = new MessageBuffer(cap, cls);
+        }
+
+        buffer->refs.store(1, std::memory_order_relaxed);
+        return buffer;
+    }
+
+    void Recycle(MessageBuffer* buffer) {
+        if (buffer->sizeClass >= 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            std::vector<MessageBuffer*>& list = freeLists[buffer->sizeClass];
+            if (list.size() < MAX_FREE_PER_CLASS) {
+                list.push_back(buffer);
+                return;
+            }
+        }
+        delete buffer;
+    }
+
+    ~MessageBufferPool() {
+        for (std::vector<MessageBuffer*>& list : freeLists) {
+            for (MessageBuffer* buffer : list) {
+                delete buffer;
+            }
+        }
+    }
+
+private:
+    MessageBufferPool() = default;
+
+    static int ClassFor(size_t len) {
+        size_t cap = MIN_CLASS_BYTES;
+        for (int cls = 0; cls < CLASS_COUNT; cls++, cap <<= 1) {
+            if (len <= cap) return cls;
+        }
+        return -1;
+    }
+
+    std::mutex mtx;
+    std::vector<MessageBuffer*> freeLists[CLASS_COUNT];
+};
+
+inline void MessageBuffer::Release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        MessageBufferPool::Instance().Recycle(this);
+    }
+}
+
+#endif // MESSAGE_BUFFER_POOL_H
@@ -0,0 +1,92 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue with any number of producers and one consumer.
+//
+// Each slot carries a sequence number that says whose turn it is: producers
+// claim a slot by advancing the shared tail with a CAS and publish it by
+// bumping the slot's sequence, so a producer never waits on the consumer or on
+// another producer's copy. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+        "MpscQueue capacity must be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Safe from any thread. False when the queue is full.
+    bool TryPush(const T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & (Capacity - 1)];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only. False when nothing has been published yet.
+    bool TryPop(T& out) {
+        Slot& slot = slots[head & (Capacity - 1)];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(head + 1) < 0) {
+            return false;
+        }
+
+        out = slot.value;
+        slot.sequence.store(head + Capacity, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    // Pops everything published so far and hands it to fn, in push order
+    template<typename Fn>
+    size_t Drain(Fn&& fn) {
+        size_t count = 0;
+        T value;
+        while (TryPop(value)) {
+            fn(value);
+            count++;
+        }
+        return count;
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // Producers and the consumer touch opposite ends; keep them on separate
+    // cache lines so one does not invalidate the other
+    alignas(64) std::atomic<size_t> tail{ 0 };
+    alignas(64) size_t head = 0;
+    alignas(64) Slot slots[Capacity];
+};
+
+#endif // MPSC_QUEUE_H
@@ -17,7 +17,8 @@
 #include <atomic>
 #include <cstdint>
 #include <algorithm>
-#include <openssl/sha.h>
+#include "state_hash.hpp"
+#include "message_buffer_pool.hpp"
 
 #if defined(_WIN32) || defined(_WIN64)
 #pragma comment(lib, "ws2_32.lib")
@@ -29,9 +30,20 @@
 
 using namespace std::chrono_literals;
 
-const int TICKS_PER_SECOND = 30;
-const int MS_PER_TICK = 1000 / TICKS_PER_SECOND;
+// Tick rate of a server whose config does not set one. Clients follow the
+// rate the server announces.
+const int DEFAULT_TICKS_PER_SECOND = 30;
+// Furthest a client predicts past the last confirmed state; it stalls there
 const int MAX_ROLLBACK_FRAMES = 90;
+// Typical rollback depth adaptive input delay aims for, and the most delay
+// it adds to reach it
+const int TARGET_ROLLBACK_FRAMES = 4;
+const int MAX_INPUT_DELAY_FRAMES = 8;
+
+// Frames without a state ack before the server falls back to a reliable full state
+const int STATE_ACK_TIMEOUT_FRAMES = 15;
+// Maximum unacked inputs a client repeats in every input packet
+const int INPUT_WINDOW_SIZE = 32;
 
 // Tamaos ajustables segn tus necesidades
 constexpr size_t GAME_EVENT_BLOB_SIZE = 128;
@@ -93,21 +105,43 @@ enum PacketType : uint8_t {
     PACKET_INPUT_ACK = 0x05,
     PACKET_INPUT_DELAY = 0x06,
 	PACKET_DELTA_STATE_UPDATE = 0x07,
-	PACKET_EVENT_UPDATE = 0x08
+	PACKET_EVENT_UPDATE = 0x08,
+	PACKET_STATE_ACK = 0x09,
+	PACKET_BATCH = 0x0D,       // 0x0A..0x0C are the handshake packets below
+	PACKET_HASH_TREE_REQUEST = 0x0E,
+	PACKET_HASH_TREE = 0x0F,
+	PACKET_STATE_REPAIR = 0x10,
+	PACKET_FRAGMENT = 0x11
+};
+
+// Delivery guarantee for a packet. State deltas, inputs and acks travel
+// unreliable and unsequenced so a lost datagram never blocks newer ones;
+// events, full states and control messages stay reliable.
+enum SendChannel : uint8_t {
+	CHANNEL_RELIABLE = 0,
+	CHANNEL_UNRELIABLE = 1
 };
 
 struct HashPacket {
-	int frame;
-	uint8_t hash[SHA256_DIGEST_LENGTH];
+	int frame = 0;
+	StateHash hash = 0;
 };
 
 struct DeltaStateBlob {
     int frame = 0;
     int delta_type = 0;
+    int entityId = -1;      // Entity the values belong to, -1 for state not tied to one
     uint8_t data[1024];
     int len = 0;
 };
 
+// Where an entity is, for interest management
+struct EntityPosition {
+    int entityId = -1;
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
 struct InputBlob {
     uint8_t data[4];
 };
@@ -148,20 +182,142 @@ inline bool operator!=(const InputEntry& a, const InputEntry& b) {
 static_assert(std::is_trivially_copyable<InputBlob>::value,
     "InputBlob must be trivially copyable");
 
+constexpr int GAME_STATE_INLINE_BYTES = 4096;
+constexpr int MAX_GAME_STATE_BYTES = 1 << 20;
+
+// Game state of up to MAX_GAME_STATE_BYTES. States of up to
+// GAME_STATE_INLINE_BYTES live in data, so small games keep casting data to
+// their state struct and copying a state never allocates. Larger states are
+// sized with Resize and reached through Data and MutableData; their bytes
+// are a pooled MessageBuffer shared between copies and copied on write.
 struct GameStateBlob {
     int frame = 0;
-    uint8_t data[4096];
+    uint8_t data[GAME_STATE_INLINE_BYTES];
     int len = 0;
-};
 
-static_assert(std::is_trivially_copyable<GameStateBlob>::value,
-    "Blob must be trivially copyable");
+    GameStateBlob() = default;
+
+    GameStateBlob(const GameStateBlob& other)
+        : frame(other.frame), len(other.len), large(other.large) {
+        if (large) {
+            large->AddRef();
+        }
+        else {
+            std::memcpy(data, other.data, sizeof(data));
+        }
+    }
+
+    GameStateBlob(GameStateBlob&& other) noexcept
+        : frame(other.frame), len(other.len), large(other.large) {
+        if (large) {
+            other.large = nullptr;
+            other.len = 0;
+        }
+        else {
+            std::memcpy(data, other.data, sizeof(data));
+        }
+    }
+
+    GameStateBlob& operator=(const GameStateBlob& other) {
+        if (this == &other) return *this;
+        if (other.large) {
+            other.large->AddRef();
+        }
+        else {
+            std::memcpy(data, other.data, sizeof(data));
+        }
+        ReleaseLarge();
+        frame = other.frame;
+        len = other.len;
+        large = other.large;
+        return *this;
+    }
+
+    GameStateBlob& operator=(GameStateBlob&& other) noexcept {
+        if (this == &other) return *this;
+        if (!other.large) {
+            return *this = static_cast<const GameStateBlob&>(other);
+        }
+        ReleaseLarge();
+        frame = other.frame;
+        len = other.len;
+        large = other.large;
+        other.large = nullptr;
+        other.len = 0;
+        return *this;
+    }
+
+    ~GameStateBlob() { ReleaseLarge(); }
+
+    const uint8_t* Data() const { return large ? large->Data() : data; }
+
+    uint8_t* MutableData() {
+        if (large && large->IsShared()) {
+            MoveToLarge(large->Capacity());
+        }
+        return large ? large->Data() : data;
+    }
+
+    // Takes the length and bytes of other, keeping this state's frame
+    void CopyBytesFrom(const GameStateBlob& other) {
+        int keepFrame = frame;
+        *this = other;
+        frame = keepFrame;
+    }
+
+    // Bytes Data can hold without a Resize
+    int Capacity() const {
+        return large ? static_cast<int>(large->Capacity()) : GAME_STATE_INLINE_BYTES;
+    }
+
+    // Sets len, keeping the bytes below it. States past the inline storage
+    // move to a pooled buffer and come back once they fit again.
+    bool Resize(int newLen) {
+        if (newLen < 0 || newLen > MAX_GAME_STATE_BYTES) {
+            return false;
+        }
+
+        if (newLen <= GAME_STATE_INLINE_BYTES) {
+            if (large) {
+                std::memcpy(data, large->Data(), static_cast<size_t>(std::min(len, newLen)));
+                ReleaseLarge();
+            }
+        }
+        else if (!large || large->IsShared() || large->Capacity() < static_cast<size_t>(newLen)) {
+            MoveToLarge(static_cast<size_t>(newLen));
+        }
+
+        len = newLen;
+        return true;
+    }
+
+private:
+    MessageBuffer* large = nullptr;
+
+    void ReleaseLarge() {
+        if (large) {
+            large->Release();
+            large = nullptr;
+        }
+    }
+
+    // A buffer of its own of at least capacity bytes, holding the current bytes
+    void MoveToLarge(size_t capacity) {
+        MessageBuffer* buffer = MessageBufferPool::Instance().Acquire(capacity);
+        size_t keep = std::min(static_cast<size_t>(std::max(len, 0)), capacity);
+        std::memcpy(buffer->Data(), Data(), std::min(keep, static_cast<size_t>(Capacity())));
+        ReleaseLarge();
+        large = buffer;
+    }
+};
 
 class IGameLogic {
 public:
 	bool isServer = false;
     int frame = 0;
     int playerId = -1;
+    int ticksPerSecond = DEFAULT_TICKS_PER_SECOND;    // Rate SimulateFrame is called at
+    uint32_t randomSeed = 0;    // Seed for the simulation's random numbers, set by the server before Init and kept in replays
 	bool gameFinished = false;
 	std::vector<EventEntry> generatedEvents;
     std::vector<DeltaStateBlob> generatedDeltas;
@@ -178,7 +334,49 @@ public:
     virtual void GenerateDeltas(const GameStateBlob& previousState, const GameStateBlob& newState) = 0;
     virtual void ApplyDeltasToGameState(GameStateBlob& state, const std::vector<DeltaStateBlob>& deltas) = 0;
     virtual void Init(GameStateBlob& state) = 0;
-	virtual void HashState(const GameStateBlob& state, uint8_t (& outHash)[SHA256_DIGEST_LENGTH]) const = 0;
+    // Parts of the state that are hashed on their own. Defaults to the whole
+    // blob; games narrow it down to what must match between peers.
+    virtual void GetHashSections(const GameStateBlob& state, std::vector<StateSection>& sections) const {
+        sections.push_back(StateSection{ 0, static_cast<uint32_t>(state.len) });
+    }
+    // Desync checksum: the root of the hash tree over every section
+    virtual StateHash HashState(const GameStateBlob& state) const {
+        std::vector<StateHash> sectionHashes;
+        HashSections(state, sectionHashes);
+        return StateHashTree(sectionHashes).Root();
+    }
+    void HashSections(const GameStateBlob& state, std::vector<StateHash>& hashes) const {
+        std::vector<StateSection> sections;
+        GetHashSections(state, sections);
+        hashes.clear();
+        hashes.reserve(sections.size());
+        for (const StateSection& section : sections) {
+            // Sections past the end of this state hash as empty
+            uint32_t len = static_cast<uint32_t>(std::max(state.len, 0));
+            hashes.push_back(section.offset <= len && section.len <= len - section.offset ?
+                HashBytes(state.Data() + section.offset, section.len) : 0);
+        }
+    }
+    // How much the client of playerId needs the entity a delta belongs to,
+    // when updates are capped by a byte budget: the higher, the more often
+    // it is sent. Games raise it for entities close to the player or that
+    // matter more to it.
+    virtual float GetDeltaPriority(const GameStateBlob& /*state*/, const DeltaStateBlob& /*delta*/, int /*playerId*/) const {
+        return 1.0f;
+    }
+    // Positions of the entities deltas are tied to, for interest management
+    // on the server. Entities left out are sent to every client.
+    virtual void GetEntityPositions(const GameStateBlob& /*state*/, std::vector<EntityPosition>& /*positions*/) const {}
+    // Centre of the area the client of playerId is interested in. False when
+    // it has none, as a spectator, and is sent everything.
+    virtual bool GetViewerPosition(const GameStateBlob& /*state*/, int /*playerId*/, float& /*x*/, float& /*y*/) const {
+        return false;
+    }
+    // Where an event happens, when only clients near it need it. False for
+    // events every client must get.
+    virtual bool GetEventPosition(const EventEntry& /*event*/, float& /*x*/, float& /*y*/) const {
+        return false;
+    }
     virtual void PrintState(const GameStateBlob& state) const = 0;
 };
 
@@ -191,6 +389,7 @@ struct Snapshot {
     int frame = -1;
     GameStateBlob state;
     std::map<int, InputEntry> inputs;
+    std::map<int, InputBlob> predictedInputs;   // Guesses for remote players whose input had not arrived
 	std::vector<EventEntry> events;
     bool stateConfirmed = false;
 };
@@ -203,10 +402,13 @@ using EventsHistory = std::map<int, std::vector<EventEntry>>;
 struct PeerInfo {
     HSteamNetConnection connection;  // GameNetworkingSockets handle
     int playerId;
-    int lastAckedFrame = -1;
+    int lastAckedFrame = -1;         // Latest server frame the client confirmed
     std::string clientId;
     bool isConnected;
 	bool pendingReceiveFullState = true;
+    int repairRequestFrame = -1;     // Server frame a hash tree was requested at, -1 if none pending
+    int snapshotInterval = 1;        // Ticks between the state updates sent to this client
+    int lastSnapshotFrame = -1;      // Frame of the latest deltas or full state sent, -1 before the first
     std::chrono::steady_clock::time_point disconnectTime;
 };
 
@@ -223,14 +425,17 @@ constexpr uint8_t PACKET_SERVER_ACCEPT = 11;
 constexpr uint8_t PACKET_SERVER_REJECT = 12;
 
 struct ClientHelloPacket {
-    uint8_t type;
-    char clientId[64];
+    char clientId[64] = {};
+    char matchId[32] = {};     // Match to join on a multi-match host, empty for a single-match server
+    int snapshotsPerSecond = 0;  // State updates the client wants per second, 0 for the server's default
 };
 
 struct ServerAcceptPacket {
-    uint8_t type;
-    int playerId;
-    bool isReconnection;
+    int playerId = -1;
+    bool isReconnection = false;
+    int hashCheckInterval = 0;   // Frames between desync hashes, 0 disables them
+    int ticksPerSecond = DEFAULT_TICKS_PER_SECOND;
+    int snapshotInterval = 1;    // Ticks between the state updates the client gets
 };
 
 // Helper to convert between host and network byte order (unchanged, still needed)
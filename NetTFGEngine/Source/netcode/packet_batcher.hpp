@@ -0,0 +1,356 @@
+#ifndef PACKET_BATCHER_H
+#define PACKET_BATCHER_H
+
+#include "netcode_common.hpp"
+#include "message_buffer_pool.hpp"
+#include "transport.hpp"
+#include "Utils/Debug/Debug.hpp"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Collects every message queued for a connection during a tick and packs them
+// into as few datagrams as possible. A batch datagram is
+//   PACKET_BATCH(1) + N * ( len(2) + message )
+// Reliable and unreliable messages are batched separately, since the
+// transport applies the delivery guarantee per datagram. A batch holding a single message is
+// sent without the wrapper.
+//
+// Messages too large for one datagram, such as the full state of a big game,
+// are split into fragment datagrams of at most MAX_BATCH_BYTES each
+//   PACKET_FRAGMENT(1) + messageId(2) + index(2) + count(2) + chunk
+// which FragmentAssembler puts back together on the other side, so no
+// transport has to carry a datagram larger than a batch.
+//
+// Datagrams live in pooled MessageBuffers that are handed to the transport as
+// they are, so a packet is written once, straight into the memory that goes on
+// the wire.
+class PacketBatcher {
+public:
+    // Keeps a batch under a typical path MTU so it is never fragmented
+    static constexpr size_t MAX_BATCH_BYTES = 1200;
+    static constexpr size_t SUB_HEADER_BYTES = 2;
+    static constexpr size_t FRAGMENT_HEADER_BYTES = 7;
+    static constexpr size_t FRAGMENT_CHUNK_BYTES = MAX_BATCH_BYTES - FRAGMENT_HEADER_BYTES;
+    // Largest message that is fragmented: a whole state plus its packet header
+    static constexpr size_t MAX_MESSAGE_BYTES = MAX_GAME_STATE_BYTES + 1024;
+
+    ~PacketBatcher() {
+        for (auto& [conn, batches] : pending) {
+            for (std::vector<Datagram>& datagrams : batches.channels) {
+                for (Datagram& datagram : datagrams) {
+                    datagram.buffer->Release();
+                }
+            }
+        }
+    }
+
+    // Reserves len bytes for a message to conn and calls fill with a pointer
+    // to them. fill runs under the batcher lock, so it must only encode.
+    template<typename Fill>
+    void Write(HSteamNetConnection conn, size_t len, SendChannel channel, Fill&& fill) {
+        if (conn == k_HSteamNetConnection_Invalid || len == 0) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<Datagram>& datagrams = pending[conn].channels[channel];
+
+        if (1 + SUB_HEADER_BYTES + len > MAX_BATCH_BYTES) {
+            MessageBuffer* whole = MessageBufferPool::Instance().Acquire(len);
+            fill(whole->Data());
+            AppendFragments(datagrams, whole->Data(), len);
+            whole->Release();
+            return;
+        }
+
+        fill(AppendToBatch(datagrams, len));
+    }
+
+    // Queues an already encoded message whose buffer may be shared with other
+    // connections. It is copied into the connection's batch or fragments,
+    // which are specific to it anyway.
+    void QueueShared(HSteamNetConnection conn, MessageBuffer* buffer, size_t len, SendChannel channel) {
+        if (conn == k_HSteamNetConnection_Invalid || len == 0) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<Datagram>& datagrams = pending[conn].channels[channel];
+
+        if (1 + SUB_HEADER_BYTES + len > MAX_BATCH_BYTES) {
+            AppendFragments(datagrams, buffer->Data(), len);
+            return;
+        }
+
+        std::memcpy(AppendToBatch(datagrams, len), buffer->Data(), len);
+    }
+
+    // Hands every pending datagram to the transport in one Send call and
+    // returns the payload bytes sent
+    size_t Flush(ITransport* transport) {
+        std::map<HSteamNetConnection, ConnectionBatches> toSend;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            toSend.swap(pending);
+        }
+
+        if (toSend.empty()) return 0;
+
+        std::vector<OutgoingDatagram> datagrams;
+        size_t bytes = 0;
+
+        for (auto& [conn, batches] : toSend) {
+            for (int channel = 0; channel < CHANNEL_COUNT; channel++) {
+                for (Datagram& datagram : batches.channels[channel]) {
+                    OutgoingDatagram out;
+                    out.conn = conn;
+                    out.buffer = datagram.buffer;
+                    out.len = datagram.size;
+                    out.channel = static_cast<SendChannel>(channel);
+
+                    // A lone message does not need the batch header
+                    if (!datagram.raw && datagram.messageCount == 1) {
+                        out.offset = 1 + SUB_HEADER_BYTES;
+                        out.len -= 1 + SUB_HEADER_BYTES;
+                    }
+
+                    datagrams.push_back(out);
+                    bytes += out.len;
+                }
+            }
+        }
+
+        if (transport) {
+            transport->Send(datagrams.data(), static_cast<int>(datagrams.size()));
+        }
+        else {
+            bytes = 0;
+        }
+
+        // The transport took its own references to whatever it still needs
+        for (OutgoingDatagram& datagram : datagrams) {
+            datagram.buffer->Release();
+        }
+        return bytes;
+    }
+
+    // Calls handler once per message contained in a received datagram
+    static void Unpack(const uint8_t* data, int len, const std::function<void(const uint8_t*, int)>& handler) {
+        if (len < 1) return;
+
+        if (data[0] != PACKET_BATCH) {
+            handler(data, len);
+            return;
+        }
+
+        size_t offset = 1;
+        while (offset + SUB_HEADER_BYTES <= static_cast<size_t>(len)) {
+            size_t subLen = (static_cast<size_t>(data[offset]) << 8) | data[offset + 1];
+            offset += SUB_HEADER_BYTES;
+
+            if (subLen == 0 || offset + subLen > static_cast<size_t>(len)) {
+                Debug::Error("PacketBatcher") << "Malformed batch datagram, len=" << len << "\n";
+                return;
+            }
+
+            handler(data + offset, static_cast<int>(subLen));
+            offset += subLen;
+        }
+    }
+
+private:
+    static constexpr int CHANNEL_COUNT = 2;
+
+    struct Datagram {
+        MessageBuffer* buffer = nullptr;
+        size_t size = 0;
+        int messageCount = 0;
+        bool raw = false;   // Fragment, sent as is without batch header
+    };
+
+    struct ConnectionBatches {
+        std::vector<Datagram> channels[CHANNEL_COUNT];
+    };
+
+    std::mutex mtx;
+    std::map<HSteamNetConnection, ConnectionBatches> pending;
+    uint16_t nextMessageId = 0;
+
+    // Splits a message into fragment datagrams. Assumes mtx is held.
+    void AppendFragments(std::vector<Datagram>& datagrams, const uint8_t* message, size_t len) {
+        if (len > MAX_MESSAGE_BYTES) {
+            Debug::Error("PacketBatcher") << "Dropping " << len << " byte message, limit is " << MAX_MESSAGE_BYTES << "\n";
+            return;
+        }
+
+        uint16_t messageId = nextMessageId++;
+        uint16_t count = static_cast<uint16_t>((len + FRAGMENT_CHUNK_BYTES - 1) / FRAGMENT_CHUNK_BYTES);
+
+        for (uint16_t index = 0; index < count; index++) {
+            size_t offset = static_cast<size_t>(index) * FRAGMENT_CHUNK_BYTES;
+            size_t chunk = std::min(FRAGMENT_CHUNK_BYTES, len - offset);
+
+            Datagram fragment;
+            fragment.buffer = MessageBufferPool::Instance().Acquire(FRAGMENT_HEADER_BYTES + chunk);
+            fragment.size = FRAGMENT_HEADER_BYTES + chunk;
+            fragment.raw = true;
+
+            uint8_t* out = fragment.buffer->Data();
+            out[0] = PACKET_FRAGMENT;
+            WriteUint16(out + 1, messageId);
+            WriteUint16(out + 3, index);
+            WriteUint16(out + 5, count);
+            std::memcpy(out + FRAGMENT_HEADER_BYTES, message + offset, chunk);
+            datagrams.push_back(fragment);
+        }
+    }
+
+    static void WriteUint16(uint8_t* out, uint16_t value) {
+        out[0] = static_cast<uint8_t>(value >> 8);
+        out[1] = static_cast<uint8_t>(value & 0xFF);
+    }
+
+    // Returns where the next len byte message goes, opening a new batch
+    // datagram when the current one is full. Assumes mtx is held.
+    uint8_t* AppendToBatch(std::vector<Datagram>& datagrams, size_t len) {
+        if (datagrams.empty() || datagrams.back().raw ||
+            datagrams.back().size + SUB_HEADER_BYTES + len > MAX_BATCH_BYTES) {
+            Datagram batch;
+            batch.buffer = MessageBufferPool::Instance().Acquire(MAX_BATCH_BYTES);
+            batch.buffer->Data()[0] = PACKET_BATCH;
+            batch.size = 1;
+            datagrams.push_back(batch);
+        }
+
+        Datagram& batch = datagrams.back();
+        uint8_t* out = batch.buffer->Data() + batch.size;
+        uint16_t subLen = static_cast<uint16_t>(len);
+        out[0] = static_cast<uint8_t>(subLen >> 8);
+        out[1] = static_cast<uint8_t>(subLen & 0xFF);
+        batch.size += SUB_HEADER_BYTES + len;
+        batch.messageCount++;
+        return out + SUB_HEADER_BYTES;
+    }
+};
+
+// Puts fragmented messages back together, by connection and message id. A
+// fragment of an unreliable message may never arrive, so partial messages
+// are dropped after TIMEOUT_MS, and the oldest goes first once
+// MAX_PARTIAL_MESSAGES are waiting.
+class FragmentAssembler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto TIMEOUT = std::chrono::milliseconds(2000);
+    static constexpr size_t MAX_PARTIAL_MESSAGES = 16;
+
+    ~FragmentAssembler() {
+        for (auto& [key, partial] : partials) {
+            partial.buffer->Release();
+        }
+    }
+
+    // Takes a PACKET_FRAGMENT datagram and calls handler with the whole
+    // message once its last fragment is in
+    void Add(HSteamNetConnection conn, const uint8_t* data, int len, const std::function<void(const uint8_t*, int)>& handler) {
+        constexpr size_t HEADER = PacketBatcher::FRAGMENT_HEADER_BYTES;
+        constexpr size_t CHUNK = PacketBatcher::FRAGMENT_CHUNK_BYTES;
+        constexpr size_t MAX_COUNT = (PacketBatcher::MAX_MESSAGE_BYTES + CHUNK - 1) / CHUNK;
+
+        if (len <= static_cast<int>(HEADER) || data[0] != PACKET_FRAGMENT) return;
+
+        uint16_t messageId = ReadUint16(data + 1);
+        uint16_t index = ReadUint16(data + 3);
+        uint16_t count = ReadUint16(data + 5);
+        size_t chunk = static_cast<size_t>(len) - HEADER;
+
+        // Every fragment but the last is a full chunk
+        if (count == 0 || count > MAX_COUNT || index >= count || chunk > CHUNK ||
+            (index + 1 < count && chunk != CHUNK)) {
+            Debug::Error("PacketBatcher") << "Malformed fragment, len=" << len << "\n";
+            return;
+        }
+
+        Clock::time_point now = Clock::now();
+        DropExpired(now);
+
+        uint64_t key = (static_cast<uint64_t>(conn) << 16) | messageId;
+        auto it = partials.find(key);
+        if (it != partials.end() && it->second.received.size() != count) {
+            // A wrapped message id still holding an unfinished message
+            Drop(it);
+            it = partials.end();
+        }
+        if (it == partials.end()) {
+            if (partials.size() >= MAX_PARTIAL_MESSAGES) {
+                DropOldest();
+            }
+            Partial partial;
+            partial.buffer = MessageBufferPool::Instance().Acquire(count * CHUNK);
+            partial.received.assign(count, false);
+            partial.started = now;
+            it = partials.emplace(key, std::move(partial)).first;
+        }
+
+        Partial& partial = it->second;
+        if (partial.received[index]) return;
+
+        std::memcpy(partial.buffer->Data() + index * CHUNK, data + HEADER, chunk);
+        partial.received[index] = true;
+        partial.receivedCount++;
+        if (index + 1 == count) {
+            partial.size = index * CHUNK + chunk;
+        }
+
+        if (partial.receivedCount < count) return;
+
+        MessageBuffer* whole = partial.buffer;
+        int wholeLen = static_cast<int>(partial.size);
+        partials.erase(it);
+        handler(whole->Data(), wholeLen);
+        whole->Release();
+    }
+
+private:
+    struct Partial {
+        MessageBuffer* buffer = nullptr;
+        std::vector<bool> received;
+        uint16_t receivedCount = 0;
+        size_t size = 0;            // Known once the last fragment is in
+        Clock::time_point started;
+    };
+
+    std::map<uint64_t, Partial> partials;    // By connection and message id
+
+    static uint16_t ReadUint16(const uint8_t* in) {
+        return static_cast<uint16_t>((in[0] << 8) | in[1]);
+    }
+
+    void Drop(std::map<uint64_t, Partial>::iterator it) {
+        it->second.buffer->Release();
+        partials.erase(it);
+    }
+
+    void DropExpired(Clock::time_point now) {
+        for (auto it = partials.begin(); it != partials.end();) {
+            auto next = std::next(it);
+            if (now - it->second.started > TIMEOUT) {
+                Drop(it);
+            }
+            it = next;
+        }
+    }
+
+    void DropOldest() {
+        auto oldest = partials.begin();
+        for (auto it = partials.begin(); it != partials.end(); ++it) {
+            if (it->second.started < oldest->second.started) {
+                oldest = it;
+            }
+        }
+        if (oldest != partials.end()) {
+            Drop(oldest);
+        }
+    }
+};
+
+#endif // PACKET_BATCHER_H
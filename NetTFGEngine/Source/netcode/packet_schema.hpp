@@ -0,0 +1,322 @@
+#ifndef PACKET_SCHEMA_H
+#define PACKET_SCHEMA_H
+
+#include "netcode_common.hpp"
+#include "bitstream.hpp"
+
+// Wire format of every netcode packet. Each schema is shared by the sender
+// and the parser; the leading PacketType byte is written by GNSSession so
+// packets can still be dispatched on data[0].
+//
+// Frames inside the running game are sent as 16-bit wrapped values (see
+// SerializeFrame). Full states carry an absolute frame and re-anchor the
+// receiver after a reconnection.
+
+struct InputWindowPacket {
+    int playerId = 0;
+    int count = 0;
+    InputEntry inputs[INPUT_WINDOW_SIZE];
+};
+
+// Deltas that turn the state the client confirmed at baseFrame into the
+// state at frame. The client only applies them on top of baseFrame or newer.
+// More than MAX_DELTAS_PER_PACKET are split over partCount packets, and the
+// client applies them once it has every part.
+struct DeltasUpdatePacket {
+    int frame = 0;
+    int baseFrame = 0;
+    int part = 0;
+    int partCount = 1;
+    std::vector<DeltaStateBlob> deltas;
+};
+
+struct GameStartPacket {
+    int playerId = 0;
+    int ticksPerSecond = DEFAULT_TICKS_PER_SECOND;
+};
+
+struct FrameAckPacket {
+    int frame = 0;
+};
+
+// Every input up to frame has been received. When the packet brought a new
+// input, inputLeadUs is how long before the server simulates that input's
+// frame it arrived; negative when it came late.
+struct InputAckPacket {
+    int frame = 0;
+    bool hasLead = false;
+    int inputLeadUs = 0;
+};
+
+// Section hashes of a client's latest server state, sent when the server
+// asks for them after a hash mismatch
+struct HashTreePacket {
+    int frame = 0;
+    std::vector<StateHash> sectionHashes;
+};
+
+// Sections of the server state at frame that diverged on the client. Only the
+// bytes of the listed sections are sent; the rest of state is left untouched.
+struct StateRepairPacket {
+    int frame = 0;
+    GameStateBlob state;
+    std::vector<StateSection> sections;
+};
+
+// Largest number of deltas accepted in one packet
+constexpr int MAX_DELTAS_PER_PACKET = 256;
+
+// Largest number of packets one deltas update is split into
+constexpr int MAX_DELTA_PARTS = 64;
+
+// Largest number of hash sections a game state can be split into
+constexpr int MAX_HASH_SECTIONS = 256;
+
+// playerId, first frame and input in full, then for each later input a step
+// bit (set when it follows the previous frame directly, otherwise a varint
+// step), a mask with one bit per InputBlob byte that changed, and those bytes
+template<typename Stream>
+bool Serialize(Stream& stream, InputWindowPacket& packet) {
+    static_assert(sizeof(InputBlob) <= 32, "InputBlob change mask must fit in 32 bits");
+
+    if (!stream.SerializeVarint(packet.playerId) ||
+        !stream.SerializeInt(packet.count, 1, INPUT_WINDOW_SIZE)) {
+        return false;
+    }
+
+    InputEntry& first = packet.inputs[0];
+    if (!stream.SerializeFrame(first.frame) ||
+        !stream.SerializeBytes(first.input.data, sizeof(InputBlob))) {
+        return false;
+    }
+    if (Stream::IsReading) {
+        first.playerId = packet.playerId;
+    }
+
+    for (int i = 1; i < packet.count; i++) {
+        const InputEntry& prev = packet.inputs[i - 1];
+        InputEntry& cur = packet.inputs[i];
+
+        int step = Stream::IsWriting ? cur.frame - prev.frame : 0;
+        bool consecutive = step == 1;
+        if (!stream.SerializeBool(consecutive)) return false;
+        if (consecutive) {
+            step = 1;
+        }
+        else if (!stream.SerializeVarint(step) || step == 0) {
+            return false;
+        }
+
+        uint32_t mask = 0;
+        if (Stream::IsWriting) {
+            for (size_t b = 0; b < sizeof(InputBlob); b++) {
+                if (cur.input.data[b] != prev.input.data[b]) mask |= 1u << b;
+            }
+        }
+        if (!stream.SerializeBits(mask, static_cast<int>(sizeof(InputBlob)))) return false;
+
+        if (Stream::IsReading) {
+            cur.playerId = packet.playerId;
+            cur.frame = prev.frame + step;
+            cur.input = prev.input;
+        }
+
+        for (size_t b = 0; b < sizeof(InputBlob); b++) {
+            if (mask & (1u << b)) {
+                uint32_t value = cur.input.data[b];
+                if (!stream.SerializeBits(value, 8)) return false;
+                if (Stream::IsReading) {
+                    cur.input.data[b] = static_cast<uint8_t>(value);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// Another player's input relayed by the server
+template<typename Stream>
+bool Serialize(Stream& stream, InputEntry& entry) {
+    return stream.SerializeVarint(entry.playerId) &&
+        stream.SerializeFrame(entry.frame) &&
+        stream.SerializeBytes(entry.input.data, sizeof(InputBlob));
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, EventEntry& entry) {
+    return stream.SerializeFrame(entry.frame) &&
+        stream.SerializeSignedVarint(entry.event.type) &&
+        stream.SerializeBlob(entry.event.data, entry.event.len, static_cast<int>(GAME_EVENT_BLOB_SIZE));
+}
+
+// Length and bytes of a state, without its frame
+template<typename Stream>
+bool Serialize(Stream& stream, GameStateBlob& state) {
+    int len = state.len;
+    if (!stream.SerializeInt(len, 0, MAX_GAME_STATE_BYTES)) {
+        return false;
+    }
+    if (Stream::IsReading && !state.Resize(len)) {
+        return false;
+    }
+    uint8_t* bytes = Stream::IsReading ? state.MutableData() : const_cast<uint8_t*>(state.Data());
+    return stream.SerializeBytes(bytes, static_cast<size_t>(len));
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, StateUpdate& update) {
+    if (!stream.SerializeFullFrame(update.frame) ||
+        !Serialize(stream, update.state)) {
+        return false;
+    }
+    if (Stream::IsReading) {
+        update.state.frame = update.frame;
+    }
+    return true;
+}
+
+// One delta of a DeltasUpdatePacket, without its frame
+template<typename Stream>
+bool Serialize(Stream& stream, DeltaStateBlob& delta) {
+    return stream.SerializeSignedVarint(delta.delta_type) &&
+        stream.SerializeSignedVarint(delta.entityId) &&
+        stream.SerializeBlob(delta.data, delta.len, static_cast<int>(sizeof(delta.data)));
+}
+
+// Frame, then the base as frames before it, and which part of the update
+// this packet is
+template<typename Stream>
+bool Serialize(Stream& stream, DeltasUpdatePacket& packet) {
+    int count = static_cast<int>(packet.deltas.size());
+    int baseAge = packet.frame - packet.baseFrame;
+    if (!stream.SerializeFrame(packet.frame) ||
+        !stream.SerializeVarint(baseAge) ||
+        !stream.SerializeInt(packet.partCount, 1, MAX_DELTA_PARTS) ||
+        !stream.SerializeInt(packet.part, 0, packet.partCount - 1) ||
+        !stream.SerializeInt(count, 0, MAX_DELTAS_PER_PACKET)) {
+        return false;
+    }
+
+    if (Stream::IsReading) {
+        packet.baseFrame = packet.frame - baseAge;
+        packet.deltas.resize(count);
+    }
+
+    for (DeltaStateBlob& delta : packet.deltas) {
+        if (Stream::IsReading) {
+            delta.frame = packet.frame;
+        }
+        if (!Serialize(stream, delta)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, HashPacket& packet) {
+    return stream.SerializeFrame(packet.frame) &&
+        stream.SerializeUint64(packet.hash);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, HashTreePacket& packet) {
+    int count = static_cast<int>(packet.sectionHashes.size());
+    if (!stream.SerializeFrame(packet.frame) ||
+        !stream.SerializeInt(count, 0, MAX_HASH_SECTIONS)) {
+        return false;
+    }
+
+    if (Stream::IsReading) {
+        packet.sectionHashes.resize(count);
+    }
+
+    for (StateHash& hash : packet.sectionHashes) {
+        if (!stream.SerializeUint64(hash)) return false;
+    }
+    return true;
+}
+
+// Absolute frame like a full state, then the state length and each section as
+// offset, length and bytes
+template<typename Stream>
+bool Serialize(Stream& stream, StateRepairPacket& packet) {
+    constexpr int maxLen = MAX_GAME_STATE_BYTES;
+
+    int count = static_cast<int>(packet.sections.size());
+    int stateLen = packet.state.len;
+    if (!stream.SerializeFullFrame(packet.frame) ||
+        !stream.SerializeInt(stateLen, 0, maxLen) ||
+        !stream.SerializeInt(count, 0, MAX_HASH_SECTIONS)) {
+        return false;
+    }
+
+    if (Stream::IsReading) {
+        packet.state.frame = packet.frame;
+        if (!packet.state.Resize(stateLen)) {
+            return false;
+        }
+        packet.sections.resize(count);
+    }
+    uint8_t* bytes = Stream::IsReading ? packet.state.MutableData() : const_cast<uint8_t*>(packet.state.Data());
+
+    for (StateSection& section : packet.sections) {
+        int offset = static_cast<int>(section.offset);
+        int len = static_cast<int>(section.len);
+        if (!stream.SerializeInt(offset, 0, maxLen) ||
+            !stream.SerializeInt(len, 0, maxLen) ||
+            offset + len > packet.state.len ||
+            !stream.SerializeBytes(bytes + offset, static_cast<size_t>(len))) {
+            return false;
+        }
+        if (Stream::IsReading) {
+            section.offset = static_cast<uint32_t>(offset);
+            section.len = static_cast<uint32_t>(len);
+        }
+    }
+    return true;
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, InputDelayPacket& packet) {
+    return stream.SerializeVarint(packet.playerId) &&
+        stream.SerializeBits(packet.timestamp, 32);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, GameStartPacket& packet) {
+    return stream.SerializeVarint(packet.playerId) &&
+        stream.SerializeVarint(packet.ticksPerSecond);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, FrameAckPacket& packet) {
+    return stream.SerializeFrame(packet.frame);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, InputAckPacket& packet) {
+    if (!stream.SerializeFrame(packet.frame) || !stream.SerializeBool(packet.hasLead)) {
+        return false;
+    }
+    return !packet.hasLead || stream.SerializeSignedVarint(packet.inputLeadUs);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, ClientHelloPacket& packet) {
+    return stream.SerializeString(packet.clientId, sizeof(packet.clientId)) &&
+        stream.SerializeString(packet.matchId, sizeof(packet.matchId)) &&
+        stream.SerializeVarint(packet.snapshotsPerSecond);
+}
+
+template<typename Stream>
+bool Serialize(Stream& stream, ServerAcceptPacket& packet) {
+    return stream.SerializeVarint(packet.playerId) &&
+        stream.SerializeBool(packet.isReconnection) &&
+        stream.SerializeVarint(packet.hashCheckInterval) &&
+        stream.SerializeVarint(packet.ticksPerSecond) &&
+        stream.SerializeVarint(packet.snapshotInterval);
+}
+
+#endif // PACKET_SCHEMA_H
@@ -0,0 +1,296 @@
+#ifndef NETCODE_REPLAY_H
+#define NETCODE_REPLAY_H
+
+#include "netcode_common.hpp"
+#include "bitstream.hpp"
+#include "packet_schema.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// Replay file: REPLAY_MAGIC, then records, each a varint byte count and a
+// bit-packed payload. The first record is a ReplayHeader and every later one
+// the ReplayFrame of the next frame, so frames are not stored.
+constexpr char REPLAY_MAGIC[4] = { 'N', 'T', 'R', 'P' };
+constexpr int REPLAY_VERSION = 1;
+
+// Largest record accepted when reading, well above any header
+constexpr size_t MAX_REPLAY_RECORD_BYTES = MAX_GAME_STATE_BYTES + 1024;
+
+struct ReplayHeader {
+    int version = REPLAY_VERSION;
+    int ticksPerSecond = DEFAULT_TICKS_PER_SECOND;
+    uint32_t randomSeed = 0;
+    int startFrame = 0;
+    GameStateBlob state;        // Before startFrame was simulated
+};
+
+// What one frame was simulated with, and the hash of the state it produced
+struct ReplayFrame {
+    int frame = 0;
+    std::map<int, InputEntry> inputs;
+    std::vector<EventEntry> events;
+    StateHash hash = 0;
+};
+
+template<typename Stream>
+bool Serialize(Stream& stream, ReplayHeader& header) {
+    if (!stream.SerializeVarint(header.version) ||
+        header.version != REPLAY_VERSION ||
+        !stream.SerializeVarint(header.ticksPerSecond) ||
+        !stream.SerializeVarint(header.randomSeed) ||
+        !stream.SerializeFullFrame(header.startFrame) ||
+        !Serialize(stream, header.state)) {
+        return false;
+    }
+    if (Stream::IsReading) {
+        header.state.frame = header.startFrame;
+    }
+    return true;
+}
+
+// Inputs as changes to each player's previous one: player IDs, a bit telling
+// whether the input changed and, if so, a mask of the changed bytes and
+// those bytes, as in InputWindowPacket. previous is updated when reading;
+// the writer updates its own copy once the record is written.
+template<typename Stream>
+bool Serialize(Stream& stream, ReplayFrame& record, std::map<int, InputBlob>& previous) {
+    static_assert(sizeof(InputBlob) <= 32, "InputBlob change mask must fit in 32 bits");
+
+    if (!stream.SerializeUint64(record.hash)) {
+        return false;
+    }
+
+    int inputCount = static_cast<int>(record.inputs.size());
+    if (!stream.SerializeVarint(inputCount)) {
+        return false;
+    }
+
+    auto inputIt = record.inputs.begin();
+    for (int i = 0; i < inputCount; i++) {
+        int playerId = Stream::IsWriting ? inputIt->first : 0;
+        if (!stream.SerializeVarint(playerId)) {
+            return false;
+        }
+
+        InputEntry entry{ record.frame, MakeZeroInputBlob(), playerId };
+        if (Stream::IsWriting) {
+            entry = inputIt->second;
+            ++inputIt;
+        }
+
+        auto prevIt = previous.find(playerId);
+        InputBlob prev = prevIt != previous.end() ? prevIt->second : MakeZeroInputBlob();
+
+        uint32_t mask = 0;
+        if (Stream::IsWriting) {
+            for (size_t b = 0; b < sizeof(InputBlob); b++) {
+                if (entry.input.data[b] != prev.data[b]) mask |= 1u << b;
+            }
+        }
+
+        bool changed = mask != 0;
+        if (!stream.SerializeBool(changed) ||
+            (changed && !stream.SerializeBits(mask, static_cast<int>(sizeof(InputBlob))))) {
+            return false;
+        }
+
+        if (Stream::IsReading) {
+            entry.input = prev;
+        }
+        for (size_t b = 0; b < sizeof(InputBlob); b++) {
+            if (mask & (1u << b)) {
+                uint32_t value = entry.input.data[b];
+                if (!stream.SerializeBits(value, 8)) return false;
+                if (Stream::IsReading) {
+                    entry.input.data[b] = static_cast<uint8_t>(value);
+                }
+            }
+        }
+
+        if (Stream::IsReading) {
+            record.inputs[playerId] = entry;
+            previous[playerId] = entry.input;
+        }
+    }
+
+    int eventCount = static_cast<int>(record.events.size());
+    if (!stream.SerializeVarint(eventCount)) {
+        return false;
+    }
+    if (Stream::IsReading) {
+        record.events.assign(static_cast<size_t>(eventCount), EventEntry{});
+    }
+    for (EventEntry& entry : record.events) {
+        if (!stream.SerializeSignedVarint(entry.event.type) ||
+            !stream.SerializeBlob(entry.event.data, entry.event.len, static_cast<int>(GAME_EVENT_BLOB_SIZE))) {
+            return false;
+        }
+        entry.frame = record.frame;
+    }
+
+    return true;
+}
+
+// Writes the initial state and then, frame by frame, the inputs and events a
+// server simulated with, for ReplayReader to play back. Records go through
+// the file's own buffer, so a frame costs a few bytes and no system call.
+class ReplayWriter {
+public:
+    bool Open(const std::string& path, ReplayHeader& header) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        file.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+        bytesWritten = sizeof(REPLAY_MAGIC);
+        nextFrame = header.startFrame;
+        previous.clear();
+        return WriteRecord([&](auto& stream) { return Serialize(stream, header); });
+    }
+
+    // The frame after the previous one
+    bool WriteFrame(ReplayFrame& record) {
+        if (!file.is_open()) {
+            return false;
+        }
+
+        record.frame = nextFrame++;
+        if (!WriteRecord([&](auto& stream) { return Serialize(stream, record, previous); })) {
+            return false;
+        }
+        for (const auto& [playerId, entry] : record.inputs) {
+            previous[playerId] = entry.input;
+        }
+        return true;
+    }
+
+    void Close() {
+        if (file.is_open()) {
+            file.close();
+        }
+    }
+
+    bool IsOpen() const { return file.is_open(); }
+    uint64_t GetBytesWritten() const { return bytesWritten; }
+
+private:
+    std::ofstream file;
+    std::vector<uint8_t> buffer;
+    std::map<int, InputBlob> previous;
+    int nextFrame = 0;
+    uint64_t bytesWritten = 0;
+
+    template<typename Schema>
+    bool WriteRecord(Schema&& schema) {
+        MeasureStream measure;
+        if (!schema(measure)) {
+            return false;
+        }
+
+        buffer.assign(measure.BytesUsed(), 0);
+        WriteStream stream(buffer.data(), buffer.size());
+        if (!schema(stream)) {
+            return false;
+        }
+        stream.Flush();
+
+        uint8_t length[5];
+        size_t lengthBytes = 0;
+        uint32_t remaining = static_cast<uint32_t>(stream.BytesUsed());
+        do {
+            length[lengthBytes++] = static_cast<uint8_t>((remaining & 0x7F) | (remaining > 0x7F ? 0x80 : 0));
+            remaining >>= 7;
+        } while (remaining != 0);
+
+        file.write(reinterpret_cast<const char*>(length), static_cast<std::streamsize>(lengthBytes));
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(stream.BytesUsed()));
+        bytesWritten += lengthBytes + stream.BytesUsed();
+        return static_cast<bool>(file);
+    }
+};
+
+// Reads a whole replay into memory up front, so playing it back does no I/O
+class ReplayReader {
+public:
+    bool Open(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        if (data.size() < sizeof(REPLAY_MAGIC) ||
+            std::memcmp(data.data(), REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0) {
+            return false;
+        }
+        offset = sizeof(REPLAY_MAGIC);
+        previous.clear();
+
+        if (!ReadRecord([&](auto& stream) { return Serialize(stream, header); })) {
+            return false;
+        }
+        firstFrameOffset = offset;
+        nextFrame = header.startFrame;
+        return true;
+    }
+
+    const ReplayHeader& GetHeader() const { return header; }
+
+    // False at the end of the replay or at a damaged record
+    bool ReadFrame(ReplayFrame& record) {
+        record = ReplayFrame{};
+        record.frame = nextFrame;
+        if (!ReadRecord([&](auto& stream) { return Serialize(stream, record, previous); })) {
+            return false;
+        }
+        nextFrame++;
+        return true;
+    }
+
+    // Back to the first frame
+    void Rewind() {
+        offset = firstFrameOffset;
+        previous.clear();
+        nextFrame = header.startFrame;
+    }
+
+    bool AtEnd() const { return offset >= data.size(); }
+
+private:
+    std::vector<uint8_t> data;
+    size_t offset = 0;
+    size_t firstFrameOffset = 0;
+    ReplayHeader header;
+    std::map<int, InputBlob> previous;
+    int nextFrame = 0;
+
+    template<typename Schema>
+    bool ReadRecord(Schema&& schema) {
+        uint32_t length = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (offset >= data.size() || shift > 28) {
+                return false;
+            }
+            uint8_t byte = data[offset++];
+            length |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+        }
+        if (length > MAX_REPLAY_RECORD_BYTES || length > data.size() - offset) {
+            return false;
+        }
+
+        ReadStream stream(data.data() + offset, length, nextFrame);
+        offset += length;
+        return schema(stream);
+    }
+};
+
+#endif // NETCODE_REPLAY_H
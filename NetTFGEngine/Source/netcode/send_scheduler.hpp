@@ -0,0 +1,185 @@
+#ifndef NETCODE_SEND_SCHEDULER_H
+#define NETCODE_SEND_SCHEDULER_H
+
+#include "netcode_common.hpp"
+#include "packet_schema.hpp"
+#include "interest_grid.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Picks which deltas go into a client's next update when updates are capped
+// to a byte budget or filtered by the client's area of interest.
+//
+// Deltas tied to an entity wait here until they are sent. Every update adds
+// the entity's priority to its accumulator, CHANGE_BOOST times over when
+// the entity changed again since the last update, and the update is filled
+// with the highest accumulators first. A sent entity starts again from zero,
+// so low-priority entities are sent less often but are never starved.
+// Deltas hold absolute values: a newer delta of an entity replaces the
+// waiting one, and nothing is lost by sending only the latest.
+//
+// Entities outside the client's interest wait without gaining priority and
+// go out with their latest values once they come into view. Deltas not tied
+// to an entity are always sent.
+//
+// A deferred delta can be older than the state the client acks, so later
+// updates do not carry it again. Sent ones are kept until the client acks
+// the very update they went out in, and queued again if that ack does not
+// come within STATE_ACK_TIMEOUT_FRAMES.
+class DeltaSendScheduler {
+public:
+    static constexpr float CHANGE_BOOST = 2.0f;
+
+    // Deltas since the state the client last acked. A newer delta of an
+    // entity makes the one in flight obsolete.
+    void Queue(const std::vector<DeltaStateBlob>& deltas) {
+        for (const DeltaStateBlob& delta : deltas) {
+            if (delta.entityId < 0) {
+                untied.push_back(delta);
+                continue;
+            }
+            uint64_t key = Key(delta);
+            inFlight.erase(key);
+            Pending& entry = pending[key];
+            entry.delta = delta;
+            entry.changed = true;
+        }
+    }
+
+    // The client confirmed the update of frame, so what went out in it arrived.
+    // Acking a later frame proves nothing: that update may have been based on
+    // an older state.
+    void Acknowledge(int frame) {
+        std::erase_if(inFlight, [frame](const auto& item) { return item.second.sentFrame == frame; });
+    }
+
+    // The client may confirm frame without the update sent at it, as when it
+    // is repaired at that frame instead
+    void Resend(int frame) {
+        for (auto it = inFlight.begin(); it != inFlight.end(); ) {
+            if (it->second.sentFrame == frame) {
+                Requeue(it->first, it->second.delta);
+                it = inFlight.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    // Appends the deltas of the next update to out: every one not tied to an
+    // entity, then the visible entities by accumulated priority while they
+    // fit in budgetBytes (0 for no cap). At least one entity is sent even if
+    // it alone is larger. The update goes out at state.frame.
+    void Select(const IGameLogic& logic, const GameStateBlob& state, int playerId,
+        const InterestSet& interest, size_t budgetBytes, std::vector<DeltaStateBlob>& out)
+    {
+        // Sent so long ago that their update must have been lost
+        for (auto it = inFlight.begin(); it != inFlight.end(); ) {
+            if (state.frame - it->second.sentFrame > STATE_ACK_TIMEOUT_FRAMES) {
+                Requeue(it->first, it->second.delta);
+                it = inFlight.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        size_t usedBytes = 0;
+        for (const DeltaStateBlob& delta : untied) {
+            usedBytes += MeasureDelta(delta);
+            out.push_back(delta);
+        }
+        untied.clear();
+
+        std::vector<std::map<uint64_t, Pending>::iterator> candidates;
+        for (auto it = pending.begin(); it != pending.end(); ++it) {
+            Pending& entry = it->second;
+            if (!interest.IsVisible(entry.delta.entityId)) {
+                continue;
+            }
+            float priority = logic.GetDeltaPriority(state, entry.delta, playerId);
+            entry.accumulated += priority * (entry.changed ? CHANGE_BOOST : 1.0f);
+            entry.changed = false;
+            candidates.push_back(it);
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+            return a->second.accumulated > b->second.accumulated;
+        });
+
+        bool sentEntity = false;
+        std::vector<uint64_t> sent;
+        for (const auto& it : candidates) {
+            if (out.size() >= static_cast<size_t>(MAX_DELTAS_PER_PACKET)) {
+                break;
+            }
+
+            size_t bytes = MeasureDelta(it->second.delta);
+            if (budgetBytes > 0 && sentEntity && usedBytes + bytes > budgetBytes) {
+                continue;
+            }
+
+            usedBytes += bytes;
+            out.push_back(it->second.delta);
+            sent.push_back(it->first);
+            sentEntity = true;
+        }
+
+        for (uint64_t key : sent) {
+            auto it = pending.find(key);
+            inFlight[key] = InFlight{ it->second.delta, state.frame };
+            pending.erase(it);
+        }
+    }
+
+    // Entity deltas the client has not been sent
+    size_t GetPendingCount() const { return pending.size(); }
+
+    // The client is getting a full state instead
+    void Clear() {
+        pending.clear();
+        inFlight.clear();
+        untied.clear();
+    }
+
+private:
+    struct Pending {
+        DeltaStateBlob delta;
+        float accumulated = 0.0f;
+        bool changed = false;
+    };
+
+    struct InFlight {
+        DeltaStateBlob delta;
+        int sentFrame = 0;      // Frame of the update it went out in
+    };
+
+    std::map<uint64_t, Pending> pending;     // By delta type and entity
+    std::map<uint64_t, InFlight> inFlight;   // Sent, until the client acks it
+    std::vector<DeltaStateBlob> untied;
+
+    // A waiting delta of the entity is newer and wins
+    void Requeue(uint64_t key, const DeltaStateBlob& delta) {
+        auto [it, inserted] = pending.try_emplace(key);
+        if (inserted) {
+            it->second.delta = delta;
+            it->second.changed = true;
+        }
+    }
+
+    static uint64_t Key(const DeltaStateBlob& delta) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(delta.delta_type)) << 32) |
+            static_cast<uint32_t>(delta.entityId);
+    }
+
+    static size_t MeasureDelta(const DeltaStateBlob& delta) {
+        MeasureStream stream;
+        Serialize(stream, const_cast<DeltaStateBlob&>(delta));
+        return stream.BytesUsed();
+    }
+};
+
+#endif // NETCODE_SEND_SCHEDULER_H
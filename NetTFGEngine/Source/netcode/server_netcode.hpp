@@ -1,10 +1,15 @@
 ﻿#ifndef SERVER_NETCODE_H
 #define SERVER_NETCODE_H
 #include "netcode_common.hpp"
+#include "mpsc_queue.hpp"
+#include "replay.hpp"
+#include "Utils/Debug/Debug.hpp"
 #include <set>
 #include <algorithm>
 #include <cmath>
-#include <queue>
+#include <deque>
+#include <random>
+#include <string>
 
 // Server-side rollback netcode
 class ServerNetcode {
@@ -13,9 +18,11 @@ public:
         SetGameLogic(std::move(logic));
     }
 
-    void OnClientInputReceived(InputEntry input) {
-        std::lock_guard<std::mutex> lk(mtx);
-        appliedInputs[input.frame][input.playerId] = input;
+    // Called from the network thread. Inputs are queued without taking mtx and
+    // applied at the start of the next Tick, so receiving never waits for a
+    // simulation step. False if the queue is full; the input was not taken.
+    bool OnClientInputReceived(const InputEntry& input) {
+        return pendingInputs.TryPush(input);
     }
 
     void OnPlayerConnected(int playerId) {
@@ -59,6 +66,16 @@ public:
     StateUpdate Tick() {
         std::lock_guard<std::mutex> lk(mtx);
 
+        relayedInputs.clear();
+        pendingInputs.Drain([this](InputEntry input) {
+            // Arrived after its frame was simulated, apply it as soon as possible
+            if (input.frame < currentFrame) {
+                input.frame = currentFrame;
+            }
+            appliedInputs[input.frame][input.playerId] = input;
+            relayedInputs.push_back(input);
+        });
+
         SimulateFrame(currentFrame);
 
         currentFrame++;
@@ -78,9 +95,17 @@ public:
         return update;
     }
 
-    int GetCurrentFrame() {
+    // Inputs the last Tick added to the history, received or repeated for a
+    // player whose input was missing, stamped with the frame they are applied
+    // at, for the server to pass on to the other clients
+    void GetRelayedInputs(std::vector<InputEntry>& inputs) {
         std::lock_guard<std::mutex> lk(mtx);
-        return currentFrame;
+        inputs = relayedInputs;
+    }
+
+    // Lock-free, safe to call from the network thread while a tick runs
+    int GetCurrentFrame() const {
+        return currentFrame.load();
     }
 
     GameStateBlob GetCurrentState() {
@@ -90,27 +115,96 @@ public:
 
 	GameStateBlob GetStateAtFrame(int frame) {
 		std::lock_guard<std::mutex> lk(mtx);
-		
-		// Search in state history
-		std::queue<GameStateBlob> tempQueue = stateHistory;
-		while (!tempQueue.empty())
+
+		HistoryEntry* entry = FindHistoryEntry(frame);
+		if (entry)
 		{
-			GameStateBlob s = tempQueue.front();
-			tempQueue.pop();
-			if (s.frame == frame)
-			{
-				return s;
-			}
+			return entry->state;
 		}
 
 		// If not found, return current state as fallback
 		return gameState;
 	}
 
+	// Deltas that turn the state at frame into the current one, as if the
+	// ticks in between were a single tick. False if the frame has left the
+	// history.
+	bool GenerateDeltasSince(int frame, std::vector<DeltaStateBlob>& deltas) {
+		std::lock_guard<std::mutex> lk(mtx);
+
+		HistoryEntry* entry = FindHistoryEntry(frame);
+		if (!entry)
+		{
+			return false;
+		}
+
+		gameLogic->generatedDeltas.clear();
+		gameLogic->GenerateDeltas(entry->state, gameState);
+		deltas = gameLogic->generatedDeltas;
+		return true;
+	}
+
+	// Hash of the state at frame, computed the first time it is asked for and
+	// kept with the state. False if the frame has left the history.
+	bool GetHashAtFrame(int frame, StateHash& hash) {
+		std::lock_guard<std::mutex> lk(mtx);
+
+		HistoryEntry* entry = FindHistoryEntry(frame);
+		if (!entry)
+		{
+			return false;
+		}
+
+		if (!entry->hashed)
+		{
+			entry->hash = gameLogic->HashState(entry->state);
+			entry->hashed = true;
+		}
+		hash = entry->hash;
+		return true;
+	}
+
+	// Sections whose hashes at frame differ from clientHashes, found by
+	// comparing hash trees, together with the current state to repair them
+	// from. False if the frame has left the history or the client splits the
+	// state into a different number of sections.
+	bool GetDivergentSections(int frame, const std::vector<StateHash>& clientHashes,
+		GameStateBlob& current, std::vector<StateSection>& divergent) {
+		std::lock_guard<std::mutex> lk(mtx);
+
+		HistoryEntry* entry = FindHistoryEntry(frame);
+		if (!entry)
+		{
+			return false;
+		}
+
+		std::vector<StateHash> serverHashes;
+		gameLogic->HashSections(entry->state, serverHashes);
+
+		std::vector<StateSection> sections;
+		gameLogic->GetHashSections(gameState, sections);
+		if (serverHashes.size() != clientHashes.size() || sections.size() != serverHashes.size())
+		{
+			return false;
+		}
+
+		std::vector<size_t> leaves;
+		StateHashTree(serverHashes).DiffLeaves(StateHashTree(clientHashes), leaves);
+
+		divergent.clear();
+		for (size_t leaf : leaves)
+		{
+			divergent.push_back(sections[leaf]);
+		}
+		current = gameState;
+		return true;
+	}
+
     void SetGameLogic(std::unique_ptr<IGameLogic> logic) {
         std::lock_guard<std::mutex> lk(mtx);
         gameLogic = std::move(logic);
         gameLogic->isServer = true;
+        gameLogic->randomSeed = std::random_device{}();
         gameLogic->Init(gameState);
         gameState.frame = 0;
     }
@@ -121,17 +215,53 @@ public:
         return gameLogic.get();
     }
 
+    // Writes the current state and, from then on, the inputs and events of
+    // every simulated frame with the hash of its result, for a ReplayRunner.
+    // Started before the first tick, the replay can also be rebuilt from
+    // Init and the seed. False if the file cannot be written.
+    bool StartRecording(const std::string& path) {
+        std::lock_guard<std::mutex> lk(mtx);
+        ReplayHeader header;
+        header.ticksPerSecond = gameLogic->ticksPerSecond;
+        header.randomSeed = gameLogic->randomSeed;
+        header.startFrame = currentFrame;
+        header.state = gameState;
+        return replay.Open(path, header);
+    }
+
+    void StopRecording() {
+        std::lock_guard<std::mutex> lk(mtx);
+        replay.Close();
+    }
+
+    bool IsRecording() {
+        std::lock_guard<std::mutex> lk(mtx);
+        return replay.IsOpen();
+    }
+
     
 
 private:
+    // Inputs received since the last tick, drained by Tick()
+    static constexpr size_t INPUT_QUEUE_CAPACITY = 1024;
+
     std::mutex mtx;
-    int currentFrame = 0;
+    std::atomic<int> currentFrame{ 0 };
+    MpscQueue<InputEntry, INPUT_QUEUE_CAPACITY> pendingInputs;
     GameStateBlob gameState;
-	std::queue<GameStateBlob> stateHistory;
+	struct HistoryEntry {
+		GameStateBlob state;
+		StateHash hash = 0;
+		bool hashed = false;
+	};
+	std::deque<HistoryEntry> stateHistory;   // One entry per frame, oldest first
     std::unique_ptr<IGameLogic> gameLogic;
     InputHistory appliedInputs;
+    std::vector<InputEntry> relayedInputs;
     EventsHistory appliedEvents;
     std::set<int> connectedPlayers;
+    std::map<int, InputBlob> lastInputs;
+    ReplayWriter replay;
 
     // ✅ FIXED: Now private and assumes lock is held
     void SimulateFrame(int frame) {
@@ -143,6 +273,23 @@ private:
             inputs = frameInIt->second;
         }
 
+        // A connected player whose input has not arrived keeps doing what it
+        // did last instead of suddenly releasing every key. The repeated input
+        // is relayed like a received one so clients simulate the same frame.
+        for (int playerId : connectedPlayers) {
+            auto inIt = inputs.find(playerId);
+            if (inIt == inputs.end()) {
+                auto lastIt = lastInputs.find(playerId);
+                InputEntry repeated{ frame, lastIt != lastInputs.end() ? lastIt->second : MakeZeroInputBlob(), playerId };
+                inputs[playerId] = repeated;
+                appliedInputs[frame][playerId] = repeated;
+                relayedInputs.push_back(repeated);
+            }
+        }
+        for (auto& [playerId, entry] : inputs) {
+            lastInputs[playerId] = entry.input;
+        }
+
         /*for (auto& entry : inputs) {
 			// Print inputs for debugging
 			std::cout << "Frame " << frame << " - Player " << entry.first << " Input: ";
@@ -171,13 +318,38 @@ private:
         appliedEvents[frame + 1] = gameLogic->generatedEvents;
         gameState.frame = frame+1;
 
-		stateHistory.push(gameState);
+		stateHistory.push_back(HistoryEntry{ gameState });
 		if (stateHistory.size() > 300) 
 		{
-			stateHistory.pop();
+			stateHistory.pop_front();
+		}
+
+		if (replay.IsOpen())
+		{
+			HistoryEntry& entry = stateHistory.back();
+			entry.hash = gameLogic->HashState(entry.state);
+			entry.hashed = true;
+
+			ReplayFrame record{ frame, std::move(inputs), std::move(events), entry.hash };
+			if (!replay.WriteFrame(record))
+			{
+				Debug::Error("Replay") << "Could not write frame " << frame << ", recording stopped\n";
+				replay.Close();
+			}
 		}
     }
 
+	// Assumes lock is held
+	HistoryEntry* FindHistoryEntry(int frame) {
+		if (stateHistory.empty()) return nullptr;
+
+		int index = frame - stateHistory.front().state.frame;
+		if (index < 0 || index >= static_cast<int>(stateHistory.size())) return nullptr;
+
+		HistoryEntry& entry = stateHistory[index];
+		return entry.state.frame == frame ? &entry : nullptr;
+	}
+
     // ✅ NEW: Cleanup old frames to prevent unbounded memory growth
     // Internal version called from Tick() - assumes lock is held
     void CleanupOldFramesInternal() {
@@ -0,0 +1,211 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// 64-bit desync checksum of a game state
+using StateHash = uint64_t;
+
+// Streaming XXH64. Not cryptographic: it only has to tell two simulations
+// apart, and it runs at memory speed with no allocation or library context.
+class StateHasher {
+public:
+    explicit StateHasher(uint64_t seed = 0) {
+        Reset(seed);
+    }
+
+    void Reset(uint64_t seed = 0) {
+        acc[0] = seed + PRIME1 + PRIME2;
+        acc[1] = seed + PRIME2;
+        acc[2] = seed;
+        acc[3] = seed - PRIME1;
+        this->seed = seed;
+        totalLen = 0;
+        bufferedLen = 0;
+    }
+
+    void Update(const void* data, size_t len) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        totalLen += len;
+
+        if (bufferedLen + len < STRIPE_BYTES) {
+            std::memcpy(buffer + bufferedLen, p, len);
+            bufferedLen += len;
+            return;
+        }
+
+        if (bufferedLen > 0) {
+            size_t fill = STRIPE_BYTES - bufferedLen;
+            std::memcpy(buffer + bufferedLen, p, fill);
+            ConsumeStripe(buffer);
+            p += fill;
+            len -= fill;
+            bufferedLen = 0;
+        }
+
+        while (len >= STRIPE_BYTES) {
+            ConsumeStripe(p);
+            p += STRIPE_BYTES;
+            len -= STRIPE_BYTES;
+        }
+
+        std::memcpy(buffer, p, len);
+        bufferedLen = len;
+    }
+
+    template<typename T>
+    void UpdateValue(const T& value) {
+        Update(&value, sizeof(T));
+    }
+
+    StateHash Digest() const {
+        uint64_t h;
+        if (totalLen >= STRIPE_BYTES) {
+            h = Rotl(acc[0], 1) + Rotl(acc[1], 7) + Rotl(acc[2], 12) + Rotl(acc[3], 18);
+            for (uint64_t a : acc) {
+                h = (h ^ Round(0, a)) * PRIME1 + PRIME4;
+            }
+        }
+        else {
+            h = seed + PRIME5;
+        }
+        h += totalLen;
+
+        const uint8_t* p = buffer;
+        size_t len = bufferedLen;
+        while (len >= 8) {
+            h ^= Round(0, Read64(p));
+            h = Rotl(h, 27) * PRIME1 + PRIME4;
+            p += 8;
+            len -= 8;
+        }
+        if (len >= 4) {
+            h ^= static_cast<uint64_t>(Read32(p)) * PRIME1;
+            h = Rotl(h, 23) * PRIME2 + PRIME3;
+            p += 4;
+            len -= 4;
+        }
+        while (len > 0) {
+            h ^= static_cast<uint64_t>(*p) * PRIME5;
+            h = Rotl(h, 11) * PRIME1;
+            p++;
+            len--;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr size_t STRIPE_BYTES = 32;
+    static constexpr uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t PRIME4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t PRIME5 = 0x27D4EB2F165667C5ULL;
+
+    static uint64_t Rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    static uint64_t Round(uint64_t a, uint64_t input) {
+        a += input * PRIME2;
+        a = Rotl(a, 31);
+        return a * PRIME1;
+    }
+
+    // Little-endian reads, so every platform agrees on the hash of the same bytes
+    static uint64_t Read64(const uint8_t* p) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+        return v;
+    }
+
+    static uint32_t Read32(const uint8_t* p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+            (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    void ConsumeStripe(const uint8_t* p) {
+        for (int i = 0; i < 4; i++) {
+            acc[i] = Round(acc[i], Read64(p + i * 8));
+        }
+    }
+
+    uint64_t acc[4];
+    uint64_t seed;
+    uint64_t totalLen;
+    uint8_t buffer[STRIPE_BYTES];
+    size_t bufferedLen;
+};
+
+inline StateHash HashBytes(const void* data, size_t len, uint64_t seed = 0) {
+    StateHasher hasher(seed);
+    hasher.Update(data, len);
+    return hasher.Digest();
+}
+
+// Byte range of a GameStateBlob hashed on its own, so a mismatch can be
+// narrowed down to the part of the state that diverged
+struct StateSection {
+    uint32_t offset = 0;
+    uint32_t len = 0;
+};
+
+// Binary hash tree over section hashes. Two peers holding trees of the same
+// state find the sections that differ by walking down only from nodes whose
+// hashes disagree, instead of comparing every section.
+class StateHashTree {
+public:
+    explicit StateHashTree(const std::vector<StateHash>& leaves)
+        : leafCount(leaves.size()) {
+        width = 1;
+        while (width < leafCount) width <<= 1;
+
+        // Heap layout: root at 1, children of n at 2n and 2n + 1, leaves from width
+        nodes.assign(2 * width, 0);
+        for (size_t i = 0; i < leafCount; i++) {
+            nodes[width + i] = leaves[i];
+        }
+        for (size_t n = width - 1; n >= 1; n--) {
+            StateHash children[2] = { nodes[2 * n], nodes[2 * n + 1] };
+            nodes[n] = HashBytes(children, sizeof(children));
+        }
+    }
+
+    StateHash Root() const { return nodes[1]; }
+    size_t LeafCount() const { return leafCount; }
+
+    // Indices of the leaves that differ from other. Both trees must have the
+    // same number of leaves.
+    void DiffLeaves(const StateHashTree& other, std::vector<size_t>& out) const {
+        out.clear();
+        if (other.leafCount != leafCount || leafCount == 0) return;
+        DiffNode(other, 1, out);
+    }
+
+private:
+    size_t leafCount;
+    size_t width;
+    std::vector<StateHash> nodes;
+
+    void DiffNode(const StateHashTree& other, size_t n, std::vector<size_t>& out) const {
+        if (nodes[n] == other.nodes[n]) return;
+
+        if (n >= width) {
+            if (n - width < leafCount) out.push_back(n - width);
+            return;
+        }
+        DiffNode(other, 2 * n, out);
+        DiffNode(other, 2 * n + 1, out);
+    }
+};
+
+#endif // STATE_HASH_H
@@ -0,0 +1,106 @@
+#ifndef TICK_SCHEDULER_H
+#define TICK_SCHEDULER_H
+
+#include "netcode_common.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Range of tick rates a server accepts and a client follows
+const int MIN_TICKS_PER_SECOND = 1;
+const int MAX_TICKS_PER_SECOND = 240;
+
+inline int ClampTickRate(int ticksPerSecond) {
+    return std::clamp(ticksPerSecond, MIN_TICKS_PER_SECOND, MAX_TICKS_PER_SECOND);
+}
+
+// Deadlines of a fixed-rate loop. Tick n is due n / rate seconds after the
+// start, worked out in microseconds from the start instead of adding a
+// rounded period every tick, so rates that do not divide a second (30 Hz is
+// 33.333 ms) do not drift. A loop that falls behind runs the missed ticks
+// back to back. A time scale other than 1 runs the loop that much faster,
+// for clients that slightly speed up or slow down to stay in step with the
+// server.
+class FixedTickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FixedTickScheduler(int ticksPerSecond = DEFAULT_TICKS_PER_SECOND)
+        : rate(ClampTickRate(ticksPerSecond))
+    {
+        UpdatePeriod();
+    }
+
+    // The first tick is due at now
+    void Start(Clock::time_point now = Clock::now()) {
+        start = now;
+        ticks = 0;
+        started = true;
+    }
+
+    bool IsStarted() const { return started; }
+
+    // Takes effect from the next tick on
+    void SetRate(int ticksPerSecond) {
+        ticksPerSecond = ClampTickRate(ticksPerSecond);
+        if (ticksPerSecond == rate) {
+            return;
+        }
+        Rebase();
+        rate = ticksPerSecond;
+        UpdatePeriod();
+    }
+
+    // Takes effect from the next tick on
+    void SetTimeScale(double scale) {
+        if (scale <= 0.0 || scale == timeScale) {
+            return;
+        }
+        Rebase();
+        timeScale = scale;
+        UpdatePeriod();
+    }
+
+    int GetRate() const { return rate; }
+    double GetTimeScale() const { return timeScale; }
+    double GetTickSeconds() const { return 1.0 / rate; }
+    double GetTickMs() const { return 1000.0 / rate; }
+
+    Clock::time_point NextTickTime() const {
+        return start + std::chrono::microseconds(std::llround(ticks * periodUs));
+    }
+
+    bool IsDue(Clock::time_point now = Clock::now()) const {
+        return NextTickTime() <= now;
+    }
+
+    // The tick that was due has run
+    void Advance() { ticks++; }
+
+    void SleepUntilNext() const {
+        std::this_thread::sleep_until(NextTickTime());
+    }
+
+private:
+    int rate;
+    double timeScale = 1.0;
+    double periodUs = 0.0;
+    Clock::time_point start;
+    int64_t ticks = 0;
+    bool started = false;
+
+    // Ticks so far keep their deadlines; later ones follow the new period
+    void Rebase() {
+        if (started) {
+            start = NextTickTime();
+            ticks = 0;
+        }
+    }
+
+    void UpdatePeriod() {
+        periodUs = 1000000.0 / (rate * timeScale);
+    }
+};
+
+#endif // TICK_SCHEDULER_H
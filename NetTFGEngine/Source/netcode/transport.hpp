@@ -0,0 +1,86 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "netcode_common.hpp"
+#include "message_buffer_pool.hpp"
+#include <functional>
+#include <ostream>
+#include <string>
+
+enum ConnectionCode : uint8_t {
+	CONN_SUCCESS = 0,
+	CONN_SOCKETS_FAILED = 1,
+	CONN_PARSE_ERROR = 2,
+	CONN_TIMEOUT = 3,
+	CONN_DENIED = 4
+};
+
+inline std::ostream& operator<<(std::ostream& os, ConnectionCode code) {
+    switch (code) {
+    case CONN_SUCCESS: return os << "CONN_SUCCESS";
+    case CONN_SOCKETS_FAILED: return os << "CONN_SOCKETS_FAILED";
+    case CONN_PARSE_ERROR: return os << "CONN_PARSE_ERROR";
+    case CONN_TIMEOUT: return os << "CONN_TIMEOUT";
+    case CONN_DENIED: return os << "CONN_DENIED";
+    default: return os << "UNKNOWN(" << static_cast<int>(code) << ")";
+    }
+}
+
+enum TransportState : uint8_t {
+    TRANSPORT_INVALID = 0,      // No such connection, or closed on this side
+    TRANSPORT_CONNECTING = 1,
+    TRANSPORT_CONNECTED = 2,
+    TRANSPORT_CLOSED = 3        // Closed by the peer or lost
+};
+
+// len bytes of buffer starting at offset, to go out on conn
+struct OutgoingDatagram {
+    HSteamNetConnection conn = k_HSteamNetConnection_Invalid;
+    MessageBuffer* buffer = nullptr;
+    size_t offset = 0;
+    size_t len = 0;
+    SendChannel channel = CHANNEL_UNRELIABLE;
+};
+
+using DatagramHandler = std::function<void(const uint8_t*, int, HSteamNetConnection)>;
+
+// Moves datagrams between connections. GNSSession encodes, batches and
+// decodes packets on top of it; a transport only delivers whole datagrams,
+// reliably and in order on CHANNEL_RELIABLE, best effort on CHANNEL_UNRELIABLE.
+//
+// Send may be called from any thread. Receive and Wait are called by one
+// receiving thread at a time.
+class ITransport {
+public:
+    virtual ~ITransport() = default;
+
+    virtual bool Init() = 0;
+    virtual void Shutdown() = 0;
+
+    // Accepts connections on port; their datagrams come out of Receive
+    virtual bool Listen(uint16_t port) = 0;
+
+    // Starts connecting. conn is valid at once and reports TRANSPORT_CONNECTED
+    // once the peer accepted.
+    virtual ConnectionCode Connect(const std::string& host, uint16_t port, HSteamNetConnection& conn) = 0;
+
+    virtual TransportState GetConnectionState(HSteamNetConnection conn) = 0;
+
+    // With linger, datagrams already sent are still delivered
+    virtual void CloseConnection(HSteamNetConnection conn, bool linger) = 0;
+
+    // Buffers are borrowed: a transport that keeps one past the call takes
+    // its own reference
+    virtual void Send(const OutgoingDatagram* datagrams, int count) = 0;
+
+    // Hands up to maxDatagrams received datagrams to handler, returns how many
+    virtual int Receive(const DatagramHandler& handler, int maxDatagrams) = 0;
+
+    // Processes connection state changes
+    virtual void RunCallbacks() = 0;
+
+    // Blocks until a datagram may be ready or maxWaitMs passes
+    virtual void Wait(int maxWaitMs) = 0;
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,922 @@
+#ifndef UDP_TRANSPORT_H
+#define UDP_TRANSPORT_H
+
+#ifdef __linux__
+
+#include "transport.hpp"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Utils/Debug/Debug.hpp"
+
+// Every UDP datagram starts with one of these
+enum UdpPacketType : uint8_t {
+    UDP_CONNECT = 1,            // Client -> server: protocol id, client salt
+    UDP_ACCEPT = 2,             // Server -> client: client salt, server salt
+    UDP_UNRELIABLE = 3,         // token, payload
+    UDP_RELIABLE = 4,           // token, sequence, payload
+    UDP_ACK = 5,                // token, next expected sequence, bitmask of the 32 after it
+    UDP_KEEPALIVE = 6,          // token
+    UDP_DISCONNECT = 7,         // token
+    UDP_CHALLENGE = 8,          // Server -> client: client salt, cookie
+    UDP_RESPONSE = 9            // Client -> server: protocol id, client salt, cookie
+};
+
+// ITransport straight over a non-blocking Linux UDP socket, for dedicated
+// servers hosting many matches. A whole Send goes out in one sendmmsg call
+// and Receive reads up to RECV_BATCH datagrams per recvmmsg, so the syscall
+// cost is per batch rather than per packet.
+//
+// Connections are set up by a challenge handshake: the client repeats CONNECT
+// with a random salt until the server answers CHALLENGE with a cookie made
+// from a secret, the client's address and its salt, then repeats RESPONSE
+// with that cookie until the server answers ACCEPT with its own salt. The
+// server keeps nothing until a valid cookie comes back, so spoofed CONNECTs
+// cannot fill it with connections, and it takes at most MAX_CONNECTIONS.
+// Every later datagram carries both salts XORed as a token, so datagrams
+// spoofed from another address or left over from an earlier connection are
+// dropped. A handshake never closes a live connection: a client restarted on
+// the same address gets in once its old connection times out.
+// Reliable datagrams are numbered, acknowledged by the receiver after each
+// Receive and resent until acknowledged; the receiver delivers them in order.
+// No more are in flight than the receiver buffers ahead of a gap, so one it
+// has no room for is never sent; later ones wait for acks to move the window.
+// Connections silent for TIMEOUT_MS are closed.
+//
+// IPv4 only. Unlike GNS there is no fragmentation, so a datagram is at most
+// MAX_PAYLOAD_BYTES; GNSSession splits larger messages before they get here.
+class UdpTransport : public ITransport {
+public:
+    static constexpr uint32_t PROTOCOL_ID = 0x4E544647;        // "NTFG"
+    static constexpr size_t MAX_DATAGRAM_BYTES = 8192;
+    static constexpr size_t DATA_HEADER_BYTES = 9;              // UDP_RELIABLE's, the larger data header
+    static constexpr size_t MAX_PAYLOAD_BYTES = MAX_DATAGRAM_BYTES - DATA_HEADER_BYTES;
+    static constexpr int RECV_BATCH = 32;
+    static constexpr int64_t CONNECT_RESEND_US = 100 * 1000;
+    static constexpr int64_t COOKIE_PERIOD_US = 5 * 1000 * 1000;   // A cookie is accepted for one to two periods
+    static constexpr size_t MAX_CONNECTIONS = 4096;
+    static constexpr int64_t KEEPALIVE_US = 1000 * 1000;
+    static constexpr int64_t TIMEOUT_MS = 10000;
+    static constexpr int64_t MIN_RTO_US = 30 * 1000;
+    static constexpr int64_t MAX_RTO_US = 1000 * 1000;
+    static constexpr uint32_t RECEIVE_WINDOW = 1024;           // Reliable datagrams buffered ahead of a gap
+    static constexpr uint32_t SEND_WINDOW = RECEIVE_WINDOW;     // Reliable datagrams in flight, oldest unacked first
+
+    UdpTransport()
+        : rng(std::random_device{}())
+    {
+        for (uint64_t& key : cookieKeys) {
+            key = (static_cast<uint64_t>(rng()) << 32) | rng();
+        }
+    }
+
+    ~UdpTransport() override {
+        Shutdown();
+    }
+
+    bool Init() override {
+        return true;
+    }
+
+    void Shutdown() override {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (fd < 0) {
+            return;
+        }
+
+        for (auto& [handle, conn] : connections) {
+            if (conn->state == TRANSPORT_CONNECTED) {
+                QueueControl(*conn, UDP_DISCONNECT);
+            }
+            ReleaseUnacked(*conn);
+        }
+        FlushOutgoing();
+
+        connections.clear();
+        byAddress.clear();
+        ::close(fd);
+        fd = -1;
+    }
+
+    bool Listen(uint16_t port) override {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (!OpenSocket(port)) {
+            return false;
+        }
+        listening = true;
+        Debug::Info("Udp") << "Server listening on port " << port << "\n";
+        return true;
+    }
+
+    ConnectionCode Connect(const std::string& host, uint16_t port, HSteamNetConnection& conn) override {
+        sockaddr_in addr{};
+        if (!Resolve(host, port, addr)) {
+            return CONN_PARSE_ERROR;
+        }
+
+        std::lock_guard<std::mutex> lk(mtx);
+        if (fd < 0 && !OpenSocket(0)) {
+            return CONN_SOCKETS_FAILED;
+        }
+
+        Connection& c = AddConnection(addr);
+        c.state = TRANSPORT_CONNECTING;
+        c.clientSalt = rng();
+        handshaking = true;
+        SendConnect(c, NowUs());
+        FlushOutgoing();
+
+        conn = c.handle;
+        return CONN_SUCCESS;
+    }
+
+    TransportState GetConnectionState(HSteamNetConnection conn) override {
+        std::lock_guard<std::mutex> lk(mtx);
+        Connection* c = Find(conn);
+        return c && !c->lingering ? c->state : TRANSPORT_INVALID;
+    }
+
+    void CloseConnection(HSteamNetConnection conn, bool linger) override {
+        std::lock_guard<std::mutex> lk(mtx);
+        Connection* c = Find(conn);
+        if (!c || c->lingering) {
+            return;
+        }
+
+        // Keep resending until the peer has everything, then say goodbye
+        if (linger && c->state == TRANSPORT_CONNECTED && !c->unacked.empty()) {
+            c->lingering = true;
+            return;
+        }
+
+        if (c->state == TRANSPORT_CONNECTED) {
+            QueueControl(*c, UDP_DISCONNECT);
+            FlushOutgoing();
+        }
+        Remove(*c);
+    }
+
+    void Send(const OutgoingDatagram* datagrams, int count) override {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (fd < 0) return;
+
+        int64_t now = NowUs();
+        for (int i = 0; i < count; i++) {
+            const OutgoingDatagram& out = datagrams[i];
+            Connection* c = Find(out.conn);
+            if (!c || c->lingering || c->state != TRANSPORT_CONNECTED) {
+                continue;
+            }
+            if (out.len > MAX_PAYLOAD_BYTES) {
+                Debug::Error("Udp") << "Dropping " << out.len << " byte datagram, limit is " << MAX_PAYLOAD_BYTES << "\n";
+                continue;
+            }
+
+            if (out.channel == CHANNEL_RELIABLE) {
+                Unacked u;
+                u.sequence = c->nextSendSequence++;
+                u.buffer = out.buffer;
+                u.offset = out.offset;
+                u.len = out.len;
+                out.buffer->AddRef();
+                c->unacked.push_back(u);
+
+                // Outside the window it goes out from Service once acks make room
+                if (InSendWindow(*c, c->unacked.back())) {
+                    SendFirst(*c, c->unacked.back(), now);
+                }
+            }
+            else {
+                QueueUnreliable(*c, out.buffer->Data() + out.offset, out.len);
+            }
+            c->lastSendUs = now;
+        }
+        FlushOutgoing();
+    }
+
+    int Receive(const DatagramHandler& handler, int maxDatagrams) override {
+        deliveries.clear();
+        reordered.clear();
+
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            if (fd < 0) return 0;
+
+            for (auto& [conn, bytes] : backlog) {
+                reordered.push_back(std::move(bytes));
+                deliveries.push_back(Delivery{ conn, reordered.back().data(), static_cast<int>(reordered.back().size()) });
+            }
+            backlog.clear();
+
+            int64_t now = NowUs();
+            ReceiveAndHandle(std::max(1, std::min(maxDatagrams, RECV_BATCH)), now);
+            Service(now);
+            FlushOutgoing();
+        }
+
+        // The handler runs unlocked, as it may send or close connections
+        int received = 0;
+        for (const Delivery& d : deliveries) {
+            if (GetConnectionState(d.conn) == TRANSPORT_INVALID) {
+                continue;
+            }
+            handler(d.data, d.len, d.conn);
+            received++;
+        }
+        return received;
+    }
+
+    // Resends, keepalives and timeouts. While a handshake is in flight this
+    // also reads the socket, as a connecting client only pumps callbacks;
+    // datagrams read meanwhile wait for the next Receive.
+    void RunCallbacks() override {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (fd < 0) return;
+
+        int64_t now = NowUs();
+        if (handshaking) {
+            deliveries.clear();
+            reordered.clear();
+            ReceiveAndHandle(RECV_BATCH, now);
+            for (const Delivery& d : deliveries) {
+                backlog.emplace_back(d.conn, std::vector<uint8_t>(d.data, d.data + d.len));
+            }
+            deliveries.clear();
+        }
+
+        Service(now);
+        FlushOutgoing();
+    }
+
+    // Blocks until the socket is readable. Wakes early while anything may
+    // need resending, as that is done by the receiving thread.
+    void Wait(int maxWaitMs) override {
+        int waitFd = -1;
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            waitFd = fd;
+            if (pendingTimers) {
+                maxWaitMs = std::min(maxWaitMs, static_cast<int>(MIN_RTO_US / 1000 / 3));
+            }
+        }
+
+        if (waitFd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(maxWaitMs));
+            return;
+        }
+
+        pollfd pfd{};
+        pfd.fd = waitFd;
+        pfd.events = POLLIN;
+        ::poll(&pfd, 1, maxWaitMs);
+    }
+
+private:
+    struct Unacked {
+        uint32_t sequence = 0;
+        MessageBuffer* buffer = nullptr;    // Referenced until acknowledged
+        size_t offset = 0;
+        size_t len = 0;
+        int64_t firstSentUs = 0;
+        int64_t lastSentUs = 0;
+        bool sent = false;                  // False while waiting outside the send window
+        bool resent = false;
+        bool acked = false;
+    };
+
+    struct Connection {
+        HSteamNetConnection handle = k_HSteamNetConnection_Invalid;
+        sockaddr_in addr{};
+        TransportState state = TRANSPORT_CONNECTING;
+        bool lingering = false;             // Closed by the app, still flushing reliable datagrams
+
+        uint32_t clientSalt = 0;
+        uint32_t serverSalt = 0;
+        uint32_t token = 0;
+        uint32_t cookie = 0;
+        bool challenged = false;            // Answering the server's CHALLENGE
+
+        int64_t lastReceiveUs = 0;
+        int64_t lastSendUs = 0;
+
+        // Reliable sending
+        uint32_t nextSendSequence = 0;
+        std::deque<Unacked> unacked;
+        int64_t srttUs = 100 * 1000;
+
+        // Reliable receiving
+        uint32_t nextReceiveSequence = 0;
+        std::map<uint32_t, std::vector<uint8_t>> outOfOrder;
+        bool ackPending = false;
+    };
+
+    // One datagram queued for sendmmsg: a header and optionally a payload
+    struct Outgoing {
+        sockaddr_in addr{};
+        uint8_t header[13] = {};            // Fits the largest, UDP_ACK
+        size_t headerLen = 0;
+        const uint8_t* payload = nullptr;
+        size_t payloadLen = 0;
+    };
+
+    struct Delivery {
+        HSteamNetConnection conn;
+        const uint8_t* data;
+        int len;
+    };
+
+    std::mutex mtx;
+    int fd = -1;
+    bool listening = false;
+    std::mt19937 rng;
+    uint64_t cookieKeys[2] = {};
+
+    std::unordered_map<HSteamNetConnection, std::unique_ptr<Connection>> connections;
+    std::unordered_map<uint64_t, HSteamNetConnection> byAddress;   // Open connections only
+    HSteamNetConnection nextHandle = 1;
+    bool pendingTimers = false;         // Some connection has a handshake or reliable datagram in flight
+    bool handshaking = false;           // Some connection is still connecting
+    std::vector<std::pair<HSteamNetConnection, std::vector<uint8_t>>> backlog;  // Read by RunCallbacks, not yet delivered
+
+    std::vector<Outgoing> outgoing;     // Guarded by mtx
+
+    // Only touched by the receiving thread
+    std::vector<std::vector<uint8_t>> recvSlots;
+    std::vector<mmsghdr> recvHeaders;
+    std::vector<iovec> recvIovecs;
+    std::vector<sockaddr_in> recvAddrs;
+    std::vector<Delivery> deliveries;
+    std::vector<std::vector<uint8_t>> reordered;    // Backing store for deliveries drained from outOfOrder
+
+    static int64_t NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static uint64_t AddressKey(const sockaddr_in& addr) {
+        return (static_cast<uint64_t>(addr.sin_addr.s_addr) << 16) | addr.sin_port;
+    }
+
+    static std::string ToString(const sockaddr_in& addr) {
+        char ip[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    static void Put32(uint8_t* p, uint32_t v) { std::memcpy(p, &v, 4); }
+    static uint32_t Get32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+    // splitmix64's finalizer
+    static uint64_t Mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Only a client that got the CHALLENGE sent to addr can echo this
+    uint32_t MakeCookie(const sockaddr_in& addr, uint32_t clientSalt, int64_t period) const {
+        uint64_t h = Mix(cookieKeys[0] ^ AddressKey(addr));
+        h = Mix(h ^ ((static_cast<uint64_t>(clientSalt) << 32) | static_cast<uint32_t>(period)));
+        return static_cast<uint32_t>(Mix(h ^ cookieKeys[1]));
+    }
+
+    // Sequence a comes after b, allowing for wraparound
+    static bool After(uint32_t a, uint32_t b) { return static_cast<int32_t>(a - b) > 0; }
+
+    static bool Resolve(const std::string& host, uint16_t port, sockaddr_in& addr) {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+            return false;
+        }
+        addr = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+        addr.sin_port = htons(port);
+        freeaddrinfo(result);
+        return true;
+    }
+
+    // Assumes mtx is held
+    bool OpenSocket(uint16_t port) {
+        if (fd >= 0) {
+            Debug::Error("Udp") << "Socket already open\n";
+            return false;
+        }
+
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            Debug::Error("Udp") << "socket() failed: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        // Room for a burst from every client between two receives
+        int bufferBytes = 4 * 1024 * 1024;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferBytes, sizeof(bufferBytes));
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &bufferBytes, sizeof(bufferBytes));
+
+        sockaddr_in local{};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_ANY);
+        local.sin_port = htons(port);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+            Debug::Error("Udp") << "bind() to port " << port << " failed: " << std::strerror(errno) << "\n";
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+
+        recvSlots.assign(RECV_BATCH, std::vector<uint8_t>(MAX_DATAGRAM_BYTES));
+        recvHeaders.assign(RECV_BATCH, mmsghdr{});
+        recvIovecs.assign(RECV_BATCH, iovec{});
+        recvAddrs.assign(RECV_BATCH, sockaddr_in{});
+        return true;
+    }
+
+    // Assumes mtx is held
+    Connection* Find(HSteamNetConnection conn) {
+        auto it = connections.find(conn);
+        return it == connections.end() ? nullptr : it->second.get();
+    }
+
+    // Assumes mtx is held
+    Connection* FindByAddress(const sockaddr_in& addr) {
+        auto it = byAddress.find(AddressKey(addr));
+        return it == byAddress.end() ? nullptr : Find(it->second);
+    }
+
+    // Assumes mtx is held
+    Connection& AddConnection(const sockaddr_in& addr) {
+        auto conn = std::make_unique<Connection>();
+        conn->handle = nextHandle++;
+        conn->addr = addr;
+        conn->lastReceiveUs = NowUs();
+        conn->lastSendUs = conn->lastReceiveUs;
+
+        Connection& c = *conn;
+        byAddress[AddressKey(addr)] = c.handle;
+        connections[c.handle] = std::move(conn);
+        return c;
+    }
+
+    // The handle stays valid, reporting TRANSPORT_CLOSED, until the app closes it
+    void MarkClosed(Connection& c) {
+        c.state = TRANSPORT_CLOSED;
+        ReleaseUnacked(c);
+        c.outOfOrder.clear();
+
+        auto it = byAddress.find(AddressKey(c.addr));
+        if (it != byAddress.end() && it->second == c.handle) {
+            byAddress.erase(it);
+        }
+    }
+
+    void Remove(Connection& c) {
+        MarkClosed(c);
+        connections.erase(c.handle);
+    }
+
+    void ReleaseUnacked(Connection& c) {
+        for (Unacked& u : c.unacked) {
+            u.buffer->Release();
+        }
+        c.unacked.clear();
+    }
+
+    // Assumes mtx is held
+    int ReceiveBatch(int batch) {
+        for (int i = 0; i < batch; i++) {
+            recvIovecs[i].iov_base = recvSlots[i].data();
+            recvIovecs[i].iov_len = recvSlots[i].size();
+            recvHeaders[i] = mmsghdr{};
+            recvHeaders[i].msg_hdr.msg_name = &recvAddrs[i];
+            recvHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            recvHeaders[i].msg_hdr.msg_iov = &recvIovecs[i];
+            recvHeaders[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = ::recvmmsg(fd, recvHeaders.data(), static_cast<unsigned int>(batch), MSG_DONTWAIT, nullptr);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Debug::Error("Udp") << "recvmmsg() failed: " << std::strerror(errno) << "\n";
+            }
+            return 0;
+        }
+        return n;
+    }
+
+    // Assumes mtx is held
+    void ReceiveAndHandle(int batch, int64_t now) {
+        int n = ReceiveBatch(batch);
+        for (int i = 0; i < n; i++) {
+            if (recvHeaders[i].msg_len == 0 || (recvHeaders[i].msg_hdr.msg_flags & MSG_TRUNC)) {
+                continue;
+            }
+            HandleDatagram(recvAddrs[i], recvSlots[i].data(), static_cast<int>(recvHeaders[i].msg_len), now);
+        }
+    }
+
+    // Assumes mtx is held
+    void HandleDatagram(const sockaddr_in& from, const uint8_t* data, int len, int64_t now) {
+        UdpPacketType type = static_cast<UdpPacketType>(data[0]);
+
+        if (type == UDP_CONNECT) {
+            HandleConnect(from, data, len, now);
+            return;
+        }
+        if (type == UDP_RESPONSE) {
+            HandleResponse(from, data, len, now);
+            return;
+        }
+
+        Connection* c = FindByAddress(from);
+        if (!c) {
+            return;
+        }
+
+        if (type == UDP_CHALLENGE) {
+            if (len < 9 || c->state != TRANSPORT_CONNECTING || Get32(data + 1) != c->clientSalt) {
+                return;
+            }
+            c->cookie = Get32(data + 5);
+            c->challenged = true;
+            SendConnect(*c, now);
+            return;
+        }
+
+        if (type == UDP_ACCEPT) {
+            if (len < 9 || c->state != TRANSPORT_CONNECTING || Get32(data + 1) != c->clientSalt) {
+                return;
+            }
+            c->serverSalt = Get32(data + 5);
+            c->token = c->clientSalt ^ c->serverSalt;
+            c->state = TRANSPORT_CONNECTED;
+            c->lastReceiveUs = now;
+            Debug::Info("Udp") << "Connected to " << ToString(from) << "\n";
+            return;
+        }
+
+        if (len < 5 || c->state != TRANSPORT_CONNECTED || Get32(data + 1) != c->token) {
+            return;
+        }
+        c->lastReceiveUs = now;
+
+        switch (type) {
+        case UDP_UNRELIABLE:
+            if (!c->lingering) {
+                deliveries.push_back(Delivery{ c->handle, data + 5, len - 5 });
+            }
+            break;
+
+        case UDP_RELIABLE:
+            if (len >= 9) {
+                HandleReliable(*c, Get32(data + 5), data + 9, len - 9);
+            }
+            break;
+
+        case UDP_ACK:
+            if (len >= 13) {
+                HandleAck(*c, Get32(data + 5), Get32(data + 9), now);
+            }
+            break;
+
+        case UDP_DISCONNECT:
+            Debug::Info("Udp") << "Connection closed by peer " << ToString(from) << "\n";
+            MarkClosed(*c);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Answered without keeping anything. Assumes mtx is held.
+    void HandleConnect(const sockaddr_in& from, const uint8_t* data, int len, int64_t now) {
+        // As long as the CHALLENGE it asks for, so it cannot be used to amplify traffic
+        if (!listening || len < 9 || Get32(data + 1) != PROTOCOL_ID) {
+            return;
+        }
+        uint32_t clientSalt = Get32(data + 5);
+
+        outgoing.emplace_back();
+        Outgoing& out = outgoing.back();
+        out.addr = from;
+        out.header[0] = UDP_CHALLENGE;
+        Put32(out.header + 1, clientSalt);
+        Put32(out.header + 5, MakeCookie(from, clientSalt, now / COOKIE_PERIOD_US));
+        out.headerLen = 9;
+    }
+
+    // Assumes mtx is held
+    void HandleResponse(const sockaddr_in& from, const uint8_t* data, int len, int64_t now) {
+        if (!listening || len < 13 || Get32(data + 1) != PROTOCOL_ID) {
+            return;
+        }
+        uint32_t clientSalt = Get32(data + 5);
+        uint32_t cookie = Get32(data + 9);
+        int64_t period = now / COOKIE_PERIOD_US;
+        if (cookie != MakeCookie(from, clientSalt, period) && cookie != MakeCookie(from, clientSalt, period - 1)) {
+            return;
+        }
+
+        // Anyone able to send from a client's address could otherwise close
+        // its connection; a restarted client waits for the old one to time out
+        Connection* c = FindByAddress(from);
+        if (c && c->clientSalt != clientSalt) {
+            return;
+        }
+
+        if (!c) {
+            if (byAddress.size() >= MAX_CONNECTIONS) {
+                return;
+            }
+            c = &AddConnection(from);
+            c->clientSalt = clientSalt;
+            c->serverSalt = rng();
+            c->token = c->clientSalt ^ c->serverSalt;
+            c->state = TRANSPORT_CONNECTED;
+            Debug::Info("Udp") << "Accepted connection from " << ToString(from) << "\n";
+        }
+
+        // Repeated RESPONSEs mean our ACCEPT was lost
+        c->lastReceiveUs = now;
+        Outgoing& out = QueueHeader(*c);
+        out.header[0] = UDP_ACCEPT;
+        Put32(out.header + 1, c->clientSalt);
+        Put32(out.header + 5, c->serverSalt);
+        out.headerLen = 9;
+    }
+
+    // Assumes mtx is held
+    void HandleReliable(Connection& c, uint32_t sequence, const uint8_t* payload, int len) {
+        c.ackPending = true;
+
+        if (sequence == c.nextReceiveSequence) {
+            if (!c.lingering) {
+                deliveries.push_back(Delivery{ c.handle, payload, len });
+            }
+            c.nextReceiveSequence++;
+
+            // Whatever was waiting on this one is now in order too
+            auto it = c.outOfOrder.begin();
+            while (it != c.outOfOrder.end() && it->first == c.nextReceiveSequence) {
+                reordered.push_back(std::move(it->second));
+                if (!c.lingering) {
+                    const std::vector<uint8_t>& bytes = reordered.back();
+                    deliveries.push_back(Delivery{ c.handle, bytes.data(), static_cast<int>(bytes.size()) });
+                }
+                c.nextReceiveSequence++;
+                it = c.outOfOrder.erase(it);
+            }
+        }
+        else if (After(sequence, c.nextReceiveSequence) && sequence - c.nextReceiveSequence < RECEIVE_WINDOW) {
+            c.outOfOrder.emplace(sequence, std::vector<uint8_t>(payload, payload + len));
+        }
+        // Otherwise a duplicate; the ack tells the sender to stop
+    }
+
+    // Assumes mtx is held
+    void HandleAck(Connection& c, uint32_t nextExpected, uint32_t mask, int64_t now) {
+        for (Unacked& u : c.unacked) {
+            bool acked = After(nextExpected, u.sequence);
+            if (!acked && After(u.sequence, nextExpected)) {
+                uint32_t bit = u.sequence - nextExpected - 1;
+                acked = bit < 32 && (mask & (1u << bit)) != 0;
+            }
+            if (acked && !u.acked) {
+                u.acked = true;
+                // Only first sends give an unambiguous round trip
+                if (!u.resent) {
+                    c.srttUs = (c.srttUs * 7 + (now - u.firstSentUs)) / 8;
+                }
+            }
+        }
+
+        while (!c.unacked.empty() && c.unacked.front().acked) {
+            c.unacked.front().buffer->Release();
+            c.unacked.pop_front();
+        }
+    }
+
+    // Resends, acks, keepalives and timeouts. Assumes mtx is held.
+    void Service(int64_t now) {
+        pendingTimers = false;
+        handshaking = false;
+
+        std::vector<HSteamNetConnection> finished;
+        for (auto& [handle, conn] : connections) {
+            Connection& c = *conn;
+            if (c.state == TRANSPORT_CLOSED) {
+                continue;
+            }
+
+            if (now - c.lastReceiveUs > TIMEOUT_MS * 1000) {
+                Debug::Info("Udp") << "Connection to " << ToString(c.addr) << " timed out\n";
+                if (c.lingering) {
+                    finished.push_back(handle);
+                }
+                MarkClosed(c);
+                continue;
+            }
+
+            if (c.state == TRANSPORT_CONNECTING) {
+                pendingTimers = true;
+                handshaking = true;
+                if (now - c.lastSendUs >= CONNECT_RESEND_US) {
+                    SendConnect(c, now);
+                }
+                continue;
+            }
+
+            if (c.ackPending) {
+                QueueAck(c);
+                c.ackPending = false;
+            }
+
+            int64_t rto = std::clamp<int64_t>(c.srttUs * 2, MIN_RTO_US, MAX_RTO_US);
+            for (Unacked& u : c.unacked) {
+                if (!InSendWindow(c, u)) {
+                    break;
+                }
+                if (!u.sent) {
+                    SendFirst(c, u, now);
+                }
+                else if (!u.acked && now - u.lastSentUs >= rto) {
+                    u.lastSentUs = now;
+                    u.resent = true;
+                    QueueData(c, u);
+                    c.lastSendUs = now;
+                }
+            }
+
+            if (!c.unacked.empty()) {
+                pendingTimers = true;
+            }
+            else if (c.lingering) {
+                QueueControl(c, UDP_DISCONNECT);
+                finished.push_back(handle);
+                continue;
+            }
+
+            if (now - c.lastSendUs >= KEEPALIVE_US) {
+                QueueControl(c, UDP_KEEPALIVE);
+                c.lastSendUs = now;
+            }
+        }
+
+        for (HSteamNetConnection handle : finished) {
+            Connection* c = Find(handle);
+            if (c) {
+                Remove(*c);
+            }
+        }
+    }
+
+    // Assumes mtx is held
+    Outgoing& QueueHeader(const Connection& c) {
+        outgoing.emplace_back();
+        outgoing.back().addr = c.addr;
+        return outgoing.back();
+    }
+
+    // Assumes mtx is held
+    void QueueControl(const Connection& c, UdpPacketType type) {
+        Outgoing& out = QueueHeader(c);
+        out.header[0] = type;
+        Put32(out.header + 1, c.token);
+        out.headerLen = 5;
+    }
+
+    // Cumulative ack plus which of the next 32 already arrived out of order.
+    // Assumes mtx is held.
+    void QueueAck(const Connection& c) {
+        uint32_t mask = 0;
+        for (const auto& [sequence, bytes] : c.outOfOrder) {
+            uint32_t bit = sequence - c.nextReceiveSequence - 1;
+            if (bit >= 32) break;
+            mask |= 1u << bit;
+        }
+
+        Outgoing& out = QueueHeader(c);
+        out.header[0] = UDP_ACK;
+        Put32(out.header + 1, c.token);
+        Put32(out.header + 5, c.nextReceiveSequence);
+        Put32(out.header + 9, mask);
+        out.headerLen = 13;
+    }
+
+    // CONNECT, or RESPONSE once challenged. Assumes mtx is held.
+    void SendConnect(Connection& c, int64_t now) {
+        Outgoing& out = QueueHeader(c);
+        out.header[0] = c.challenged ? UDP_RESPONSE : UDP_CONNECT;
+        Put32(out.header + 1, PROTOCOL_ID);
+        Put32(out.header + 5, c.clientSalt);
+        out.headerLen = 9;
+        if (c.challenged) {
+            Put32(out.header + 9, c.cookie);
+            out.headerLen = 13;
+        }
+        c.lastSendUs = now;
+    }
+
+    // Assumes mtx is held
+    void QueueUnreliable(const Connection& c, const uint8_t* payload, size_t len) {
+        Outgoing& out = QueueHeader(c);
+        out.header[0] = UDP_UNRELIABLE;
+        Put32(out.header + 1, c.token);
+        out.headerLen = 5;
+        out.payload = payload;
+        out.payloadLen = len;
+    }
+
+    // The receiver buffers RECEIVE_WINDOW datagrams past the first one it is
+    // missing, which is never older than the oldest unacked one
+    static bool InSendWindow(const Connection& c, const Unacked& u) {
+        return u.sequence - c.unacked.front().sequence < SEND_WINDOW;
+    }
+
+    // Assumes mtx is held
+    void SendFirst(Connection& c, Unacked& u, int64_t now) {
+        u.sent = true;
+        u.firstSentUs = now;
+        u.lastSentUs = now;
+        QueueData(c, u);
+        c.lastSendUs = now;
+    }
+
+    // Assumes mtx is held
+    void QueueData(const Connection& c, const Unacked& u) {
+        Outgoing& out = QueueHeader(c);
+        out.header[0] = UDP_RELIABLE;
+        Put32(out.header + 1, c.token);
+        Put32(out.header + 5, u.sequence);
+        out.headerLen = 9;
+        out.payload = u.buffer->Data() + u.offset;
+        out.payloadLen = u.len;
+    }
+
+    // Everything queued goes out in as few sendmmsg calls as the kernel
+    // accepts. Assumes mtx is held.
+    void FlushOutgoing() {
+        if (outgoing.empty() || fd < 0) {
+            outgoing.clear();
+            return;
+        }
+
+        std::vector<mmsghdr> headers(outgoing.size());
+        std::vector<iovec> iovecs(outgoing.size() * 2);
+        for (size_t i = 0; i < outgoing.size(); i++) {
+            Outgoing& out = outgoing[i];
+            iovec* iov = &iovecs[i * 2];
+            iov[0].iov_base = out.header;
+            iov[0].iov_len = out.headerLen;
+            iov[1].iov_base = const_cast<uint8_t*>(out.payload);
+            iov[1].iov_len = out.payloadLen;
+
+            headers[i].msg_hdr.msg_name = &out.addr;
+            headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            headers[i].msg_hdr.msg_iov = iov;
+            headers[i].msg_hdr.msg_iovlen = out.payloadLen > 0 ? 2 : 1;
+        }
+
+        size_t sent = 0;
+        while (sent < headers.size()) {
+            int n = ::sendmmsg(fd, headers.data() + sent, static_cast<unsigned int>(headers.size() - sent), 0);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                // Send buffer full: the rest is lost, reliable datagrams are resent later
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    Debug::Error("Udp") << "sendmmsg() failed: " << std::strerror(errno) << "\n";
+                }
+                break;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        outgoing.clear();
+    }
+};
+
+#endif // __linux__
+
+#endif // UDP_TRANSPORT_H
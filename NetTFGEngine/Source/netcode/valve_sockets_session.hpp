@@ -2,158 +2,98 @@
 #define GNS_SESSION_H
 
 #include "netcode_common.hpp"
-#include <GameNetworkingSockets/steam/steamnetworkingtypes.h>
-#include <GameNetworkingSockets/steam/steamnetworkingsockets.h>
+#include "packet_batcher.hpp"
+#include "packet_schema.hpp"
+#include "transport.hpp"
+#include "gns_transport.hpp"
 #include <queue>
+#include <memory>
 #include <functional>
+#include <atomic>
+#include <mutex>
 #include "Utils/Debug/Debug.hpp"
 
-enum ConnectionCode : uint8_t {
-	CONN_SUCCESS = 0,
-	CONN_SOCKETS_FAILED = 1,
-	CONN_PARSE_ERROR = 2,
-	CONN_TIMEOUT = 3,
-	CONN_DENIED = 4
+// How a receive loop waits once Poll comes back empty. It first polls again
+// without waiting for spinRounds rounds, to catch packets that arrive back to
+// back, then blocks in the transport until a datagram arrives or maxBlockMs passes.
+// maxBlockMs only bounds how late the loop notices work that is not a packet,
+// such as a shutdown request.
+struct NetworkWaitConfig {
+    int spinRounds = 16;
+    int maxBlockMs = 10;
 };
 
-std::ostream& operator<<(std::ostream& os, ConnectionCode code) {
-    switch (code) {
-    case CONN_SUCCESS: return os << "CONN_SUCCESS";
-    case CONN_SOCKETS_FAILED: return os << "CONN_SOCKETS_FAILED";
-    case CONN_PARSE_ERROR: return os << "CONN_PARSE_ERROR";
-    case CONN_TIMEOUT: return os << "CONN_TIMEOUT";
-    case CONN_DENIED: return os << "CONN_DENIED";
-    default: return os << "UNKNOWN(" << static_cast<int>(code) << ")";
-    }
-}
-
+// Packet layer of the netcode: encodes, batches and decodes every packet and
+// hands whole datagrams to an ITransport, GameNetworkingSockets unless another
+// transport is set before InitGNS.
 class GNSSession {
 public:
-    enum ConnectionEventType {
-        CONNECTION_STATE_CONNECTING = 0,
-        CONNECTION_STATE_CONNECTED = 1,
-        CONNECTION_STATE_CLOSED_BY_PEER = 2,
-        CONNECTION_STATE_PROBLEM_DETECTED = 3,
-        CONNECTION_STATE_NONE = 4
-    };
-
-    using ConnectionCallback = std::function<void(HSteamNetConnection, ConnectionEventType)>;
-
-    GNSSession()
-        : sockets(nullptr),
-        listenSocket(k_HSteamListenSocket_Invalid),
-        pollGroup(k_HSteamNetPollGroup_Invalid),
-        connectedConnection(k_HSteamNetConnection_Invalid),
-        isServer(false),
-        onConnectionStateChanged(nullptr) {
-    }
+    GNSSession() = default;
 
     ~GNSSession() {
         Shutdown();
     }
 
-    bool InitGNS() {
-        if (socketsInitialized) {
-            Debug::Info("Sockets") << "GameNetworkingSockets already initialized\n";
-            return true;
-        }
+    // Replaces the default GNS transport. Call before InitGNS.
+    void SetTransport(std::shared_ptr<ITransport> t) {
+        transport = std::move(t);
+    }
 
-        SteamNetworkingErrMsg errMsg;
-        if (!GameNetworkingSockets_Init(nullptr, errMsg)) {
-            Debug::Error("Sockets") << "GameNetworkingSockets initialization failed: " << errMsg << "\n";
-            return false;
-        }
+    std::shared_ptr<ITransport> GetTransport() const { return transport; }
 
-        socketsInitialized = true;  // mark static flag
-        sockets = SteamNetworkingSockets();
-        if (!sockets) {
-            Debug::Error("Sockets") << "Failed to get SteamNetworkingSockets interface\n";
-            return false;
+    bool InitGNS() {
+        if (!transport) {
+            transport = std::make_shared<GnsTransport>();
         }
-
-        return true;
+        return transport->Init();
     }
 
-    void SetConnectionStateCallback(ConnectionCallback cb) {
-        onConnectionStateChanged = cb;
+    // Makes this session a view of host's listen socket and poll group with
+    // its own batcher and frame reference, so several matches can send through
+    // one socket while each resolves wrapped frames against its own clock. The
+    // host keeps ownership of the transport and does all the receiving.
+    void AttachTo(GNSSession& host) {
+        transport = host.transport;
+        isServer = host.isServer;
+        waitConfig = host.waitConfig;
+        ownsTransport = false;
     }
 
     bool InitHost(uint16_t port) {
-        if (!sockets) {
-            Debug::Error("Sockets") << "GNS not initialized\n";
-            return false;
-        }
-
-        SteamNetworkingIPAddr serverAddr;
-        serverAddr.Clear();
-        serverAddr.m_port = port;
-
-        // Set up callback for connection state changes
-        SteamNetworkingConfigValue_t opt;
-        opt.SetPtr(k_ESteamNetworkingConfig_Callback_ConnectionStatusChanged,
-            (void*)SteamNetConnectionStatusChangedCallback);
-
-        listenSocket = sockets->CreateListenSocketIP(serverAddr, 1, &opt);
-        if (listenSocket == k_HSteamListenSocket_Invalid) {
-            Debug::Error("Sockets") << "Failed to create listen socket on port " << port << "\n";
-            return false;
-        }
-
-        pollGroup = sockets->CreatePollGroup();
-        if (pollGroup == k_HSteamNetPollGroup_Invalid) {
-            Debug::Error("Sockets") << "Failed to create poll group\n";
+        if (!transport || !transport->Listen(port)) {
             return false;
         }
 
-        // Store this instance for the static callback
-        s_pInstance = this;
-
         isServer = true;
-        Debug::Info("Sockets") << "Server listening on port " << port << "\n";
         return true;
     }
 
     ConnectionCode ConnectTo(const std::string& hostStr, uint16_t port)
     {
-        if (!sockets)
+        if (!transport)
             return CONN_SOCKETS_FAILED;
 
-        SteamNetworkingIPAddr serverAddr;
-        serverAddr.Clear();
-        if (!serverAddr.ParseString(hostStr.c_str()))
-            return CONN_PARSE_ERROR;
-
-        serverAddr.m_port = port;
-
-        SteamNetworkingConfigValue_t opt;
-        opt.SetInt32(k_ESteamNetworkingConfig_TimeoutInitial, 10000);
-
-        HSteamNetConnection conn =
-            sockets->ConnectByIPAddress(serverAddr, 1, &opt);
+        HSteamNetConnection conn = k_HSteamNetConnection_Invalid;
+        ConnectionCode code = transport->Connect(hostStr, port, conn);
+        if (code != CONN_SUCCESS)
+            return code;
 
-        if (conn == k_HSteamNetConnection_Invalid)
-            return CONN_SOCKETS_FAILED;
-
-        const uint64 start = SteamNetworkingUtils()->GetLocalTimestamp();
-        const uint64 timeoutUS = 10 * 1000 * 1000; // 10 seconds
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
 
         while (true)
         {
             // REQUIRED: pump callbacks
 			PumpCallbacks();
 
-            SteamNetConnectionInfo_t info;
-            sockets->GetConnectionInfo(conn, &info);
-
-            switch (info.m_eState)
+            switch (transport->GetConnectionState(conn))
             {
-            case k_ESteamNetworkingConnectionState_Connected:
+            case TRANSPORT_CONNECTED:
                 connectedConnection = conn;
                 return CONN_SUCCESS;
 
-            case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
-            case k_ESteamNetworkingConnectionState_ClosedByPeer:
-                sockets->CloseConnection(conn, 0, nullptr, false);
+            case TRANSPORT_CLOSED:
+            case TRANSPORT_INVALID:
+                transport->CloseConnection(conn, false);
                 return CONN_TIMEOUT;
 
             default:
@@ -161,492 +101,448 @@ public:
             }
 
             // User-level timeout safety net
-            if (SteamNetworkingUtils()->GetLocalTimestamp() - start > timeoutUS)
+            if (std::chrono::steady_clock::now() > timeout)
             {
-                sockets->CloseConnection(conn, 0, "User timeout", false);
+                transport->CloseConnection(conn, false);
                 return CONN_TIMEOUT;
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            WaitForTraffic(10);
         }
     }
 
 
     void PumpCallbacks() {
-        if (sockets) {
-            sockets->RunCallbacks();
+        if (transport) {
+            transport->RunCallbacks();
         }
     }
 
-    void Poll(const std::function<void(const uint8_t*, int, HSteamNetConnection)>& handler, bool fetchOnlyOne) {
-        if (!sockets) return;
+    // Hands every received packet to handler and returns the number of
+    // datagrams taken from the transport. Fragmented packets are handed over
+    // once all their fragments are in.
+    int Poll(const std::function<void(const uint8_t*, int, HSteamNetConnection)>& handler, bool fetchOnlyOne) {
+        if (!transport) return 0;
+
+        return transport->Receive([&](const uint8_t* data, int len, HSteamNetConnection conn) {
+            bytesReceived.fetch_add(static_cast<uint64_t>(len));
+            auto deliver = [&](const uint8_t* message, int messageLen) {
+                handler(message, messageLen, conn);
+                };
+            if (len > 0 && data[0] == PACKET_FRAGMENT) {
+                fragments.Add(conn, data, len, deliver);
+                return;
+            }
+            PacketBatcher::Unpack(data, len, deliver);
+            }, fetchOnlyOne ? 1 : 64);
+    }
 
-        ISteamNetworkingMessage* pMsgs[64];
-        int numMsgs;
-		int messagesToFetch = fetchOnlyOne ? 1 : 64;
+    void SetWaitConfig(const NetworkWaitConfig& config) {
+        waitConfig = config;
+    }
 
-        if (isServer && pollGroup != k_HSteamNetPollGroup_Invalid) {
-            numMsgs = sockets->ReceiveMessagesOnPollGroup(pollGroup, pMsgs, messagesToFetch);
-        }
-        else if (!isServer && connectedConnection != k_HSteamNetConnection_Invalid) {
-            numMsgs = sockets->ReceiveMessagesOnConnection(connectedConnection, pMsgs, messagesToFetch);
+    // Services the transport, blocking until a datagram arrives or maxWaitMs passes
+    void WaitForTraffic(int maxWaitMs) {
+        if (transport) {
+            transport->Wait(maxWaitMs);
         }
-
-        for (int i = 0; i < numMsgs; i++) {
-            handler(static_cast<const uint8_t*>(pMsgs[i]->m_pData),
-                pMsgs[i]->m_cbSize, pMsgs[i]->m_conn);
-            pMsgs[i]->Release();
+        else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(maxWaitMs));
         }
     }
 
-    void SendInput(HSteamNetConnection conn, int playerId, int frame, const InputBlob& input) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
+    // Called by a receive loop after each Poll with what it returned: returns
+    // at once while traffic flows, spins briefly once it stops, then blocks
+    void WaitAfterPoll(int received) {
+        if (received > 0) {
+            idleRounds = 0;
+            return;
+        }
 
-        uint8_t buf[1 + 4 + 4 + sizeof(InputBlob)];
-        buf[0] = PACKET_INPUT;
-        uint32_t pid = hostToBigEndian32(playerId);
-        std::memcpy(buf + 1, &pid, sizeof(uint32_t));
-        uint32_t f = hostToBigEndian32(frame);
-        std::memcpy(buf + 5, &f, sizeof(uint32_t));
-        std::memcpy(buf + 9, input.data, sizeof(InputBlob));
+        if (idleRounds < waitConfig.spinRounds) {
+            idleRounds++;
+            WaitForTraffic(0);
+            return;
+        }
 
-        sockets->SendMessageToConnection(conn, buf, sizeof(buf), k_nSteamNetworkingSend_Reliable, nullptr);
+        WaitForTraffic(waitConfig.maxBlockMs);
     }
 
-    void SendInputUpdate(HSteamNetConnection conn, int playerId, int frame, const InputBlob& input) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
-
-        uint8_t buf[1 + 4 + 4 + sizeof(InputBlob)];
-        buf[0] = PACKET_INPUT_UPDATE;
-        uint32_t pid = hostToBigEndian32(playerId);
-        std::memcpy(buf + 1, &pid, sizeof(uint32_t));
-        uint32_t f = hostToBigEndian32(frame);
-        std::memcpy(buf + 5, &f, sizeof(uint32_t));
-        std::memcpy(buf + 9, input.data, sizeof(InputBlob));
-
-        sockets->SendMessageToConnection(conn, buf, sizeof(buf), k_nSteamNetworkingSend_Reliable, nullptr);
+    // Frame the wrapped 16-bit frame numbers in incoming packets are resolved
+    // against. Owners keep it near their current frame.
+    void SetFrameReference(int frame) {
+        frameReference.store(frame);
     }
 
-    void SendInputDelaySync(HSteamNetConnection conn, InputDelayPacket InpDel_packet) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
-
-        uint8_t buf[1 + sizeof(InputDelayPacket)];
-        uint8_t offset = 0;
-
-        buf[0] = PACKET_INPUT_DELAY;
-        offset += 1;
+    // Carries every input the server has not acked yet, each one delta-encoded
+    // against the previous, so a lost packet is covered by the next one.
+    void SendInputWindow(HSteamNetConnection conn, int playerId, const std::deque<InputEntry>& inputs) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid || inputs.empty()) return;
 
-        uint32_t pid = hostToBigEndian32(InpDel_packet.playerId);
-        std::memcpy(buf + offset, &pid, sizeof(uint32_t));
-        offset += sizeof(uint32_t);
-
-        uint32_t timeSend = hostToBigEndian32(InpDel_packet.timestamp);
-        std::memcpy(buf + offset, &timeSend, sizeof(uint32_t));
-        offset += sizeof(uint32_t);
+        InputWindowPacket packet;
+        packet.playerId = playerId;
 
+        // Newest inputs first, stopping where frames would not keep increasing
+        size_t first = inputs.size() - std::min(inputs.size(), static_cast<size_t>(INPUT_WINDOW_SIZE));
+        for (size_t i = first; i < inputs.size(); i++) {
+            if (packet.count > 0 && inputs[i].frame <= packet.inputs[packet.count - 1].frame) {
+                packet.count = 0;
+            }
+            packet.inputs[packet.count++] = inputs[i];
+        }
 
-        sockets->SendMessageToConnection(conn, buf, sizeof(buf), k_nSteamNetworkingSend_Reliable, nullptr);
+        SendSchemaPacket(conn, PACKET_INPUT, packet, CHANNEL_UNRELIABLE);
     }
 
-    InputDelayPacket ParseInputDelaySync(const uint8_t* buf, size_t len) {
-
-        InputDelayPacket packet;
-
-        size_t offset = 0;
-
-        offset += 1;
-
-        uint32_t f = 0;
-
-        uint32_t pid = 0;
-        std::memcpy(&f, buf + offset, 4);
-        packet.playerId = bigEndianToHost32(f);
-        offset += sizeof(uint32_t);
-
-        uint32_t timeSend = 0;
-        std::memcpy(&f, buf + offset, 4);
-        packet.timestamp = bigEndianToHost32(f);
-        offset += sizeof(uint32_t);
+    bool ParseInputWindow(const uint8_t* buf, size_t len, int& playerId, std::vector<InputEntry>& inputs) {
+        inputs.clear();
 
+        InputWindowPacket packet;
+        if (!ReadSchemaPacket(buf, len, packet)) return false;
 
-
-        return packet;
+        playerId = packet.playerId;
+        inputs.assign(packet.inputs, packet.inputs + packet.count);
+        return true;
     }
 
-    inline InputEntry ParseInputEntryPacket(const uint8_t* buf, size_t len) {
-        InputEntry entry;
-        size_t offset = 0;
+    void SendInputUpdate(HSteamNetConnection conn, int playerId, int frame, const InputBlob& input) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
 
-        offset += 1;
+        InputEntry entry{ frame, input, playerId };
+        SendSchemaPacket(conn, PACKET_INPUT_UPDATE, entry, CHANNEL_UNRELIABLE);
+    }
 
-        uint32_t pid = 0;
-        std::memcpy(&pid, buf + offset, sizeof(uint32_t));
-        entry.playerId = bigEndianToHost32(pid);
-        offset += sizeof(uint32_t);
+    bool ParseInputUpdate(const uint8_t* buf, size_t len, InputEntry& entry) {
+        return ReadSchemaPacket(buf, len, entry);
+    }
 
-        uint32_t f = 0;
-        std::memcpy(&f, buf + offset, sizeof(uint32_t));
-        entry.frame = bigEndianToHost32(f);
-        offset += sizeof(uint32_t);
+    void SendInputDelaySync(HSteamNetConnection conn, InputDelayPacket InpDel_packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
 
-        std::memcpy(entry.input.data, buf + offset, sizeof(InputBlob));
+        // RTT probes must not be retransmitted or held until the next flush,
+        // or the measurement includes that delay
+        SendSchemaPacketNow(conn, PACKET_INPUT_DELAY, InpDel_packet, CHANNEL_UNRELIABLE);
+    }
 
-        return entry;
+    bool ParseInputDelaySync(const uint8_t* buf, size_t len, InputDelayPacket& packet) {
+        return ReadSchemaPacket(buf, len, packet);
     }
 
 	void SendEventUpdate(HSteamNetConnection conn, const EventEntry& event) {
-		if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
-		size_t bufSize = 1 + 4 + 4 + 4 + event.event.len;
-		std::vector<uint8_t> buf(bufSize);
-		size_t offset = 0;
-		buf[offset++] = PACKET_EVENT_UPDATE;
-		uint32_t f = hostToBigEndian32(event.frame);
-		std::memcpy(&buf[offset], &f, 4);
-		offset += 4;
-
-		uint32_t eventType = hostToBigEndian32(event.event.type);
-		std::memcpy(&buf[offset], &eventType, 4);
-		offset += 4;
-
-		uint32_t eventLen = hostToBigEndian32(event.event.len);
-		std::memcpy(&buf[offset], &eventLen, 4);
-		offset += 4;
-		std::memcpy(&buf[offset], event.event.data, event.event.len);
-		offset += event.event.len;
-		sockets->SendMessageToConnection(conn, buf.data(), buf.size(), k_nSteamNetworkingSend_Reliable, nullptr);
+		if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+		SendSchemaPacket(conn, PACKET_EVENT_UPDATE, event, CHANNEL_RELIABLE);
 	}
 
-	EventEntry ParseEventEntryPacket(const uint8_t* buf, size_t len) {
-		EventEntry eventEntry;
-		size_t offset = 0;
-		offset += 1;
-		uint32_t f = 0;
-		std::memcpy(&f, buf + offset, 4);
-		eventEntry.frame = bigEndianToHost32(f);
-		offset += 4;
-
-		uint32_t eventType = 0;
-		std::memcpy(&eventType, buf + offset, 4);
-		eventEntry.event.type = bigEndianToHost32(eventType);
-		offset += 4;
-
-		uint32_t eventLen = 0;
-		std::memcpy(&eventLen, buf + offset, 4);
-		eventLen = bigEndianToHost32(eventLen);
-		offset += 4;
-		eventEntry.event.len = eventLen;
-		std::memcpy(eventEntry.event.data, buf + offset, eventLen);
-		offset += eventLen;
-		return eventEntry;
+	// Encodes the event once and queues the same bytes for every connection
+	void BroadcastEventUpdate(const std::vector<HSteamNetConnection>& conns, const EventEntry& event) {
+		SendShared(conns, PACKET_EVENT_UPDATE, event, CHANNEL_RELIABLE);
 	}
 
-    void SendStateUpdate(HSteamNetConnection conn, const StateUpdate& update) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
+	bool ParseEventUpdate(const uint8_t* buf, size_t len, EventEntry& event) {
+		return ReadSchemaPacket(buf, len, event);
+	}
 
-        size_t bufSize = 1 + 4 + 4 + update.state.len;
+    void SendStateUpdate(HSteamNetConnection conn, const StateUpdate& update) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
 
-        std::vector<uint8_t> buf(bufSize);
-        size_t offset = 0;
+        // Full states are the recovery path for lost deltas, so they stay reliable
+        SendSchemaPacket(conn, PACKET_STATE_UPDATE, update, CHANNEL_RELIABLE);
+    }
 
-        buf[offset++] = PACKET_STATE_UPDATE;
+    bool ParseStateUpdate(const uint8_t* buf, size_t len, StateUpdate& update) {
+        return ReadSchemaPacket(buf, len, update);
+    }
 
-        uint32_t f = hostToBigEndian32(update.frame);
-        std::memcpy(&buf[offset], &f, 4);
-        offset += 4;
+    // False if the deltas need more than MAX_DELTA_PARTS packets; nothing is
+    // sent then
+    bool SendDeltasUpdate(HSteamNetConnection conn, const DeltasUpdatePacket& packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return true;
+        return SendDeltaParts({ conn }, packet);
+    }
 
-        uint32_t stateLen = hostToBigEndian32(update.state.len);
-        std::memcpy(&buf[offset], &stateLen, 4);
-        offset += 4;
+    // Every client gets the same deltas, so they are encoded only once
+    bool BroadcastDeltasUpdate(const std::vector<HSteamNetConnection>& conns, const DeltasUpdatePacket& packet) {
+        return SendDeltaParts(conns, packet);
+    }
 
-        std::memcpy(&buf[offset], update.state.data, update.state.len);
-        offset += update.state.len;
+    bool ParseDeltasUpdate(const uint8_t* buf, size_t len, DeltasUpdatePacket& packet) {
+        if (!ReadSchemaPacket(buf, len, packet)) {
+            packet.deltas.clear();
+            return false;
+        }
+        return true;
+    }
 
-        sockets->SendMessageToConnection(conn, buf.data(), buf.size(), k_nSteamNetworkingSend_Reliable, nullptr);
+    void SendHashPacket(HSteamNetConnection conn, const HashPacket& packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+		SendSchemaPacket(conn, PACKET_HASH, packet, CHANNEL_UNRELIABLE);
     }
 
-    StateUpdate ParseStateUpdate(const uint8_t* buf, size_t len) {
-        StateUpdate update;
-        size_t offset = 0;
+	bool ParseHashPacket(const uint8_t* buf, size_t len, HashPacket& packet) {
+		return ReadSchemaPacket(buf, len, packet);
+	}
 
-        offset += 1;
+    // Asks a client that failed a hash check for the section hashes of its
+    // latest server state. Repairs are rare and must not be lost, so the
+    // whole exchange is reliable.
+    void SendHashTreeRequest(HSteamNetConnection conn, int frame) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
 
-        uint32_t f = 0;
-        std::memcpy(&f, buf + offset, 4);
-        update.frame = bigEndianToHost32(f);
-        offset += 4;
+        FrameAckPacket packet;
+        packet.frame = frame;
+        SendSchemaPacket(conn, PACKET_HASH_TREE_REQUEST, packet, CHANNEL_RELIABLE);
+    }
 
-        uint32_t stateLen = 0;
-        std::memcpy(&stateLen, buf + offset, 4);
-        stateLen = bigEndianToHost32(stateLen);
-        offset += 4;
-        update.state.len = stateLen;
+    bool ParseHashTreeRequest(const uint8_t* buf, size_t len, int& frame) {
+        return ParseFrameAck(buf, len, frame);
+    }
 
-        std::memcpy(update.state.data, buf + offset, stateLen);
-        offset += stateLen;
+    void SendHashTree(HSteamNetConnection conn, const HashTreePacket& packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+        SendSchemaPacket(conn, PACKET_HASH_TREE, packet, CHANNEL_RELIABLE);
+    }
 
-        return update;
+    bool ParseHashTree(const uint8_t* buf, size_t len, HashTreePacket& packet) {
+        return ReadSchemaPacket(buf, len, packet);
     }
 
-    // type(1) + frame(4) + num of deltas(4) + N * delta
-    void SendDeltasUpdate(HSteamNetConnection conn, const std::vector<DeltaStateBlob>& deltas, const int frame) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
+    void SendStateRepair(HSteamNetConnection conn, const StateRepairPacket& packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+        SendSchemaPacket(conn, PACKET_STATE_REPAIR, packet, CHANNEL_RELIABLE);
+    }
 
-        size_t bufSize = 1 + 4 + 4;
+    bool ParseStateRepair(const uint8_t* buf, size_t len, StateRepairPacket& packet) {
+        return ReadSchemaPacket(buf, len, packet);
+    }
 
-        for (const DeltaStateBlob& delta : deltas) {
-            bufSize += 4;         // delta_type
-            bufSize += 4;         // delta.len
-            bufSize += delta.len; // delta payload
-        }
+    void BroadcastGameStart(HSteamNetConnection conn, int playerId, int ticksPerSecond) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
 
-        std::vector<uint8_t> buf(bufSize);
+        GameStartPacket packet;
+        packet.playerId = playerId;
+        packet.ticksPerSecond = ticksPerSecond;
+        SendSchemaPacket(conn, PACKET_GAME_START, packet, CHANNEL_RELIABLE);
+    }
 
-        size_t offset = 0;
+    bool ParseGameStart(const uint8_t* buf, size_t len, GameStartPacket& packet) {
+        return ReadSchemaPacket(buf, len, packet);
+    }
 
-        buf[offset++] = PACKET_DELTA_STATE_UPDATE;
+    // Latest server frame applied by the client
+    void SendStateAck(HSteamNetConnection conn, int frame) {
+        SendFrameAck(conn, PACKET_STATE_ACK, frame);
+    }
 
-        uint32_t f = hostToBigEndian32(frame);
-        std::memcpy(&buf[offset], &f, 4);
-        offset += 4;
+    // Every client input up to this frame has been received
+    void SendInputAck(HSteamNetConnection conn, const InputAckPacket& packet) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+        SendSchemaPacket(conn, PACKET_INPUT_ACK, packet, CHANNEL_UNRELIABLE);
+    }
 
-        uint32_t numDeltas = hostToBigEndian32(deltas.size());
-        std::memcpy(&buf[offset], &numDeltas, 4);
-        offset += 4;
+    bool ParseInputAck(const uint8_t* buf, size_t len, InputAckPacket& packet) {
+        return ReadSchemaPacket(buf, len, packet);
+    }
 
-        for (const DeltaStateBlob& delta : deltas) 
-        {
-            uint32_t type = hostToBigEndian32(delta.delta_type);
-            std::memcpy(&buf[offset], &type, 4);
-            offset += 4;
+    bool ParseFrameAck(const uint8_t* buf, size_t len, int& frame) {
+        FrameAckPacket packet;
+        if (!ReadSchemaPacket(buf, len, packet)) return false;
+        frame = packet.frame;
+        return true;
+    }
 
-            uint32_t deltaLen = hostToBigEndian32(delta.len);
-            std::memcpy(&buf[offset], &deltaLen, 4);
-            offset += 4;
+    // Handshake packets go out at once; nothing flushes before the game starts
+    void SendClientHello(HSteamNetConnection conn, const ClientHelloPacket& hello) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+        SendSchemaPacketNow(conn, PACKET_CLIENT_HELLO, hello, CHANNEL_RELIABLE);
+    }
 
-            std::memcpy(&buf[offset], delta.data, delta.len);
-            offset += delta.len;
-        }
+    bool ParseClientHello(const uint8_t* buf, size_t len, ClientHelloPacket& hello) {
+        return ReadSchemaPacket(buf, len, hello);
+    }
 
-        sockets->SendMessageToConnection(conn, buf.data(), buf.size(), k_nSteamNetworkingSend_Reliable, nullptr);
+    void SendServerAccept(HSteamNetConnection conn, const ServerAcceptPacket& accept) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+        SendSchemaPacketNow(conn, PACKET_SERVER_ACCEPT, accept, CHANNEL_RELIABLE);
     }
 
-    void ParseDeltasUpdate(const uint8_t* buf, size_t len, std::vector<DeltaStateBlob>& deltas, int& frame)
-    {
-        deltas.clear();
-        size_t offset = 0;
+    bool ParseServerAccept(const uint8_t* buf, size_t len, ServerAcceptPacket& accept) {
+        return ReadSchemaPacket(buf, len, accept);
+    }
 
-        // 1) Read packet type
-        if (offset + 1 > len) return;
-        uint8_t packetType = buf[offset++];
-        if (packetType != PACKET_DELTA_STATE_UPDATE)
-            return;
+    // Sends everything queued by the Send* calls since the last flush. Called
+    // once per tick so each connection gets one datagram per channel.
+    void FlushOutgoing() {
+        bytesSent.fetch_add(batcher.Flush(transport.get()));
+    }
 
-        // 2) Read first frame
-        if (offset + 4 > len) return;
-        uint32_t frameBE;
-        std::memcpy(&frameBE, &buf[offset], 4);
-        offset += 4;
-        frame = bigEndianToHost32(frameBE);
+    // Payload bytes handed to and received from the transport since the session started
+    uint64_t GetBytesSent() const { return bytesSent.load(); }
+    uint64_t GetBytesReceived() const { return bytesReceived.load(); }
 
-        // 3) Read number of deltas
-        if (offset + 4 > len) return;
-        uint32_t numDeltasBE;
-        std::memcpy(&numDeltasBE, &buf[offset], 4);
-        offset += 4;
-        uint32_t numDeltas = bigEndianToHost32(numDeltasBE);
+    TransportState GetConnectionState(HSteamNetConnection conn) {
+        return transport ? transport->GetConnectionState(conn) : TRANSPORT_INVALID;
+    }
 
-        deltas.reserve(numDeltas);
+    // Open connections are connecting or connected
+    bool IsConnectionOpen(HSteamNetConnection conn) {
+        TransportState state = GetConnectionState(conn);
+        return state == TRANSPORT_CONNECTING || state == TRANSPORT_CONNECTED;
+    }
 
-        // 4) Read each delta
-        for (uint32_t i = 0; i < numDeltas; i++)
-        {
-            DeltaStateBlob d{};
-
-            d.frame = frame;
-
-            // delta_type
-            if (offset + 4 > len) return;
-            uint32_t typeBE;
-            std::memcpy(&typeBE, &buf[offset], 4);
-            offset += 4;
-            d.delta_type = bigEndianToHost32(typeBE);
-
-            // delta_len
-            if (offset + 4 > len) return;
-            uint32_t deltaLenBE;
-            std::memcpy(&deltaLenBE, &buf[offset], 4);
-            offset += 4;
-            d.len = bigEndianToHost32(deltaLenBE);
-
-            // data pointer allocation
-            if (offset + d.len > len) return;
-            std::memcpy(d.data, &buf[offset], d.len);
-            offset += d.len;
-
-            deltas.push_back(d);
+    void CloseConnection(HSteamNetConnection conn, bool linger = false) {
+        if (transport && conn != k_HSteamNetConnection_Invalid) {
+            transport->CloseConnection(conn, linger);
         }
     }
 
-    void SendHashPacket(HSteamNetConnection conn, const HashPacket packet, const int frame) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
-
-		uint8_t buf[1 + 4 + SHA256_DIGEST_LENGTH];
+    HSteamNetConnection GetConnectedConnection() { return connectedConnection; }
 
-		buf[0] = PACKET_HASH;
-		uint32_t f = hostToBigEndian32(frame);
-		std::memcpy(buf + 1, &f, sizeof(uint32_t));
-		std::memcpy(buf + 5, packet.hash, SHA256_DIGEST_LENGTH);
-		sockets->SendMessageToConnection(conn, buf, sizeof(buf), k_nSteamNetworkingSend_Reliable, nullptr);
+private:
+    // Size of a packet: the type byte plus its schema. The packet is only read.
+    template<typename Packet>
+    static size_t MeasureSchemaPacket(const Packet& packet) {
+        MeasureStream stream;
+        if (!Serialize(stream, const_cast<Packet&>(packet))) return 0;
+        return 1 + stream.BytesUsed();
     }
 
-	HashPacket ParseHashPacket(const uint8_t* buf, size_t len) {
-		HashPacket packet;
+    template<typename Packet>
+    static bool WriteSchemaPacket(uint8_t* buf, size_t len, uint8_t type, const Packet& packet) {
+        buf[0] = type;
+        WriteStream stream(buf + 1, len - 1);
+        bool ok = Serialize(stream, const_cast<Packet&>(packet));
+        stream.Flush();
+        return ok;
+    }
 
-		size_t offset = 0;
-		offset += 1;
-		uint32_t f = 0;
-		std::memcpy(&f, buf + offset, 4);
-		packet.frame = bigEndianToHost32(f);
-		offset += 4;
-		std::memcpy(packet.hash, buf + offset, SHA256_DIGEST_LENGTH);
-		offset += SHA256_DIGEST_LENGTH;
+    template<typename Packet>
+    bool ReadSchemaPacket(const uint8_t* buf, size_t len, Packet& packet) const {
+        if (len < 1) return false;
+        ReadStream stream(buf + 1, len - 1, frameReference.load());
+        if (!Serialize(stream, packet)) {
+            Debug::Error("Sockets") << "Malformed packet of type " << static_cast<int>(buf[0]) << ", len=" << len << "\n";
+            return false;
+        }
+        return true;
+    }
 
-		return packet;
-	}
+    // Encodes a packet in place, inside the datagram it will be sent in
+    template<typename Packet>
+    void SendSchemaPacket(HSteamNetConnection conn, uint8_t type, const Packet& packet, SendChannel channel) {
+        size_t len = MeasureSchemaPacket(packet);
+        if (len == 0) {
+            Debug::Error("Sockets") << "Packet of type " << static_cast<int>(type) << " does not fit its schema\n";
+            return;
+        }
 
+        batcher.Write(conn, len, channel, [&](uint8_t* buf) {
+            WriteSchemaPacket(buf, len, type, packet);
+        });
+    }
 
-    void BroadcastGameStart(HSteamNetConnection conn, int playerId) {
-        if (!sockets || conn == k_HSteamNetConnection_Invalid) return;
+    template<typename Packet>
+    void SendShared(const std::vector<HSteamNetConnection>& conns, uint8_t type, const Packet& packet, SendChannel channel) {
+        if (!transport || conns.empty()) return;
 
-        uint8_t buf[1 + 4];
-        buf[0] = PACKET_GAME_START;
-        uint32_t pid = hostToBigEndian32(playerId);
-        std::memcpy(buf + 1, &pid, sizeof(uint32_t));
+        if (conns.size() == 1) {
+            SendSchemaPacket(conns.front(), type, packet, channel);
+            return;
+        }
 
-        sockets->SendMessageToConnection(conn, buf, sizeof(buf), k_nSteamNetworkingSend_Reliable, nullptr);
-    }
+        size_t len = MeasureSchemaPacket(packet);
+        if (len == 0) return;
 
-    void AddConnectionToPollGroup(HSteamNetConnection conn) {
-        if (sockets && isServer && pollGroup != k_HSteamNetPollGroup_Invalid) {
-            if (!sockets->SetConnectionPollGroup(conn, pollGroup)) {
-                Debug::Error("Sockets") << "Warning: Failed to add connection to poll group\n";
-            }
+        MessageBuffer* shared = MessageBufferPool::Instance().Acquire(len);
+        WriteSchemaPacket(shared->Data(), len, type, packet);
+        for (HSteamNetConnection conn : conns) {
+            batcher.QueueShared(conn, shared, len, channel);
         }
+        shared->Release();
     }
 
-    HSteamListenSocket GetListenSocket() { return listenSocket; }
-    HSteamNetConnection GetConnectedConnection() { return connectedConnection; }
-    ISteamNetworkingSockets* GetSockets() { return sockets; }
-    HSteamNetPollGroup GetPollGroup() { return pollGroup; }
+    // Splits deltas into packets of at most MAX_DELTAS_PER_PACKET
+    bool SendDeltaParts(const std::vector<HSteamNetConnection>& conns, const DeltasUpdatePacket& packet) {
+        size_t count = packet.deltas.size();
+        size_t parts = std::max<size_t>(1, (count + MAX_DELTAS_PER_PACKET - 1) / MAX_DELTAS_PER_PACKET);
+        if (parts > static_cast<size_t>(MAX_DELTA_PARTS)) {
+            Debug::Error("Sockets") << "Cannot split " << count << " deltas into " << MAX_DELTA_PARTS << " packets\n";
+            return false;
+        }
 
-private:
-    void OnConnectionStateChanged(SteamNetConnectionStatusChangedCallback_t* pInfo) {
-        ConnectionEventType eventType = CONNECTION_STATE_NONE;
-
-        // Determine event type
-        switch (pInfo->m_info.m_eState) {
-        case k_ESteamNetworkingConnectionState_Connecting:
-            eventType = CONNECTION_STATE_CONNECTING;
-            break;
-        case k_ESteamNetworkingConnectionState_Connected:
-            eventType = CONNECTION_STATE_CONNECTED;
-            break;
-        case k_ESteamNetworkingConnectionState_ClosedByPeer:
-            eventType = CONNECTION_STATE_CLOSED_BY_PEER;
-            break;
-        case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
-            eventType = CONNECTION_STATE_PROBLEM_DETECTED;
-            break;
-        default:
-            eventType = CONNECTION_STATE_NONE;
-            break;
+        if (parts == 1) {
+            SendShared(conns, PACKET_DELTA_STATE_UPDATE, packet, CHANNEL_UNRELIABLE);
+            return true;
         }
 
-        // Notify callback listener
-        if (onConnectionStateChanged) {
-            onConnectionStateChanged(pInfo->m_hConn, eventType);
+        DeltasUpdatePacket part;
+        part.frame = packet.frame;
+        part.baseFrame = packet.baseFrame;
+        part.partCount = static_cast<int>(parts);
+        for (size_t i = 0; i < parts; i++) {
+            auto first = packet.deltas.begin() + i * MAX_DELTAS_PER_PACKET;
+            part.part = static_cast<int>(i);
+            part.deltas.assign(first, first + std::min<size_t>(MAX_DELTAS_PER_PACKET, count - i * MAX_DELTAS_PER_PACKET));
+            SendShared(conns, PACKET_DELTA_STATE_UPDATE, part, CHANNEL_UNRELIABLE);
         }
+        return true;
+    }
 
-        // Server-side: accept connecting clients
-        if (isServer) {
-            switch (pInfo->m_info.m_eState) {
-            case k_ESteamNetworkingConnectionState_Connecting:
-                Debug::Info("Sockets") << "New connection attempt from " << pInfo->m_info.m_szConnectionDescription << "\n";
-                if (sockets->AcceptConnection(pInfo->m_hConn) == k_EResultOK) {
-                    Debug::Info("Sockets") << "Connection accepted, waiting to add to poll group...\n";
-                }
-                else {
-                    Debug::Error("Sockets") << "Failed to accept connection\n";
-                    sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
-                }
-                break;
+    // Bypasses the batcher and hands the packet to the transport straight away
+    template<typename Packet>
+    void SendSchemaPacketNow(HSteamNetConnection conn, uint8_t type, const Packet& packet, SendChannel channel) {
+        size_t len = MeasureSchemaPacket(packet);
+        if (len == 0) return;
 
-            case k_ESteamNetworkingConnectionState_Connected:
-                Debug::Info("Sockets") << "Connection now established, adding to poll group\n";
-                if (!sockets->SetConnectionPollGroup(pInfo->m_hConn, pollGroup)) {
-                    Debug::Error("Sockets") << "Failed to set poll group\n";
-                    sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
-                }
-                break;
+        MessageBuffer* buffer = MessageBufferPool::Instance().Acquire(len);
+        WriteSchemaPacket(buffer->Data(), len, type, packet);
 
-            case k_ESteamNetworkingConnectionState_ClosedByPeer:
-                Debug::Info("Sockets") << "Connection closed by peer: " << pInfo->m_info.m_szEndDebug << "\n";
-                sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
-                break;
+        OutgoingDatagram datagram;
+        datagram.conn = conn;
+        datagram.buffer = buffer;
+        datagram.len = len;
+        datagram.channel = channel;
+        transport->Send(&datagram, 1);
+        buffer->Release();
 
-            case k_ESteamNetworkingConnectionState_ProblemDetectedLocally:
-                Debug::Error("Sockets") << "Connection problem detected locally: " << pInfo->m_info.m_szEndDebug << "\n";
-                sockets->CloseConnection(pInfo->m_hConn, 0, nullptr, false);
-                break;
-
-            default:
-                break;
-            }
-        }
+        bytesSent.fetch_add(len);
     }
 
-    static void SteamNetConnectionStatusChangedCallback(SteamNetConnectionStatusChangedCallback_t* pInfo) {
-        if (s_pInstance) {
-            s_pInstance->OnConnectionStateChanged(pInfo);
-        }
+    void SendFrameAck(HSteamNetConnection conn, uint8_t type, int frame) {
+        if (!transport || conn == k_HSteamNetConnection_Invalid) return;
+
+        FrameAckPacket packet;
+        packet.frame = frame;
+        SendSchemaPacket(conn, type, packet, CHANNEL_UNRELIABLE);
     }
 
     void Shutdown() {
-        if (sockets) {
-            if (pollGroup != k_HSteamNetPollGroup_Invalid) {
-                sockets->DestroyPollGroup(pollGroup);
-                pollGroup = k_HSteamNetPollGroup_Invalid;
-            }
-            if (listenSocket != k_HSteamListenSocket_Invalid) {
-                sockets->CloseListenSocket(listenSocket);
-                listenSocket = k_HSteamListenSocket_Invalid;
-            }
+        if (!transport) {
+            return;
+        }
+
+        if (ownsTransport) {
             if (connectedConnection != k_HSteamNetConnection_Invalid) {
-                sockets->CloseConnection(connectedConnection, k_ESteamNetConnectionEnd_App_Generic, nullptr, false);
+                transport->CloseConnection(connectedConnection, false);
                 connectedConnection = k_HSteamNetConnection_Invalid;
             }
+            transport->Shutdown();
         }
-
-        if (socketsInitialized) {
-            GameNetworkingSockets_Kill();
-            socketsInitialized = false;  // reset static flag
-        }
+        transport.reset();
     }
 
 
-    ISteamNetworkingSockets* sockets;
-    HSteamListenSocket listenSocket;
-    HSteamNetPollGroup pollGroup;
-    HSteamNetConnection connectedConnection;
-    bool isServer;
-    ConnectionCallback onConnectionStateChanged;
-
-    static GNSSession* s_pInstance;
-
-    static inline bool socketsInitialized = false;
+    std::shared_ptr<ITransport> transport;
+    HSteamNetConnection connectedConnection = k_HSteamNetConnection_Invalid;
+    bool isServer = false;
+    PacketBatcher batcher;
+    FragmentAssembler fragments;        // Only touched by the receiving thread
+    std::atomic<int> frameReference{ 0 };
+    NetworkWaitConfig waitConfig;
+    int idleRounds = 0;
+    bool ownsTransport = true;        // False for views made by AttachTo
+    std::atomic<uint64_t> bytesSent{ 0 };
+    std::atomic<uint64_t> bytesReceived{ 0 };
 };
 
-GNSSession* GNSSession::s_pInstance = nullptr;
-
 
 #endif // GNS_SESSION_H
\ No newline at end of file